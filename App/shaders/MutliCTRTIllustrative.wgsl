@@ -1,3 +1,6 @@
+// Ray marching loop skips empty bricks and terminates early, so sampling is not in uniform control flow (volumes have a single mip level)
+diagnostic(off, derivative_uniformity);
+
 struct Fragment
 {
 	@builtin(position) position: vec4f,
@@ -46,6 +49,7 @@ struct Ray
 @group(0) @binding(9) var<uniform> clipZ: vec2<f32>;
 @group(0) @binding(10) var<uniform> toggles: vec4<i32>;
 @group(0) @binding(11) var texRayEnd: texture_2d<f32>;
+@group(0) @binding(12) var<uniform> opacityThreshold: f32;
 
 @group(1) @binding(0) var textureCT: texture_3d<f32>;
 @group(1) @binding(1) var textureRT: texture_3d<f32>;
@@ -54,7 +58,12 @@ struct Ray
 @group(1) @binding(4) var tfOpacityRT: texture_1d<f32>;
 @group(1) @binding(5) var tfColorRT: texture_1d<f32>;
 @group(1) @binding(6) var<uniform> light: LightData;
-// @group(1) @binding(7) var textureMask: texture_3d<f32>;
+@group(1) @binding(7) var textureGradientCT: texture_3d<f32>;
+@group(1) @binding(8) var texOccupancy: texture_3d<f32>;
+// @group(1) @binding(9) var textureMask: texture_3d<f32>;
+
+// Has to match MinMaxBrickGrid::kDefaultBrickSize
+const BRICK_SIZE: i32 = 8;
 
 
 @vertex
@@ -76,17 +85,22 @@ fn vs_main(@builtin(vertex_index) vID: u32, @location(0) vertexCoord: vec3f, @lo
 // UTIL
 
 /*
-* Checks whether the position is within out bbox basically,
-* but our bbox coordinates are basically 3D texture coordinates
+* Intersects the ray with the clip box, our bbox coordinates are basically 3D texture coordinates
+* @return distances along the ray where it enters (x) and leaves (y) the box, bounded by the ray itself, the ray misses the box if x > y
 */
-fn IsInSampleCoords(position: vec3<f32>) -> bool
+fn ClipRay(ray: Ray) -> vec2<f32>
 {
-	var b_min: vec3<f32> = vec3<f32>(0.0 + clipX.x, 0.0 + clipY.x, 0.0 + clipZ.x);
-	var b_max: vec3<f32> = vec3<f32>(1.0 - clipX.y, 1.0 - clipY.y, 1.0 - clipZ.y);
+	let b_min: vec3<f32> = vec3<f32>(0.0 + clipX.x, 0.0 + clipY.x, 0.0 + clipZ.x);
+	let b_max: vec3<f32> = vec3<f32>(1.0 - clipX.y, 1.0 - clipY.y, 1.0 - clipZ.y);
+
+	// Avoid division by zero for rays parallel to a face
+	let direction: vec3<f32> = select(ray.direction, vec3<f32>(1e-8), abs(ray.direction) < vec3<f32>(1e-8));
+	let t0: vec3<f32> = (b_min - ray.start) / direction;
+	let t1: vec3<f32> = (b_max - ray.start) / direction;
+	let tNear: vec3<f32> = min(t0, t1);
+	let tFar: vec3<f32> = max(t0, t1);
 
-	return	position.x >= b_min.x && position.x <= b_max.x &&
-			position.y >= b_min.y && position.y <= b_max.y &&
-			position.z >= b_min.z && position.z <= b_max.z;
+	return vec2<f32>(max(max(tNear.x, tNear.y), max(tNear.z, 0.0)), min(min(tFar.x, tFar.y), min(tFar.z, ray.length)));
 }
 
 
@@ -252,11 +266,13 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 
  	// Position on the cubes surface in uvw format <[0,0,0], [1,1,1]>
 	var currentPosition: vec3<f32> = ray.start.xyz;
+	// Distance of the first sample from the ray start
+	var firstSample: f32 = 0.0;
 
 	if toggles[1] == 1
 	{
 		// apply jitter using screen space coordinates, we could divide it (jitter input) by resolution to keep it same across all res.
-		currentPosition = currentPosition + ray.direction * stepSize * jitter(in.position.xy);
+		firstSample = stepSize * jitter(in.position.xy);
 	}
 
 	var step: vec3<f32> = ray.direction * stepSize;
@@ -268,20 +284,43 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 	// Resulting pixel color
 	var dst: vec4<f32> = vec4<f32>(0.0);
 
-	for (var i: i32 = 0; i < stepsCount; i++)
+	// Samples stay on the grid firstSample + k * stepSize, only the part of the ray within the clip box is marched
+	let clip: vec2<f32> = ClipRay(ray);
+	var i: i32 = clamp(i32(ceil((clip.x - firstSample) / stepSize)), 0, stepsCount);
+	currentPosition = currentPosition + ray.direction * firstSample + step * f32(i);
+	wordlCoords = wordlCoords + worldStep * f32(i);
+
+	let volumeSize: vec3f = vec3f(textureDimensions(textureCT));
+	let gridSize: vec3i = vec3i(textureDimensions(texOccupancy));
+
+	for (; i < stepsCount; i++)
 	{
+		// Ray left the clip box or the accumulated opacity reached the threshold
+		if firstSample + f32(i) * stepSize > clip.y || dst.a >= opacityThreshold
+		{
+			break;
+		}
+
+		// Empty space skipping, every density within the brick maps to zero opacity
+		let brick: vec3i = BrickAt(currentPosition, volumeSize, gridSize);
+		if textureLoad(texOccupancy, brick, 0).r == 0.0
+		{
+			let skip: i32 = StepsToBrickExit(currentPosition, step, brick, volumeSize);
+			currentPosition = currentPosition + step * f32(skip);
+			wordlCoords = wordlCoords + worldStep * f32(skip);
+			i += skip - 1;
+			continue;
+		}
+
 		// Volume sampling
-		var ctVolume: vec4f = textureSample(textureCT, samplerLin, currentPosition);
-		var rtVolume: vec4f = textureSample(textureRT, samplerLin, currentPosition);
+		var densityCT: f32 = textureSample(textureCT, samplerLin, currentPosition).r;
+		var densityRT: f32 = textureSample(textureRT, samplerLin, currentPosition).r;
 		// var maskVol: vec4f = textureSample(textureMask, samplerLin, currentPosition);
 
 		// When working with gradients, we need to be careful whether we initiated pre-calculation in OnStart
-		var gradient: vec3f = ctVolume.rgb;
+		var gradient: vec3f = DecodeGradient(textureSample(textureGradientCT, samplerLin, currentPosition));
 		// gradient = ComputeGradient(currentPosition, stepSize, textureCT);
 
-		var densityCT: f32 = ctVolume.a;
-		var densityRT: f32 = rtVolume.a;
-
 		// Transfer function sampling
 		var opacityCT: f32 = textureSample(tfOpacityCT, samplerLin, densityCT).r;
 		var colorCT: vec3f = textureSample(tfColorCT, samplerLin, densityCT).rgb;
@@ -289,20 +328,17 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 		var opacityRT: f32 = textureSample(tfOpacityRT, samplerLin, densityRT).r;
 		var colorRT: vec3f = textureSample(tfColorRT, samplerLin, densityRT).rgb;
 		
-		if IsInSampleCoords(currentPosition) && dst.a <= 0.95
-		{            
-            // Colors
-            var color: vec3f = colorCT * (1.0 - opacityRT) + colorRT * opacityRT;
-
-			color *= BlinnPhong(normalize(gradient), wordlCoords);
-            // Opacities
-			// var opacity = opacityCT;
-            var opacity: f32 = IllustrativeContextPreservingOpacity(opacityCT, gradient, wordlCoords, currentPosition, normFactorIllustrative, dst.a, ray.start);
-
-            // Blending
-		    var src: vec4<f32> = vec4f(color.r, color.g, color.b, opacity);
-        	dst = FrontToBackBlend(src, dst); 
-		}
+		// Colors
+		var color: vec3f = colorCT * (1.0 - opacityRT) + colorRT * opacityRT;
+
+		color *= BlinnPhong(normalize(gradient), wordlCoords);
+		// Opacities
+		// var opacity = opacityCT;
+		var opacity: f32 = IllustrativeContextPreservingOpacity(opacityCT, gradient, wordlCoords, currentPosition, normFactorIllustrative, dst.a, ray.start);
+
+		// Blending
+		var src: vec4<f32> = vec4f(color.r, color.g, color.b, opacity);
+		dst = FrontToBackBlend(src, dst); 
 
 		// Advance ray
 		currentPosition = currentPosition + step;
@@ -318,9 +354,9 @@ fn ComputeGradient(position: vec3<f32>, step: f32, texture: texture_3d<f32>) ->
 {
 	var result = vec3f(0.0, 0.0, 0.0);
 	var dirs = array<vec3f, 3>(vec3f(1.0, 0.0, 0.0), vec3f(0.0, 1.0, 0.0), vec3f(0.0, 0.0, 1.0));
-	result.x = textureSample(texture, samplerLin, position + dirs[0] * step).a - textureSample(texture, samplerLin, position - dirs[0] * step).a;
-	result.y = textureSample(texture, samplerLin, position + dirs[1] * step).a - textureSample(texture, samplerLin, position - dirs[1] * step).a;
-	result.z = textureSample(texture, samplerLin, position + dirs[2] * step).a - textureSample(texture, samplerLin, position - dirs[2] * step).a;
+	result.x = textureSample(texture, samplerLin, position + dirs[0] * step).r - textureSample(texture, samplerLin, position - dirs[0] * step).r;
+	result.y = textureSample(texture, samplerLin, position + dirs[1] * step).r - textureSample(texture, samplerLin, position - dirs[1] * step).r;
+	result.z = textureSample(texture, samplerLin, position + dirs[2] * step).r - textureSample(texture, samplerLin, position - dirs[2] * step).r;
 	let l = length(result);
 	if l == 0.0
 	{
@@ -337,4 +373,43 @@ fn ComputeGradient(position: vec3<f32>, step: f32, texture: texture_3d<f32>) ->
 fn GetStepSize(ray_length: f32, samples: i32) -> f32
 {
 	return ray_length / f32(samples);
+}
+
+/*
+* Decodes packed gradient texel (rg - octahedral direction, b - magnitude relative to the largest one in the volume)
+*/
+fn DecodeGradient(encoded: vec4f) -> vec3f
+{
+	var n: vec3f = vec3f(encoded.x, encoded.y, 1.0 - abs(encoded.x) - abs(encoded.y));
+	let t: f32 = max(-n.z, 0.0);
+	n.x += select(t, -t, n.x >= 0.0);
+	n.y += select(t, -t, n.y >= 0.0);
+	let l = length(n);
+	if l == 0.0
+	{
+		return vec3f(0.0);
+	}
+
+	return n / l * encoded.z;
+}
+
+/*
+* Brick of the min-max grid (MinMaxBrickGrid) that contains the position given in texture coordinates
+*/
+fn BrickAt(position: vec3f, volumeSize: vec3f, gridSize: vec3i) -> vec3i
+{
+	return clamp(vec3i(floor(position * volumeSize)) / BRICK_SIZE, vec3i(0), gridSize - 1);
+}
+
+/*
+* Number of steps after which the ray leaves the brick, steps stay on the same sampling grid
+*/
+fn StepsToBrickExit(position: vec3f, step: vec3f, brick: vec3i, volumeSize: vec3f) -> i32
+{
+	let lo: vec3f = vec3f(brick * BRICK_SIZE) / volumeSize;
+	let hi: vec3f = vec3f((brick + 1) * BRICK_SIZE) / volumeSize;
+	let bound: vec3f = select(lo, hi, step > vec3f(0.0));
+	let moving: vec3<bool> = abs(step) > vec3f(1e-9);
+	let t: vec3f = select(vec3f(1e9), (bound - position) / select(vec3f(1.0), step, moving), moving);
+	return max(i32(floor(min(t.x, min(t.y, t.z)))) + 1, 1);
 }
\ No newline at end of file
@@ -1,3 +1,6 @@
+// Ray marching loop terminates early, so sampling is not in uniform control flow (volumes have a single mip level)
+diagnostic(off, derivative_uniformity);
+
 struct Fragment
 {
 	@builtin(position) position: vec4f,
@@ -35,10 +38,11 @@ struct Ray
 @group(0) @binding(9) var<uniform> clipZ: vec2<f32>;
 @group(0) @binding(10) var<uniform> toggles: vec4<i32>;
 @group(0) @binding(11) var texRayEnd: texture_2d<f32>;
+@group(0) @binding(12) var<uniform> opacityThreshold: f32;
 
 // App
 @group(1) @binding(0) var textMain: texture_3d<f32>;
-@group(1) @binding(1) var textMask: texture_3d<f32>;
+@group(1) @binding(1) var textMask: texture_3d<u32>;
 @group(1) @binding(2) var tfOpacity: texture_1d<f32>;
 @group(1) @binding(3) var tfColor: texture_1d<f32>;
 
@@ -66,17 +70,22 @@ fn GetStepSize(rayLength: f32, samples: i32) -> f32
 }
 
 /*
-* Checks whether the position is within out bbox basically,
-* but our bbox coordinates are basically 3D texture coordinates
+* Intersects the ray with the clip box, our bbox coordinates are basically 3D texture coordinates
+* @return distances along the ray where it enters (x) and leaves (y) the box, bounded by the ray itself, the ray misses the box if x > y
 */
-fn IsInSampleCoords(position: vec3<f32>) -> bool
+fn ClipRay(ray: Ray) -> vec2<f32>
 {
-	var b_min: vec3<f32> = vec3<f32>(0.0 + clipX.x, 0.0 + clipY.x, 0.0 + clipZ.x);
-	var b_max: vec3<f32> = vec3<f32>(1.0 - clipX.y, 1.0 - clipY.y, 1.0 - clipZ.y);
+	let b_min: vec3<f32> = vec3<f32>(0.0 + clipX.x, 0.0 + clipY.x, 0.0 + clipZ.x);
+	let b_max: vec3<f32> = vec3<f32>(1.0 - clipX.y, 1.0 - clipY.y, 1.0 - clipZ.y);
+
+	// Avoid division by zero for rays parallel to a face
+	let direction: vec3<f32> = select(ray.direction, vec3<f32>(1e-8), abs(ray.direction) < vec3<f32>(1e-8));
+	let t0: vec3<f32> = (b_min - ray.start) / direction;
+	let t1: vec3<f32> = (b_max - ray.start) / direction;
+	let tNear: vec3<f32> = min(t0, t1);
+	let tFar: vec3<f32> = max(t0, t1);
 
-	return	position.x >= b_min.x && position.x <= b_max.x &&
-			position.y >= b_min.y && position.y <= b_max.y &&
-			position.z >= b_min.z && position.z <= b_max.z;
+	return vec2<f32>(max(max(tNear.x, tNear.y), max(tNear.z, 0.0)), min(min(tFar.x, tFar.y), min(tFar.z, ray.length)));
 }
 
 /*
@@ -153,11 +162,13 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 
  	// Position on the cubes surface in uvw format <[0,0,0], [1,1,1]>
 	var currentPosition: vec3<f32> = ray.start.xyz;
+	// Distance of the first sample from the ray start
+	var firstSample: f32 = 0.0;
 
 	if toggles[1] == 1
 	{
 		// apply jitter using screen space coordinates, we could divide it (jitter input) by resolution to keep it same across all res.
-		currentPosition = currentPosition + ray.direction * stepSize * jitter(in.position.xy);
+		firstSample = stepSize * jitter(in.position.xy);
 	}
 
 	var step: vec3<f32> = ray.direction * stepSize;
@@ -165,29 +176,35 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 	// Resulting pixel color
 	var dst: vec4<f32> = vec4<f32>(0.0);
 
-	for (var i: i32 = 0; i < stepsCount; i++)
+	// Samples stay on the grid firstSample + k * stepSize, only the part of the ray within the clip box is marched
+	let clip: vec2<f32> = ClipRay(ray);
+	var i: i32 = clamp(i32(ceil((clip.x - firstSample) / stepSize)), 0, stepsCount);
+	currentPosition = currentPosition + ray.direction * firstSample + step * f32(i);
+
+	for (; i < stepsCount; i++)
 	{
-		// Volume sampling
-		var volumeSample: vec4f = textureSample(textMain, samplerLin, currentPosition);
-		var maskSample: vec4f = textureSample(textMask, samplerNN, currentPosition);
+		// Ray left the clip box or the accumulated opacity reached the threshold
+		if firstSample + f32(i) * stepSize > clip.y || dst.a >= opacityThreshold
+		{
+			break;
+		}
 
-		var density: f32 = volumeSample.a;
+		// Volume sampling
+		var density: f32 = textureSample(textMain, samplerLin, currentPosition).r;
+		var maskLabels: u32 = LoadMaskLabels(textMask, currentPosition);
 
 		// Transfer function sampling
 		var opacity: f32 = textureSample(tfOpacity, samplerLin, density).r;
 		var color: vec3f = textureSample(tfColor, samplerLin, density).rgb;
 
-		if maskSample.r > 0
+		if (maskLabels & 1u) != 0u
 		{
 			color = vec3f(1.0, 1.0, 0.0);
 			opacity = 0.1;
 		}
 		
-		if IsInSampleCoords(currentPosition) && dst.a <= 0.95
-		{
-			// Blending
-			dst = FrontToBackBlend(vec4f(color.r, color.g, color.b, opacity), dst); 
-		}
+		// Blending
+		dst = FrontToBackBlend(vec4f(color.r, color.g, color.b, opacity), dst); 
 
 		// Advance ray
 		currentPosition = currentPosition + step;
@@ -196,3 +213,11 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 	return dst;
 }
 
+/*
+* ROI labels of the voxel nearest to the position, bit r is set when ROI r contains the voxel (see MaskVolume::WriteLabelTexels)
+*/
+fn LoadMaskLabels(mask: texture_3d<u32>, position: vec3f) -> u32
+{
+	let size: vec3i = vec3i(textureDimensions(mask));
+	return textureLoad(mask, clamp(vec3i(position * vec3f(size)), vec3i(0), size - 1), 0).r;
+}
@@ -1,3 +1,6 @@
+// Ray marching loop terminates early, so sampling is not in uniform control flow (volumes have a single mip level)
+diagnostic(off, derivative_uniformity);
+
 struct Fragment
 {
 	@builtin(position) position: vec4f,
@@ -46,10 +49,11 @@ struct Ray
 @group(0) @binding(9) var<uniform> clipZ: vec2<f32>;
 @group(0) @binding(10) var<uniform> toggles: vec4<i32>;
 @group(0) @binding(11) var texRayEnd: texture_2d<f32>;
+@group(0) @binding(12) var<uniform> opacityThreshold: f32;
 
 @group(1) @binding(0) var textureCT: texture_3d<f32>;
 @group(1) @binding(1) var textureRT: texture_3d<f32>;
-@group(1) @binding(2) var textureMask: texture_3d<f32>;
+@group(1) @binding(2) var textureMask: texture_3d<u32>;
 @group(1) @binding(3) var tfOpacityCT: texture_1d<f32>;
 @group(1) @binding(4) var tfColorCT: texture_1d<f32>;
 @group(1) @binding(5) var tfOpacityRT: texture_1d<f32>;
@@ -74,17 +78,22 @@ fn vs_main(@builtin(vertex_index) vID: u32, @location(0) vertexCoord: vec3f, @lo
 
 
 /*
-* Checks whether the position is within out bbox basically,
-* but our bbox coordinates are basically 3D texture coordinates
+* Intersects the ray with the clip box, our bbox coordinates are basically 3D texture coordinates
+* @return distances along the ray where it enters (x) and leaves (y) the box, bounded by the ray itself, the ray misses the box if x > y
 */
-fn IsInSampleCoords(position: vec3<f32>) -> bool
+fn ClipRay(ray: Ray) -> vec2<f32>
 {
-	var b_min: vec3<f32> = vec3<f32>(0.0 + clipX.x, 0.0 + clipY.x, 0.0 + clipZ.x);
-	var b_max: vec3<f32> = vec3<f32>(1.0 - clipX.y, 1.0 - clipY.y, 1.0 - clipZ.y);
+	let b_min: vec3<f32> = vec3<f32>(0.0 + clipX.x, 0.0 + clipY.x, 0.0 + clipZ.x);
+	let b_max: vec3<f32> = vec3<f32>(1.0 - clipX.y, 1.0 - clipY.y, 1.0 - clipZ.y);
+
+	// Avoid division by zero for rays parallel to a face
+	let direction: vec3<f32> = select(ray.direction, vec3<f32>(1e-8), abs(ray.direction) < vec3<f32>(1e-8));
+	let t0: vec3<f32> = (b_min - ray.start) / direction;
+	let t1: vec3<f32> = (b_max - ray.start) / direction;
+	let tNear: vec3<f32> = min(t0, t1);
+	let tFar: vec3<f32> = max(t0, t1);
 
-	return	position.x >= b_min.x && position.x <= b_max.x &&
-			position.y >= b_min.y && position.y <= b_max.y &&
-			position.z >= b_min.z && position.z <= b_max.z;
+	return vec2<f32>(max(max(tNear.x, tNear.y), max(tNear.z, 0.0)), min(min(tFar.x, tFar.y), min(tFar.z, ray.length)));
 }
 
 
@@ -209,11 +218,13 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 
  	// Position on the cubes surface in uvw format <[0,0,0], [1,1,1]>
 	var currentPosition: vec3<f32> = ray.start.xyz;
+	// Distance of the first sample from the ray start
+	var firstSample: f32 = 0.0;
 
 	if toggles[1] == 1
 	{
 		// apply jitter using screen space coordinates, we could divide it (jitter input) by resolution to keep it same across all res.
-		currentPosition = currentPosition + ray.direction * stepSize * jitter(in.position.xy);
+		firstSample = stepSize * jitter(in.position.xy);
 	}
 
 	var step: vec3<f32> = ray.direction * stepSize;
@@ -221,17 +232,28 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 	// Resulting pixel color
 	var dst: vec4<f32> = vec4<f32>(0.0);
 
-	for (var i: i32 = 0; i < stepsCount; i++)
+	// Samples stay on the grid firstSample + k * stepSize, only the part of the ray within the clip box is marched
+	let clip: vec2<f32> = ClipRay(ray);
+	var i: i32 = clamp(i32(ceil((clip.x - firstSample) / stepSize)), 0, stepsCount);
+	currentPosition = currentPosition + ray.direction * firstSample + step * f32(i);
+	wordlCoords = wordlCoords + step * f32(i);
+
+	for (; i < stepsCount; i++)
 	{
+		// Ray left the clip box or the accumulated opacity reached the threshold
+		if firstSample + f32(i) * stepSize > clip.y || dst.a >= opacityThreshold
+		{
+			break;
+		}
+
 		// Volume sampling
-		var ctVolume: vec4f = textureSample(textureCT, samplerLin, currentPosition);
-		var rtVolume: vec4f = textureSample(textureRT, samplerLin, currentPosition);
-		// var maskVol: vec4f = textureSample(textureMask, samplerLin, currentPosition);
+		var densityCT: f32 = textureSample(textureCT, samplerLin, currentPosition).r;
+		var densityRT: f32 = textureSample(textureRT, samplerLin, currentPosition).r;
+		// var maskLabels: u32 = textureLoad(textureMask, vec3i(currentPosition * vec3f(textureDimensions(textureMask))), 0).r;
 
 		// When working with gradients, we need to be careful whether we initiated pre-calculation in OnStart
-		var gradient: vec3f = ctVolume.rgb;
-		var densityCT: f32 = ctVolume.a;
-		var densityRT: f32 = rtVolume.a;
+		// No gradient texture is bound, see ComputeGradient
+		var gradient: vec3f = vec3f(0.0);
 
 		// Transfer function sampling
 		var opacityCT: f32 = textureSample(tfOpacityCT, samplerLin, densityCT).r;
@@ -240,28 +262,23 @@ fn fs_main(in: Fragment) -> @location(0) vec4<f32>
 		var opacityRT: f32 = textureSample(tfOpacityRT, samplerLin, densityRT).r;
 		var colorRT: vec3f = textureSample(tfColorRT, samplerLin, densityRT).rgb;
 		
-		if IsInSampleCoords(currentPosition) && dst.a < 1.0
-		{            
-            // Colors
-            var color: vec3f = colorCT * (1.0 - opacityRT) + colorRT * opacityRT;
-            var opacity: f32 = opacityCT;
-            // var maskV: f32 = maskVol.r;
-
-            // if maskV > 0
-            // {
-            //     color = vec3f(1, 0.5, 0.5);
-            //     opacity = 1;
-            // }
-
-            // Opacities
-            // var opacity: f32 = GradinetMagnitudeOpacityModulation(opacityCT, gradient);
-            // var opacity: f32 = IllustrativeContextPreservingOpacity(opacityCT, gradient, wordlCoords, currentPosition, ray.start, dst.a);
-
-            // Blending
-		    var src: vec4<f32> = vec4f(color.r, color.g, color.b, opacity);
-		
-        	dst = FrontToBackBlend(src, dst); 
-		}
+		// Colors
+		var color: vec3f = colorCT * (1.0 - opacityRT) + colorRT * opacityRT;
+		var opacity: f32 = opacityCT;
+		// if (maskLabels & 1u) != 0u
+		// {
+		//     color = vec3f(1, 0.5, 0.5);
+		//     opacity = 1;
+		// }
+
+		// Opacities
+		// var opacity: f32 = GradinetMagnitudeOpacityModulation(opacityCT, gradient);
+		// var opacity: f32 = IllustrativeContextPreservingOpacity(opacityCT, gradient, wordlCoords, currentPosition, ray.start, dst.a);
+
+		// Blending
+		var src: vec4<f32> = vec4f(color.r, color.g, color.b, opacity);
+
+		dst = FrontToBackBlend(src, dst); 
 
 		// Advance ray
 		currentPosition = currentPosition + step;
@@ -278,9 +295,9 @@ fn ComputeGradient(position: vec3<f32>, step: f32, texture: texture_3d<f32>) ->
 {
 	var result = vec3f(0.0, 0.0, 0.0);
 	var dirs = array<vec3f, 3>(vec3f(1.0, 0.0, 0.0), vec3f(0.0, 1.0, 0.0), vec3f(0.0, 0.0, 1.0));
-	result.x = textureSample(texture, samplerLin, position + dirs[0] * step).a - textureSample(texture, samplerLin, position - dirs[0] * step).a;
-	result.y = textureSample(texture, samplerLin, position + dirs[1] * step).a - textureSample(texture, samplerLin, position - dirs[1] * step).a;
-	result.z = textureSample(texture, samplerLin, position + dirs[2] * step).a - textureSample(texture, samplerLin, position - dirs[2] * step).a;
+	result.x = textureSample(texture, samplerLin, position + dirs[0] * step).r - textureSample(texture, samplerLin, position - dirs[0] * step).r;
+	result.y = textureSample(texture, samplerLin, position + dirs[1] * step).r - textureSample(texture, samplerLin, position - dirs[1] * step).r;
+	result.z = textureSample(texture, samplerLin, position + dirs[2] * step).r - textureSample(texture, samplerLin, position - dirs[2] * step).r;
 	let l = length(result);
 	if l == 0.0
 	{
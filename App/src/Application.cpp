@@ -83,6 +83,8 @@ namespace med {
 			m_StepsCount = p_App->GetStepsCount();
 		}
 
+		m_OpacityThreshold = p_App->GetOpacityThreshold();
+
 		/*auto [bx, by, bz] = p_App->GetBBoxSize();
 		if (bx != 0 && by != 0 && bz != 0)
 		{
@@ -109,6 +111,7 @@ namespace med {
 		p_UFragmentMode->UpdateBuffer(queue, 0, &m_FragmentMode, sizeOfInt);
 		p_UStepsCount->UpdateBuffer(queue, 0, &m_StepsCount, sizeOfInt);
 		p_UStepSize->UpdateBuffer(queue, 0, &m_StepSize, sizeOfFloat);
+		p_UOpacityThreshold->UpdateBuffer(queue, 0, &m_OpacityThreshold, sizeOfFloat);
 
 		p_UClipX->UpdateBuffer(queue, 0, glm::value_ptr(m_ClipsX), sizeof(glm::vec2));
 		p_UClipY->UpdateBuffer(queue, 0, glm::value_ptr(m_ClipsY), sizeof(glm::vec2));
@@ -247,6 +250,8 @@ namespace med {
 			ImGui::ListBox("##", &m_FragmentMode, m_FragModes, 5);
 			ImGui::SliderInt("Number of steps", &m_StepsCount, 0, 1500);
 			ImGui::SliderFloat("Step size", &m_StepSize, 0.0001f, 0.01f, "%.5f");
+			ImGui::SliderFloat("Opacity threshold", &m_OpacityThreshold, 0.5f, 1.0f, "%.3f");
+			ImGui::SetItemTooltip("Early ray termination, marching stops once the accumulated opacity reaches the threshold");
 		}
 
 		ImGui::SeparatorText("Clipping");
@@ -494,6 +499,7 @@ namespace med {
 		p_UFragmentMode = UniformBuffer::CreateFromData(device, queue, &m_FragmentMode, sizeof(int));
 		p_UStepsCount = UniformBuffer::CreateFromData(device, queue, &m_StepsCount, sizeof(int));
 		p_UStepSize = UniformBuffer::CreateFromData(device, queue, &m_StepSize, sizeof(float));
+		p_UOpacityThreshold = UniformBuffer::CreateFromData(device, queue, &m_OpacityThreshold, sizeof(float));
 
 		p_UClipX = UniformBuffer::CreateFromData(device, queue, glm::value_ptr(m_ClipsX), sizeof(glm::vec2));
 		p_UClipY = UniformBuffer::CreateFromData(device, queue, glm::value_ptr(m_ClipsY), sizeof(glm::vec2));
@@ -554,6 +560,7 @@ namespace med {
 		m_BGroupDefaultApp.AddBuffer(*p_UClipZ, WGPUShaderStage_Fragment);
 		m_BGroupDefaultApp.AddBuffer(*p_UToggles, WGPUShaderStage_Fragment);
 		m_BGroupDefaultApp.AddTexture(*p_TexEndPos, WGPUShaderStage_Fragment, WGPUTextureSampleType_UnfilterableFloat);
+		m_BGroupDefaultApp.AddBuffer(*p_UOpacityThreshold, WGPUShaderStage_Fragment);
 		m_BGroupDefaultApp.FinalizeBindGroup(base::GraphicsContext::GetDevice());
 
 		m_BGroupProxy = BindGroup();
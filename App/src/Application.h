@@ -127,6 +127,7 @@ namespace med {
 		std::shared_ptr<UniformBuffer> p_UFragmentMode = nullptr;
 		std::shared_ptr<UniformBuffer> p_UStepsCount = nullptr;
 		std::shared_ptr<UniformBuffer> p_UStepSize = nullptr;
+		std::shared_ptr<UniformBuffer> p_UOpacityThreshold = nullptr;
 
 		std::shared_ptr<RenderPipeline> p_RenderPipeline = nullptr;
 		std::shared_ptr<RenderPipeline> p_RenderPipelineEnd = nullptr;
@@ -175,6 +176,8 @@ namespace med {
 		int m_FragmentMode = 0;
 		int m_StepsCount = 200;
 		float m_StepSize = 0.01f;
+		// Ray marching terminates once the accumulated opacity reaches this value
+		float m_OpacityThreshold = 0.95f;
 		float m_FrameTime = 0.0f;
 		float m_Fps = 0.0;
 		float m_AverageFrametime = 0.0;
@@ -0,0 +1,84 @@
+#include "BinaryStream.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+namespace med
+{
+	namespace
+	{
+		std::size_t AlignUp(std::size_t offset, std::size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+	}
+
+	BinaryWriter::BinaryWriter(const std::filesystem::path& path) :
+		m_Stream(path, std::ios::binary | std::ios::trunc)
+	{
+	}
+
+	void BinaryWriter::Write(const void* data, std::size_t size)
+	{
+		m_Stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+		m_Offset += size;
+	}
+
+	void BinaryWriter::Write(const std::string& value)
+	{
+		Write(static_cast<std::uint32_t>(value.size()));
+		Write(value.data(), value.size());
+	}
+
+	void BinaryWriter::Align(std::size_t alignment)
+	{
+		assert(alignment > 0 && alignment <= kMaxAlignment && "Unsupported alignment");
+		static constexpr std::array<char, kMaxAlignment> zeros{};
+		Write(zeros.data(), AlignUp(m_Offset, alignment) - m_Offset);
+	}
+
+	bool BinaryWriter::IsGood() const
+	{
+		return m_Stream.good();
+	}
+
+	void BinaryWriter::Close()
+	{
+		m_Stream.close();
+	}
+
+	BinaryReader::BinaryReader(std::span<const std::byte> bytes) :
+		m_Bytes(bytes)
+	{
+	}
+
+	std::span<const std::byte> BinaryReader::Take(std::size_t size)
+	{
+		if (m_Failed || size > m_Bytes.size() - m_Offset)
+		{
+			m_Failed = true;
+			return {};
+		}
+		auto result = m_Bytes.subspan(m_Offset, size);
+		m_Offset += size;
+		return result;
+	}
+
+	std::string BinaryReader::ReadString()
+	{
+		const auto size = Read<std::uint32_t>();
+		auto bytes = Take(size);
+		return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	}
+
+	void BinaryReader::Align(std::size_t alignment)
+	{
+		Take(std::min(AlignUp(m_Offset, alignment), m_Bytes.size()) - m_Offset);
+	}
+
+	bool BinaryReader::HasFailed() const
+	{
+		return m_Failed;
+	}
+}
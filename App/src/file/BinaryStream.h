@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Sequential writer of binary files (caches, presets), values are written in native byte order.
+	 */
+	class BinaryWriter
+	{
+	public:
+		explicit BinaryWriter(const std::filesystem::path& path);
+
+		void Write(const void* data, std::size_t size);
+
+		template<typename T>
+		void Write(const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			Write(&value, sizeof(T));
+		}
+
+		/**
+		 * @brief Length (uint32) followed by the characters.
+		 */
+		void Write(const std::string& value);
+
+		/**
+		 * @brief Raw elements, count is written by the caller.
+		 */
+		template<typename T>
+		void WriteSpan(std::span<const T> values)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			Write(values.data(), values.size_bytes());
+		}
+
+		/**
+		 * @brief Pads with zeros up to the next multiple of alignment (at most kMaxAlignment).
+		 */
+		void Align(std::size_t alignment);
+
+		[[nodiscard]] bool IsGood() const;
+
+		void Close();
+
+	public:
+		static constexpr std::size_t kMaxAlignment = 64;
+
+	private:
+		std::ofstream m_Stream;
+		std::size_t m_Offset = 0;
+	};
+
+	/**
+	 * @brief Bounds checked reading of binary data (usually a mapped file), any read past the end marks the reader as failed
+	 * and returns zeros/empty values from then on, so the result is checked once at the end.
+	 */
+	class BinaryReader
+	{
+	public:
+		explicit BinaryReader(std::span<const std::byte> bytes);
+
+		std::span<const std::byte> Take(std::size_t size);
+
+		template<typename T>
+		T Read()
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			T value{};
+			if (auto bytes = Take(sizeof(T)); !bytes.empty())
+			{
+				std::memcpy(&value, bytes.data(), sizeof(T));
+			}
+			return value;
+		}
+
+		std::string ReadString();
+
+		/**
+		 * @brief count raw elements copied with a single memcpy, empty if there is not enough data.
+		 */
+		template<typename T>
+		std::vector<T> ReadVector(std::uint64_t count)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			std::vector<T> values{};
+
+			// Checked before the allocation, damaged count must not allocate
+			if (count > (m_Bytes.size() - m_Offset) / sizeof(T))
+			{
+				m_Failed = true;
+				return values;
+			}
+
+			const auto bytes = Take(static_cast<std::size_t>(count) * sizeof(T));
+			values.resize(static_cast<std::size_t>(count));
+			if (!bytes.empty())
+			{
+				std::memcpy(values.data(), bytes.data(), bytes.size());
+			}
+			return values;
+		}
+
+		void Align(std::size_t alignment);
+
+		[[nodiscard]] bool HasFailed() const;
+
+	private:
+		std::span<const std::byte> m_Bytes;
+		std::size_t m_Offset = 0;
+		bool m_Failed = false;
+	};
+}
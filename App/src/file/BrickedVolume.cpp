@@ -0,0 +1,168 @@
+#include "BrickedVolume.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+namespace med
+{
+	BrickedVolume::BrickedVolume(const VoxelBuffer& linear, Size size) : m_Size(size)
+	{
+		assert(linear.GetChannels() == 1 && "Bricked layout is built from single channel data");
+
+		const auto [xS, yS, zS] = size;
+		m_BricksX = (xS + kBrickMask) >> kBrickBits;
+		m_BricksY = (yS + kBrickMask) >> kBrickBits;
+		m_BricksZ = (zS + kBrickMask) >> kBrickBits;
+		const std::size_t brickCount = static_cast<std::size_t>(m_BricksX) * m_BricksY * m_BricksZ;
+
+		if (linear.IsEmpty() || brickCount == 0)
+		{
+			return;
+		}
+
+		m_Data = VoxelBuffer(linear.GetType(), brickCount * kBrickVoxels);
+		linear.Visit([&](auto src)
+		{
+			using T = std::remove_cvref_t<decltype(src[0])>;
+			const std::span<T> dst = m_Data.As<T>();
+
+			base::ThreadPool::Get().ParallelFor(0, brickCount, [&](std::size_t brick)
+			{
+				const std::uint32_t bx = static_cast<std::uint32_t>(brick % m_BricksX) << kBrickBits;
+				const std::uint32_t by = static_cast<std::uint32_t>(brick / m_BricksX % m_BricksY) << kBrickBits;
+				const std::uint32_t bz = static_cast<std::uint32_t>(brick / (static_cast<std::size_t>(m_BricksX) * m_BricksY)) << kBrickBits;
+				T* out = dst.data() + brick * kBrickVoxels;
+
+				// Padding replicates the last voxel along each axis
+				for (std::uint32_t z = 0; z < kBrickSize; ++z)
+				{
+					const std::size_t sz = std::min<std::uint32_t>(bz + z, zS - 1);
+					for (std::uint32_t y = 0; y < kBrickSize; ++y)
+					{
+						const T* row = src.data() + (sz * yS + std::min<std::uint32_t>(by + y, yS - 1)) * xS;
+						for (std::uint32_t x = 0; x < kBrickSize; ++x)
+						{
+							*out++ = row[std::min<std::uint32_t>(bx + x, xS - 1)];
+						}
+					}
+				}
+			});
+		});
+	}
+
+	VoxelBuffer BrickedVolume::ToLinear() const
+	{
+		const auto [xS, yS, zS] = m_Size;
+		if (m_Data.IsEmpty())
+		{
+			return {};
+		}
+
+		VoxelBuffer linear(m_Data.GetType(), static_cast<std::size_t>(xS) * yS * zS);
+		m_Data.Visit([&](auto src)
+		{
+			using T = std::remove_cvref_t<decltype(src[0])>;
+			const std::span<T> dst = linear.As<T>();
+
+			base::ThreadPool::Get().ParallelFor(0, zS, [&](std::size_t z)
+			{
+				for (std::uint32_t y = 0; y < yS; ++y)
+				{
+					T* row = dst.data() + (z * yS + y) * xS;
+					// Runs of kBrickSize voxels are contiguous in both layouts
+					for (std::uint32_t x = 0; x < xS; x += kBrickSize)
+					{
+						const T* run = src.data() + GetIndex(x, y, static_cast<std::uint32_t>(z));
+						std::copy_n(run, std::min<std::uint32_t>(kBrickSize, xS - x), row + x);
+					}
+				}
+			});
+		});
+
+		return linear;
+	}
+
+	float BrickedVolume::Sample(glm::vec3 position) const
+	{
+		return m_Data.Visit([&](auto data)
+		{
+			using T = std::remove_cvref_t<decltype(data[0])>;
+			return SampleImpl(std::span<const T>(data.data(), data.size()), position);
+		});
+	}
+
+	template<typename T>
+	float BrickedVolume::SampleImpl(std::span<const T> data, glm::vec3 position) const
+	{
+		if (data.empty())
+		{
+			return 0.0f;
+		}
+
+		const auto [xS, yS, zS] = m_Size;
+		const glm::vec3 coord = position * glm::vec3(xS, yS, zS) - glm::vec3(0.5f);
+		const glm::vec3 base = glm::floor(coord);
+		glm::vec3 t = coord - base;
+
+		// Below the volume both corners are the first voxel, same as t = 0, above it both are the last one
+		const auto clampAxis = [](float b, float& weight, int size)
+		{
+			if (b < 0.0f)
+			{
+				weight = 0.0f;
+				return 0u;
+			}
+			return static_cast<std::uint32_t>(std::min(static_cast<int>(b), size - 1));
+		};
+		const std::uint32_t x0 = clampAxis(base.x, t.x, xS);
+		const std::uint32_t y0 = clampAxis(base.y, t.y, yS);
+		const std::uint32_t z0 = clampAxis(base.z, t.z, zS);
+		const std::size_t index = GetIndex(x0, y0, z0);
+
+		std::array<float, 8> c;
+		if ((x0 & kBrickMask) < kBrickMask && (y0 & kBrickMask) < kBrickMask && (z0 & kBrickMask) < kBrickMask)
+		{
+			// Whole footprint within the brick, upper corners past the border read the replicated padding
+			constexpr std::size_t dy = kBrickSize;
+			constexpr std::size_t dz = kBrickSize * kBrickSize;
+			const T* v = data.data() + index;
+			c = { static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[dy]), static_cast<float>(v[dy + 1]),
+				static_cast<float>(v[dz]), static_cast<float>(v[dz + 1]), static_cast<float>(v[dz + dy]), static_cast<float>(v[dz + dy + 1]) };
+		}
+		else
+		{
+			const std::uint32_t x1 = std::min<std::uint32_t>(x0 + 1, xS - 1);
+			const std::uint32_t y1 = std::min<std::uint32_t>(y0 + 1, yS - 1);
+			const std::uint32_t z1 = std::min<std::uint32_t>(z0 + 1, zS - 1);
+			c = { static_cast<float>(data[index]), static_cast<float>(data[GetIndex(x1, y0, z0)]),
+				static_cast<float>(data[GetIndex(x0, y1, z0)]), static_cast<float>(data[GetIndex(x1, y1, z0)]),
+				static_cast<float>(data[GetIndex(x0, y0, z1)]), static_cast<float>(data[GetIndex(x1, y0, z1)]),
+				static_cast<float>(data[GetIndex(x0, y1, z1)]), static_cast<float>(data[GetIndex(x1, y1, z1)]) };
+		}
+
+		const float c00 = glm::mix(c[0], c[1], t.x);
+		const float c10 = glm::mix(c[2], c[3], t.x);
+		const float c01 = glm::mix(c[4], c[5], t.x);
+		const float c11 = glm::mix(c[6], c[7], t.x);
+		return glm::mix(glm::mix(c00, c10, t.y), glm::mix(c01, c11, t.y), t.z);
+	}
+
+	BrickedVolume::Size BrickedVolume::GetSize() const
+	{
+		return m_Size;
+	}
+
+	glm::uvec3 BrickedVolume::GetBrickCounts() const
+	{
+		return { m_BricksX, m_BricksY, m_BricksZ };
+	}
+
+	bool BrickedVolume::IsEmpty() const
+	{
+		return m_Data.IsEmpty();
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "VoxelBuffer.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <utility>
+
+namespace med
+{
+	/**
+	 * @brief Single channel density reordered into kBrickSize^3 bricks (bricks and voxels within a brick are x fastest),
+	 * so voxels that are close in 3D are close in memory no matter the axis. Native type is kept (see VoxelBuffer).
+	 * Bricks at the upper borders are padded by replicating the last voxel, reads stay inside of the brick (clamp to edge).
+	 * Linear layout is still needed for the GPU upload, see ToLinear.
+	 */
+	class BrickedVolume
+	{
+	public:
+		using Size = std::tuple<std::uint16_t, std::uint16_t, std::uint16_t>;
+
+		static constexpr std::uint32_t kBrickBits = 3;
+		static constexpr std::uint32_t kBrickSize = 1u << kBrickBits;
+		static constexpr std::uint32_t kBrickMask = kBrickSize - 1;
+		static constexpr std::uint32_t kBrickVoxels = kBrickSize * kBrickSize * kBrickSize;
+
+		BrickedVolume() = default;
+
+		/**
+		 * @brief Reorders linear (row-major) density, bricks are filled in parallel.
+		 */
+		BrickedVolume(const VoxelBuffer& linear, Size size);
+
+		/**
+		 * @brief Row-major copy of the density, same as the buffer the volume was built from.
+		 */
+		[[nodiscard]] VoxelBuffer ToLinear() const;
+
+		/**
+		 * @brief Index of the voxel within the bricked buffer, coordinates have to be inside of the volume.
+		 */
+		[[nodiscard]] std::size_t GetIndex(std::uint32_t x, std::uint32_t y, std::uint32_t z) const
+		{
+			const std::size_t brick = (static_cast<std::size_t>(z >> kBrickBits) * m_BricksY + (y >> kBrickBits)) * m_BricksX + (x >> kBrickBits);
+			return (brick << (3 * kBrickBits)) | ((z & kBrickMask) << (2 * kBrickBits)) | ((y & kBrickMask) << kBrickBits) | (x & kBrickMask);
+		}
+
+		/**
+		 * @brief Trilinear interpolation of the native density at the normalized position (texel centers at (i + 0.5) / size,
+		 * clamp to edge, same as the linear sampler). Footprints inside of one brick, including the padding, are read without
+		 * computing the index of every corner.
+		 */
+		[[nodiscard]] float Sample(glm::vec3 position) const;
+
+		/**
+		 * @brief Calls f(std::span<const T>) with the bricked buffer, see VoxelBuffer::Visit.
+		 */
+		template<typename F>
+		decltype(auto) Visit(F&& f) const
+		{
+			return m_Data.Visit(std::forward<F>(f));
+		}
+
+		[[nodiscard]] Size GetSize() const;
+		[[nodiscard]] glm::uvec3 GetBrickCounts() const;
+		[[nodiscard]] bool IsEmpty() const;
+
+	private:
+		template<typename T>
+		float SampleImpl(std::span<const T> data, glm::vec3 position) const;
+
+	private:
+		VoxelBuffer m_Data{};
+		Size m_Size{ 0, 0, 0 };
+		std::uint32_t m_BricksX = 0;
+		std::uint32_t m_BricksY = 0;
+		std::uint32_t m_BricksZ = 0;
+	};
+}
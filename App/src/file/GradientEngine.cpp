@@ -0,0 +1,395 @@
+#include "GradientEngine.h"
+#include "SeparableFilter.h"
+
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace med
+{
+	namespace
+	{
+		// 3D Sobel kernel is separable, e.g. SobelX(x, y, z) = derivative(x) * smooth(y) * smooth(z)
+		constexpr std::array<float, 3> kSobelSmooth = { 1.0f, 2.0f, 1.0f };
+		constexpr std::array<float, 3> kSobelDerivative = { -1.0f, 0.0f, 1.0f };
+
+		/*
+		* Sliding window average along one line, src and dst may not overlap. Window is clipped by the line ends,
+		* sum is divided by number of voxels that are inside, so the separable passes give the average of the clipped box.
+		* Elements of the line are stride apart in both src and dst.
+		*/
+		void BoxAverageLine(const glm::vec3* src, glm::vec3* dst, std::size_t count, std::size_t stride, int radius)
+		{
+			const std::size_t r = static_cast<std::size_t>(radius);
+			glm::dvec3 sum(0.0);
+			std::size_t inside = 0;
+
+			// Window for the first voxel, [0, r]
+			for (std::size_t i = 0; i <= r && i < count; ++i)
+			{
+				sum += glm::dvec3(src[i * stride]);
+				++inside;
+			}
+
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				dst[i * stride] = glm::vec3(sum / static_cast<double>(inside));
+
+				// Slide, voxel i + r + 1 enters, i - r leaves
+				if (i + r + 1 < count)
+				{
+					sum += glm::dvec3(src[(i + r + 1) * stride]);
+					++inside;
+				}
+				if (i >= r)
+				{
+					sum -= glm::dvec3(src[(i - r) * stride]);
+					--inside;
+				}
+			}
+		}
+
+		/*
+		* Central difference of one z-slice, out points to the gradient of that slice.
+		* Only slices z - 1, z and z + 1 are read. Returns max squared magnitude within the slice.
+		*/
+		template<typename T>
+		float CentralDifferenceSliceImpl(std::span<const T> data, GradientEngine::Size size, std::size_t z, float scale, glm::vec3* out)
+		{
+			const auto [xS, yS, zS] = size;
+			const std::size_t rowSize = xS;
+			const std::size_t sliceSize = rowSize * yS;
+
+			// Neighbour rows outside of the volume are read from here, keeps the row kernel branchless
+			const std::vector<T> zeroRow(rowSize, T{});
+			// -(p - m) / 2h, h = 1
+			const float factor = -0.5f * scale;
+
+			float maxMag2 = 0.0f;
+			const T* slice = data.data() + z * sliceSize;
+			const T* prevSlice = z > 0 ? slice - sliceSize : nullptr;
+			const T* nextSlice = z + 1 < zS ? slice + sliceSize : nullptr;
+
+			for (std::size_t y = 0; y < yS; ++y)
+			{
+				const std::size_t rowOffset = y * rowSize;
+				const T* c = slice + rowOffset;
+				const T* ym = y > 0 ? c - rowSize : zeroRow.data();
+				const T* yp = y + 1 < yS ? c + rowSize : zeroRow.data();
+				const T* zm = prevSlice != nullptr ? prevSlice + rowOffset : zeroRow.data();
+				const T* zp = nextSlice != nullptr ? nextSlice + rowOffset : zeroRow.data();
+				glm::vec3* dst = out + rowOffset;
+
+				auto voxel = [&](std::size_t x, float xm, float xp)
+				{
+					const glm::vec3 g(
+						(xp - xm) * factor,
+						(static_cast<float>(yp[x]) - static_cast<float>(ym[x])) * factor,
+						(static_cast<float>(zp[x]) - static_cast<float>(zm[x])) * factor);
+					dst[x] = g;
+					maxMag2 = std::max(maxMag2, glm::dot(g, g));
+				};
+
+				// Borders along x
+				voxel(0, 0.0f, rowSize > 1 ? static_cast<float>(c[1]) : 0.0f);
+				if (rowSize > 1)
+				{
+					voxel(rowSize - 1, static_cast<float>(c[rowSize - 2]), 0.0f);
+				}
+
+				// Interior, no bounds checks
+				for (std::size_t x = 1; x + 1 < rowSize; ++x)
+				{
+					const glm::vec3 g(
+						(static_cast<float>(c[x + 1]) - static_cast<float>(c[x - 1])) * factor,
+						(static_cast<float>(yp[x]) - static_cast<float>(ym[x])) * factor,
+						(static_cast<float>(zp[x]) - static_cast<float>(zm[x])) * factor);
+					dst[x] = g;
+					maxMag2 = std::max(maxMag2, g.x * g.x + g.y * g.y + g.z * g.z);
+				}
+			}
+
+			return maxMag2;
+		}
+
+		template<typename T>
+		float CentralDifferenceImpl(std::span<const T> data, GradientEngine::Size size, float scale, std::span<glm::vec3> out)
+		{
+			const auto [xS, yS, zS] = size;
+			const std::size_t sliceSize = static_cast<std::size_t>(xS) * yS;
+
+			if (data.empty())
+			{
+				return 0.0f;
+			}
+
+			// Max squared magnitude per slice, reduced at the end (no shared state between workers)
+			std::vector<float> sliceMax(zS, 0.0f);
+
+			base::ThreadPool::Get().ParallelFor(0, zS, [&](std::size_t z)
+			{
+				sliceMax[z] = CentralDifferenceSliceImpl(data, size, z, scale, out.data() + z * sliceSize);
+			});
+
+			return std::sqrt(*std::max_element(sliceMax.begin(), sliceMax.end()));
+		}
+
+		template<typename T>
+		float CentralDifferenceBrickedImpl(std::span<const T> data, const BrickedVolume& volume, float scale, std::span<glm::vec3> out)
+		{
+			constexpr std::uint32_t B = BrickedVolume::kBrickSize;
+			const auto [xS, yS, zS] = volume.GetSize();
+			const glm::uvec3 bricks = volume.GetBrickCounts();
+			const std::size_t brickCount = static_cast<std::size_t>(bricks.x) * bricks.y * bricks.z;
+			const float factor = -0.5f * scale;
+
+			if (data.empty())
+			{
+				return 0.0f;
+			}
+
+			// Tile is the brick with one voxel apron, voxels outside of the volume are 0
+			constexpr std::uint32_t W = B + 2;
+			constexpr std::ptrdiff_t dy = W;
+			constexpr std::ptrdiff_t dz = W * W;
+			std::vector<float> brickMax(brickCount, 0.0f);
+			base::ThreadPool::Get().ParallelFor(0, brickCount, [&](std::size_t brick)
+			{
+				const std::uint32_t bx = static_cast<std::uint32_t>(brick % bricks.x) * B;
+				const std::uint32_t by = static_cast<std::uint32_t>(brick / bricks.x % bricks.y) * B;
+				const std::uint32_t bz = static_cast<std::uint32_t>(brick / (static_cast<std::size_t>(bricks.x) * bricks.y)) * B;
+				const T* src = data.data() + brick * BrickedVolume::kBrickVoxels;
+
+				std::array<float, W * W * W> tile{};
+				const std::uint32_t countX = std::min<std::uint32_t>(B, xS - bx);
+
+				// Voxels of the brick are contiguous rows
+				for (std::uint32_t lz = 0; lz < B && bz + lz < zS; ++lz)
+				{
+					for (std::uint32_t ly = 0; ly < B && by + ly < yS; ++ly)
+					{
+						const T* row = src + (lz * B + ly) * B;
+						float* dst = tile.data() + ((lz + 1) * W + ly + 1) * W + 1;
+						for (std::uint32_t lx = 0; lx < countX; ++lx)
+						{
+							dst[lx] = static_cast<float>(row[lx]);
+						}
+					}
+				}
+
+				// Apron is looked up in the neighbouring bricks
+				auto apron = [&](std::uint32_t tx, std::uint32_t ty, std::uint32_t tz)
+				{
+					// Global coordinates, -1 wraps around and is rejected as well
+					const std::uint32_t x = bx + tx - 1, y = by + ty - 1, z = bz + tz - 1;
+					if (x < xS && y < yS && z < zS)
+					{
+						tile[(tz * W + ty) * W + tx] = static_cast<float>(data[volume.GetIndex(x, y, z)]);
+					}
+				};
+				for (std::uint32_t tz = 0; tz < W; ++tz)
+				{
+					for (std::uint32_t ty = 0; ty < W; ++ty)
+					{
+						const bool apronRow = tz == 0 || tz == W - 1 || ty == 0 || ty == W - 1;
+						for (std::uint32_t tx = 0; tx < W; tx += apronRow ? 1 : W - 1)
+						{
+							apron(tx, ty, tz);
+						}
+					}
+				}
+
+				float maxMag2 = 0.0f;
+				for (std::uint32_t lz = 0; lz < B && bz + lz < zS; ++lz)
+				{
+					for (std::uint32_t ly = 0; ly < B && by + ly < yS; ++ly)
+					{
+						const float* c = tile.data() + ((lz + 1) * W + ly + 1) * W + 1;
+						glm::vec3* dst = out.data() + (static_cast<std::size_t>(bz + lz) * yS + by + ly) * xS + bx;
+						for (std::uint32_t lx = 0; lx < countX; ++lx)
+						{
+							const float* v = c + lx;
+							const glm::vec3 g(
+								(v[1] - v[-1]) * factor,
+								(v[dy] - v[-dy]) * factor,
+								(v[dz] - v[-dz]) * factor);
+							dst[lx] = g;
+							maxMag2 = std::max(maxMag2, g.x * g.x + g.y * g.y + g.z * g.z);
+						}
+					}
+				}
+				brickMax[brick] = maxMag2;
+			});
+
+			return std::sqrt(*std::max_element(brickMax.begin(), brickMax.end()));
+		}
+	}
+
+	float GradientEngine::CentralDifference(const VoxelBuffer& density, Size size, float densityScale, std::span<glm::vec3> out)
+	{
+		assert(density.GetChannels() == 1 && "Gradient is computed from single channel data");
+		assert(density.GetVoxelCount() == out.size() && "Output does not match the volume");
+
+		return density.Visit([&](auto data) -> float
+		{
+			return CentralDifferenceImpl(data, size, densityScale, out);
+		});
+	}
+
+	float GradientEngine::CentralDifference(const BrickedVolume& density, float densityScale, std::span<glm::vec3> out)
+	{
+		assert(static_cast<std::size_t>(std::get<0>(density.GetSize())) * std::get<1>(density.GetSize()) * std::get<2>(density.GetSize()) == out.size()
+			&& "Output does not match the volume");
+
+		if (density.IsEmpty())
+		{
+			return 0.0f;
+		}
+
+		return density.Visit([&](auto data) -> float
+		{
+			return CentralDifferenceBrickedImpl(data, density, densityScale, out);
+		});
+	}
+
+	float GradientEngine::CentralDifferenceSlice(const VoxelBuffer& density, Size size, std::uint32_t z, float densityScale, std::span<glm::vec3> out)
+	{
+		assert(density.GetChannels() == 1 && "Gradient is computed from single channel data");
+		assert(out.size() == static_cast<std::size_t>(std::get<0>(size)) * std::get<1>(size) && "Output does not match the slice");
+
+		if (density.IsEmpty())
+		{
+			return 0.0f;
+		}
+
+		return std::sqrt(density.Visit([&](auto data) -> float
+		{
+			return CentralDifferenceSliceImpl(data, size, z, densityScale, out.data());
+		}));
+	}
+
+	void GradientEngine::Sobel(const VoxelBuffer& density, Size size, float densityScale, std::span<glm::vec3> out)
+	{
+		assert(density.GetChannels() == 1 && "Gradient is computed from single channel data");
+		assert(density.GetVoxelCount() == out.size() && "Output does not match the volume");
+
+		const auto [xS, yS, zS] = size;
+		if (xS < 3 || yS < 3 || zS < 3)
+		{
+			return;
+		}
+
+		const std::size_t sliceSize = static_cast<std::size_t>(xS) * yS;
+
+		// Slabs of consecutive slices, scratch is allocated once per slab and every input slice is loaded once per slab
+		const std::size_t interior = zS - 2;
+		const std::size_t slabCount = std::min<std::size_t>(interior, static_cast<std::size_t>(base::ThreadPool::Get().GetConcurrency()) * 4);
+
+		base::ThreadPool::Get().ParallelFor(0, slabCount, [&](std::size_t slab)
+		{
+			const std::size_t zBegin = 1 + interior * slab / slabCount;
+			const std::size_t zEnd = 1 + interior * (slab + 1) / slabCount;
+
+			// Input slices z - 1, z, z + 1 and scratch for the passes
+			std::vector<float> scratch(9 * sliceSize);
+			auto buffer = [&](int i) { return std::span<float>(scratch.data() + i * sliceSize, sliceSize); };
+			std::array<std::span<float>, 3> input = { buffer(0), buffer(1), buffer(2) };
+			auto smoothZ = buffer(3), derivZ = buffer(4), temp = buffer(5);
+			auto gx = buffer(6), gy = buffer(7), gz = buffer(8);
+
+			SeparableFilter::LoadSlice(density, size, static_cast<std::uint32_t>(zBegin - 1), densityScale, input[0]);
+			SeparableFilter::LoadSlice(density, size, static_cast<std::uint32_t>(zBegin), densityScale, input[1]);
+
+			for (std::size_t z = zBegin; z < zEnd; ++z)
+			{
+				SeparableFilter::LoadSlice(density, size, static_cast<std::uint32_t>(z + 1), densityScale, input[2]);
+
+				// z pass is shared, x and y gradients use smoothed slices, z gradient the derivative
+				const std::array<const float*, 3> slices = { input[0].data(), input[1].data(), input[2].data() };
+				SeparableFilter::CombineSlices(slices, smoothZ, kSobelSmooth);
+				SeparableFilter::CombineSlices(slices, derivZ, kSobelDerivative);
+
+				SeparableFilter::ConvolveColumns(smoothZ, temp, xS, yS, kSobelSmooth);
+				SeparableFilter::ConvolveRows(temp, gx, xS, yS, kSobelDerivative);
+
+				SeparableFilter::ConvolveColumns(smoothZ, temp, xS, yS, kSobelDerivative);
+				SeparableFilter::ConvolveRows(temp, gy, xS, yS, kSobelSmooth);
+
+				SeparableFilter::ConvolveColumns(derivZ, temp, xS, yS, kSobelSmooth);
+				SeparableFilter::ConvolveRows(temp, gz, xS, yS, kSobelSmooth);
+
+				// Only interior is written, border voxels keep their value
+				glm::vec3* dst = out.data() + z * sliceSize;
+				for (std::size_t y = 1; y + 1 < yS; ++y)
+				{
+					for (std::size_t x = 1; x + 1 < xS; ++x)
+					{
+						const std::size_t i = y * xS + x;
+						dst[i] = glm::vec3(gx[i], gy[i], gz[i]);
+					}
+				}
+
+				// Slices z and z + 1 are the next z - 1 and z, buffer of z - 1 is reloaded
+				std::rotate(input.begin(), input.begin() + 1, input.end());
+			}
+		});
+	}
+
+	void GradientEngine::BoxAverage(std::span<glm::vec3> data, Size size, int radius)
+	{
+		const auto [xS, yS, zS] = size;
+		const std::size_t rowSize = xS;
+		const std::size_t sliceSize = rowSize * yS;
+
+		assert(data.size() == sliceSize * zS && "Data do not match the volume");
+
+		if (radius <= 0 || data.empty())
+		{
+			return;
+		}
+
+		// x and y passes stay inside of a slice
+		base::ThreadPool::Get().ParallelFor(0, zS, [&](std::size_t z)
+		{
+			glm::vec3* slice = data.data() + z * sliceSize;
+			std::vector<glm::vec3> copy(slice, slice + sliceSize);
+
+			for (std::size_t y = 0; y < yS; ++y)
+			{
+				BoxAverageLine(copy.data() + y * rowSize, slice + y * rowSize, rowSize, 1, radius);
+			}
+
+			std::copy(slice, slice + sliceSize, copy.begin());
+			for (std::size_t x = 0; x < rowSize; ++x)
+			{
+				BoxAverageLine(copy.data() + x, slice + x, yS, rowSize, radius);
+			}
+		});
+
+		// z pass, each task owns one y row across all slices, rows are gathered so the lines are only rowSize apart
+		base::ThreadPool::Get().ParallelFor(0, yS, [&](std::size_t y)
+		{
+			std::vector<glm::vec3> lines(rowSize * zS);
+			std::vector<glm::vec3> averaged(rowSize * zS);
+
+			for (std::size_t z = 0; z < zS; ++z)
+			{
+				std::copy_n(data.data() + z * sliceSize + y * rowSize, rowSize, lines.begin() + z * rowSize);
+			}
+
+			for (std::size_t x = 0; x < rowSize; ++x)
+			{
+				BoxAverageLine(lines.data() + x, averaged.data() + x, zS, rowSize, radius);
+			}
+
+			for (std::size_t z = 0; z < zS; ++z)
+			{
+				std::copy_n(averaged.begin() + z * rowSize, rowSize, data.data() + z * sliceSize + y * rowSize);
+			}
+		});
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "VoxelBuffer.h"
+#include "BrickedVolume.h"
+
+#include "glm/glm.hpp"
+
+#include <cstdint>
+#include <span>
+#include <tuple>
+
+namespace med
+{
+	/**
+	 * @brief Gradient computation over the whole volume. Work is split into z-slabs on the thread pool, interior voxels
+	 * are processed by row kernels without bounds checks (contiguous, auto-vectorizable), borders are handled separately.
+	 * Density is read in its native type and multiplied by densityScale (normalization factor).
+	 */
+	class GradientEngine
+	{
+	public:
+		using Size = std::tuple<std::uint16_t, std::uint16_t, std::uint16_t>;
+
+		/**
+		 * @brief Central difference, -(f(x+1) - f(x-1)) / 2, voxels outside of the volume are 0.
+		 * @param out gradient for every voxel
+		 * @return largest gradient magnitude
+		 */
+		static float CentralDifference(const VoxelBuffer& density, Size size, float densityScale, std::span<glm::vec3> out);
+
+		/**
+		 * @brief Same central difference over the bricked layout. Bricks are processed in parallel, each one is copied
+		 * with one voxel apron into a small tile, so every neighbour is a constant offset away.
+		 * @param out gradient for every voxel, linear (row-major) order
+		 * @return largest gradient magnitude
+		 */
+		static float CentralDifference(const BrickedVolume& density, float densityScale, std::span<glm::vec3> out);
+
+		/**
+		 * @brief Central difference of a single z-slice, only slices z - 1, z and z + 1 are read
+		 * (used when the volume is processed while it is being loaded, see VolumeStreamProcessor).
+		 * @param out gradient of the slice, x * y elements
+		 * @return largest gradient magnitude within the slice
+		 */
+		static float CentralDifferenceSlice(const VoxelBuffer& density, Size size, std::uint32_t z, float densityScale, std::span<glm::vec3> out);
+
+		/**
+		 * @brief 3x3x3 Sobel, evaluated as separable 1D passes (see SeparableFilter), border voxels are left untouched.
+		 */
+		static void Sobel(const VoxelBuffer& density, Size size, float densityScale, std::span<glm::vec3> out);
+
+		/**
+		 * @brief In place average over (2 * radius + 1)^3 box, only voxels inside of the volume are averaged.
+		 * Running sums along x, y and z, cost per voxel does not depend on the radius.
+		 */
+		static void BoxAverage(std::span<glm::vec3> data, Size size, int radius);
+	};
+}
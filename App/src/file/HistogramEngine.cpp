@@ -0,0 +1,197 @@
+#include "HistogramEngine.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+
+namespace med
+{
+	namespace
+	{
+		// Smallest amount of work (voxels) worth its own bins
+		constexpr std::size_t kMinChunkVoxels = 1 << 16;
+
+		/*
+		* Bin of one value, NaN falls into the first bin.
+		*/
+		struct BinMapper
+		{
+			explicit BinMapper(HistogramBinning binning) :
+				Scale(binning.Scale), Last(binning.BinCount - 1), LastValue(static_cast<double>(binning.BinCount - 1))
+			{
+			}
+
+			template<typename T>
+			std::size_t operator()(T value) const
+			{
+				const double scaled = static_cast<double>(value) * Scale;
+				return scaled >= LastValue ? Last : (scaled > 0.0 ? static_cast<std::size_t>(scaled) : 0);
+			}
+
+			double Scale;
+			std::size_t Last;
+			double LastValue;
+		};
+
+		/*
+		* Splits [0, count) into chunks, accumulate(begin, end, bins) counts one chunk into its own bins, chunks are summed.
+		*/
+		template<typename Accumulate>
+		std::vector<std::uint32_t> ParallelBins(std::size_t count, std::size_t workPerItem, std::size_t binCount, Accumulate&& accumulate)
+		{
+			const std::size_t maxChunks = static_cast<std::size_t>(base::ThreadPool::Get().GetConcurrency()) * 4;
+			const std::size_t chunks = std::clamp<std::size_t>(count * workPerItem / kMinChunkVoxels, 1, std::min(maxChunks, std::max<std::size_t>(count, 1)));
+
+			std::vector<std::vector<std::uint32_t>> local(chunks);
+			base::ThreadPool::Get().ParallelFor(0, chunks, [&](std::size_t c)
+			{
+				local[c].assign(binCount, 0);
+				accumulate(count * c / chunks, count * (c + 1) / chunks, local[c]);
+			});
+
+			std::vector<std::uint32_t> result = std::move(local[0]);
+			for (std::size_t c = 1; c < chunks; ++c)
+			{
+				std::transform(result.begin(), result.end(), local[c].begin(), result.begin(), std::plus<>{});
+			}
+			return result;
+		}
+	}
+
+	HistogramBinning HistogramBinning::FromRange(std::size_t binCount, double range)
+	{
+		return { binCount, range > 0.0 ? static_cast<double>(binCount) / range : 0.0 };
+	}
+
+	HistogramEngine::Bins HistogramEngine::Compute(const VoxelBuffer& data, HistogramBinning binning)
+	{
+		assert(data.GetChannels() == 1 && "Histogram is computed from single channel data");
+
+		if (binning.BinCount == 0)
+		{
+			return {};
+		}
+
+		const BinMapper bin(binning);
+		return data.Visit([&](auto voxels)
+		{
+			return ParallelBins(voxels.size(), 1, binning.BinCount, [&](std::size_t begin, std::size_t end, std::vector<std::uint32_t>& bins)
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					++bins[bin(voxels[i])];
+				}
+			});
+		});
+	}
+
+	std::vector<HistogramEngine::Bins> HistogramEngine::ComputeMasked(const VoxelBuffer& data, std::span<const SparseMask> masks, HistogramBinning binning)
+	{
+		assert(data.GetChannels() == 1 && "Histogram is computed from single channel data");
+
+		if (binning.BinCount == 0 || masks.empty())
+		{
+			return std::vector<Bins>(masks.size());
+		}
+
+		const auto [xSize, ySize, zSize] = masks[0].GetSize();
+		assert(data.GetVoxelCount() == static_cast<std::size_t>(xSize) * ySize * zSize && "Mask does not match the data");
+		for (const auto& mask : masks)
+		{
+			assert(mask.GetSize() == masks[0].GetSize() && "Mask sizes do not match");
+		}
+
+		std::size_t inside = 0;
+		for (const auto& mask : masks)
+		{
+			inside += mask.CountVoxels();
+		}
+
+		// Bins of all masks are one array, mask m owns [m * BinCount, (m + 1) * BinCount)
+		const BinMapper bin(binning);
+		const Bins joined = data.Visit([&](auto voxels)
+		{
+			return ParallelBins(zSize, inside / std::max<std::size_t>(zSize, 1) + 1, binning.BinCount * masks.size(),
+				[&](std::size_t zBegin, std::size_t zEnd, std::vector<std::uint32_t>& bins)
+			{
+				for (std::size_t z = zBegin; z < zEnd; ++z)
+				{
+					for (std::size_t m = 0; m < masks.size(); ++m)
+					{
+						std::uint32_t* maskBins = bins.data() + m * binning.BinCount;
+						for (const auto& span : masks[m].GetSliceSpans(static_cast<std::uint32_t>(z)))
+						{
+							const std::size_t first = static_cast<std::size_t>(span.Row) * xSize;
+							for (std::size_t i = first + span.Begin; i < first + span.End; ++i)
+							{
+								++maskBins[bin(voxels[i])];
+							}
+						}
+					}
+				}
+			});
+		});
+
+		std::vector<Bins> result(masks.size());
+		for (std::size_t m = 0; m < masks.size(); ++m)
+		{
+			result[m].assign(joined.begin() + m * binning.BinCount, joined.begin() + (m + 1) * binning.BinCount);
+		}
+		return result;
+	}
+
+	HistogramEngine::Bins HistogramEngine::Compute2D(const VoxelBuffer& a, const VoxelBuffer& b, HistogramBinning aBinning, HistogramBinning bBinning)
+	{
+		assert(a.GetChannels() == 1 && b.GetChannels() == 1 && "Histogram is computed from single channel data");
+		assert(a.GetVoxelCount() == b.GetVoxelCount() && "Volumes do not match");
+
+		if (aBinning.BinCount == 0 || bBinning.BinCount == 0)
+		{
+			return {};
+		}
+
+		const BinMapper aBin(aBinning);
+		const BinMapper bBin(bBinning);
+		return a.Visit([&](auto aVoxels)
+		{
+			return b.Visit([&](auto bVoxels)
+			{
+				return ParallelBins(aVoxels.size(), 1, aBinning.BinCount * bBinning.BinCount,
+					[&](std::size_t begin, std::size_t end, std::vector<std::uint32_t>& bins)
+				{
+					for (std::size_t i = begin; i < end; ++i)
+					{
+						++bins[bBin(bVoxels[i]) * aBinning.BinCount + aBin(aVoxels[i])];
+					}
+				});
+			});
+		});
+	}
+
+	HistogramEngine::Bins HistogramEngine::ComputeDensityGradient(const VoxelBuffer& density, std::span<const glm::vec3> gradient,
+		HistogramBinning densityBinning, HistogramBinning magnitudeBinning)
+	{
+		assert(density.GetChannels() == 1 && "Histogram is computed from single channel data");
+		assert(density.GetVoxelCount() == gradient.size() && "Gradient does not match the density");
+
+		if (densityBinning.BinCount == 0 || magnitudeBinning.BinCount == 0)
+		{
+			return {};
+		}
+
+		const BinMapper densityBin(densityBinning);
+		const BinMapper magnitudeBin(magnitudeBinning);
+		return density.Visit([&](auto voxels)
+		{
+			return ParallelBins(voxels.size(), 1, densityBinning.BinCount * magnitudeBinning.BinCount,
+				[&](std::size_t begin, std::size_t end, std::vector<std::uint32_t>& bins)
+			{
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					++bins[magnitudeBin(glm::length(gradient[i])) * densityBinning.BinCount + densityBin(voxels[i])];
+				}
+			});
+		});
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "VoxelBuffer.h"
+#include "SparseMask.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Bins of equal width, value v falls into bin floor(v * Scale) clamped to [0, BinCount - 1].
+	 */
+	struct HistogramBinning
+	{
+		std::size_t BinCount = 0;
+		double Scale = 0.0;
+
+		/**
+		 * @brief binCount bins over [0, range], values above the range fall into the last bin.
+		 */
+		static HistogramBinning FromRange(std::size_t binCount, double range);
+	};
+
+	/**
+	 * @brief Histograms of the native density (see VoxelBuffer), type is resolved once per call.
+	 * Voxels are split into chunks on the thread pool, every chunk counts into its own bins (no atomics),
+	 * bins of the chunks are summed at the end.
+	 */
+	class HistogramEngine
+	{
+	public:
+		using Bins = std::vector<std::uint32_t>;
+
+		/**
+		 * @brief Histogram of every voxel, single channel data only.
+		 */
+		static Bins Compute(const VoxelBuffer& data, HistogramBinning binning);
+
+		/**
+		 * @brief One histogram per mask in a single pass, every slice of the data is visited once for all masks
+		 * and only the voxels inside of the masks are read.
+		 */
+		static std::vector<Bins> ComputeMasked(const VoxelBuffer& data, std::span<const SparseMask> masks, HistogramBinning binning);
+
+		/**
+		 * @brief Joint histogram of two volumes of the same size (e.g. CT density and RT dose),
+		 * bin of the pair (a, b) is [bBin * aBinning.BinCount + aBin].
+		 */
+		static Bins Compute2D(const VoxelBuffer& a, const VoxelBuffer& b, HistogramBinning aBinning, HistogramBinning bBinning);
+
+		/**
+		 * @brief Joint histogram of density and gradient magnitude (2D transfer functions), magnitude is computed on the fly,
+		 * bin of the voxel is [magnitudeBin * densityBinning.BinCount + densityBin].
+		 */
+		static Bins ComputeDensityGradient(const VoxelBuffer& density, std::span<const glm::vec3> gradient, HistogramBinning densityBinning,
+			HistogramBinning magnitudeBinning);
+
+	protected:
+		HistogramEngine() = default;
+	};
+}
@@ -0,0 +1,170 @@
+#include "ImageWriter.h"
+#include "Base/Base.h"
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace med
+{
+	namespace
+	{
+		std::uint32_t Crc32(std::span<const std::uint8_t> data, std::uint32_t crc = 0)
+		{
+			static const auto table = []
+			{
+				std::array<std::uint32_t, 256> t{};
+				for (std::uint32_t n = 0; n < 256; ++n)
+				{
+					std::uint32_t c = n;
+					for (int k = 0; k < 8; ++k)
+					{
+						c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+					}
+					t[n] = c;
+				}
+				return t;
+			}();
+
+			crc = ~crc;
+			for (const std::uint8_t byte : data)
+			{
+				crc = table[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+			}
+			return ~crc;
+		}
+
+		std::uint32_t Adler32(std::span<const std::uint8_t> data)
+		{
+			std::uint32_t a = 1, b = 0;
+			for (const std::uint8_t byte : data)
+			{
+				a = (a + byte) % 65521;
+				b = (b + a) % 65521;
+			}
+			return (b << 16) | a;
+		}
+
+		void PushBigEndian(std::vector<std::uint8_t>& out, std::uint32_t value)
+		{
+			out.push_back(static_cast<std::uint8_t>(value >> 24));
+			out.push_back(static_cast<std::uint8_t>(value >> 16));
+			out.push_back(static_cast<std::uint8_t>(value >> 8));
+			out.push_back(static_cast<std::uint8_t>(value));
+		}
+
+		void PushChunk(std::vector<std::uint8_t>& out, const char* type, std::span<const std::uint8_t> data)
+		{
+			PushBigEndian(out, static_cast<std::uint32_t>(data.size()));
+			const size_t typeOffset = out.size();
+			out.insert(out.end(), type, type + 4);
+			out.insert(out.end(), data.begin(), data.end());
+			// CRC covers chunk type and data
+			PushBigEndian(out, Crc32(std::span<const std::uint8_t>(out.data() + typeOffset, data.size() + 4)));
+		}
+
+		bool IsValid(std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height)
+		{
+			if (width == 0 || height == 0 || rgb.size() != static_cast<size_t>(width) * height * 3)
+			{
+				LOG_ERROR("Image size does not match the pixel data");
+				return false;
+			}
+			return true;
+		}
+
+		bool WriteBytes(const std::filesystem::path& path, std::span<const std::uint8_t> bytes)
+		{
+			std::ofstream file(path, std::ios::binary);
+			if (!file.is_open())
+			{
+				LOG_ERROR(("Cannot open " + path.string() + " for writing").c_str());
+				return false;
+			}
+			file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			return file.good();
+		}
+	}
+
+	bool ImageWriter::WritePPM(const std::filesystem::path& path, std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height)
+	{
+		if (!IsValid(rgb, width, height))
+		{
+			return false;
+		}
+
+		const std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+		std::vector<std::uint8_t> bytes(header.begin(), header.end());
+		bytes.insert(bytes.end(), rgb.begin(), rgb.end());
+
+		return WriteBytes(path, bytes);
+	}
+
+	bool ImageWriter::WritePNG(const std::filesystem::path& path, std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height)
+	{
+		if (!IsValid(rgb, width, height))
+		{
+			return false;
+		}
+
+		// Scanlines with filter type 0 (none)
+		const size_t stride = static_cast<size_t>(width) * 3;
+		std::vector<std::uint8_t> raw;
+		raw.reserve((stride + 1) * height);
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			raw.push_back(0);
+			raw.insert(raw.end(), rgb.begin() + y * stride, rgb.begin() + (y + 1) * stride);
+		}
+
+		// zlib stream of stored deflate blocks, at most 65535 bytes each
+		constexpr size_t maxBlock = 65535;
+		std::vector<std::uint8_t> zlib = { 0x78, 0x01 };
+		zlib.reserve(raw.size() + raw.size() / maxBlock * 5 + 16);
+		size_t offset = 0;
+		do
+		{
+			const size_t length = std::min(maxBlock, raw.size() - offset);
+			const bool last = offset + length == raw.size();
+			zlib.push_back(last ? 1 : 0);
+			zlib.push_back(static_cast<std::uint8_t>(length));
+			zlib.push_back(static_cast<std::uint8_t>(length >> 8));
+			zlib.push_back(static_cast<std::uint8_t>(~length));
+			zlib.push_back(static_cast<std::uint8_t>(~length >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + length);
+			offset += length;
+		} while (offset < raw.size());
+		PushBigEndian(zlib, Adler32(raw));
+
+		std::vector<std::uint8_t> header;
+		PushBigEndian(header, width);
+		PushBigEndian(header, height);
+		// 8-bit depth, truecolor, deflate, adaptive filtering, no interlace
+		header.insert(header.end(), { 8, 2, 0, 0, 0 });
+
+		std::vector<std::uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		PushChunk(png, "IHDR", header);
+		PushChunk(png, "IDAT", zlib);
+		PushChunk(png, "IEND", {});
+
+		return WriteBytes(path, png);
+	}
+
+	bool ImageWriter::Write(const std::filesystem::path& path, std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height)
+	{
+		const std::string extension = path.extension().string();
+		if (extension == ".png")
+		{
+			return WritePNG(path, rgb, width, height);
+		}
+		if (extension == ".ppm")
+		{
+			return WritePPM(path, rgb, width, height);
+		}
+
+		LOG_ERROR(("Unsupported image format " + extension).c_str());
+		return false;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+namespace med
+{
+	/**
+	 * @brief Writes 8-bit RGB images (rows top to bottom, channels interleaved) without external dependencies.
+	 * PNG is stored uncompressed (deflate 'stored' blocks), intended for debugging and reference images.
+	 */
+	class ImageWriter
+	{
+	protected:
+		ImageWriter() = default;
+	public:
+		/*
+		* Binary PPM (P6).
+		*/
+		static bool WritePPM(const std::filesystem::path& path, std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height);
+
+		static bool WritePNG(const std::filesystem::path& path, std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height);
+
+		/*
+		* Format is chosen by the extension, .ppm or .png.
+		*/
+		static bool Write(const std::filesystem::path& path, std::span<const std::uint8_t> rgb, std::uint32_t width, std::uint32_t height);
+	};
+}
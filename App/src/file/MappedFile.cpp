@@ -0,0 +1,119 @@
+#include "MappedFile.h"
+
+#if defined(PLATFORM_WINDOWS)
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#elif !defined(PLATFORM_WEB)
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include <fstream>
+
+namespace med
+{
+	MappedFile::~MappedFile()
+	{
+#if defined(PLATFORM_WINDOWS)
+		if (m_Data != nullptr)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_MappingHandle != nullptr)
+		{
+			CloseHandle(m_MappingHandle);
+		}
+		if (m_FileHandle != nullptr)
+		{
+			CloseHandle(m_FileHandle);
+		}
+#elif !defined(PLATFORM_WEB)
+		if (m_Data != nullptr && m_Fallback.empty())
+		{
+			munmap(const_cast<std::byte*>(m_Data), m_Size);
+		}
+#endif
+	}
+
+	std::shared_ptr<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+	{
+		std::shared_ptr<MappedFile> file(new MappedFile());
+
+#if defined(PLATFORM_WINDOWS)
+		HANDLE handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (handle == INVALID_HANDLE_VALUE)
+		{
+			return nullptr;
+		}
+		file->m_FileHandle = handle;
+
+		LARGE_INTEGER size{};
+		if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0)
+		{
+			return nullptr;
+		}
+		file->m_Size = static_cast<std::size_t>(size.QuadPart);
+
+		file->m_MappingHandle = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (file->m_MappingHandle == nullptr)
+		{
+			return nullptr;
+		}
+
+		file->m_Data = static_cast<const std::byte*>(MapViewOfFile(file->m_MappingHandle, FILE_MAP_READ, 0, 0, 0));
+		if (file->m_Data == nullptr)
+		{
+			return nullptr;
+		}
+#elif !defined(PLATFORM_WEB)
+		const int fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			return nullptr;
+		}
+
+		struct stat st{};
+		if (fstat(fd, &st) != 0 || st.st_size == 0)
+		{
+			close(fd);
+			return nullptr;
+		}
+		file->m_Size = static_cast<std::size_t>(st.st_size);
+
+		void* ptr = mmap(nullptr, file->m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// Mapping stays valid after the descriptor is closed
+		close(fd);
+		if (ptr == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		file->m_Data = static_cast<const std::byte*>(ptr);
+		madvise(ptr, file->m_Size, MADV_SEQUENTIAL);
+#else
+		std::ifstream in(path, std::ios::binary | std::ios::ate);
+		if (!in)
+		{
+			return nullptr;
+		}
+
+		file->m_Fallback.resize(static_cast<std::size_t>(in.tellg()));
+		in.seekg(0, std::ios::beg);
+		if (file->m_Fallback.empty() || !in.read(reinterpret_cast<char*>(file->m_Fallback.data()), file->m_Fallback.size()))
+		{
+			return nullptr;
+		}
+		file->m_Data = file->m_Fallback.data();
+		file->m_Size = file->m_Fallback.size();
+#endif
+
+		return file;
+	}
+
+	std::span<const std::byte> MappedFile::GetBytes() const
+	{
+		return { m_Data, m_Size };
+	}
+}
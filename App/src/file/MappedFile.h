@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Read-only memory mapping of a whole file. Pages are loaded by the OS on first access,
+	 * so large volumes are not copied into the process memory up front.
+	 * On the web there is no mapping, file is read into memory instead.
+	 */
+	class MappedFile
+	{
+	public:
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/**
+		 * @brief Maps the file.
+		 * @return nullptr if the file cannot be opened or mapped
+		 */
+		[[nodiscard]] static std::shared_ptr<MappedFile> Open(const std::filesystem::path& path);
+
+		[[nodiscard]] std::span<const std::byte> GetBytes() const;
+
+	private:
+		MappedFile() = default;
+
+	private:
+		const std::byte* m_Data = nullptr;
+		std::size_t m_Size = 0;
+		// Platform handles
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
+		// Used when mapping is not available
+		std::vector<std::byte> m_Fallback{};
+	};
+}
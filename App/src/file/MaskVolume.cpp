@@ -0,0 +1,155 @@
+#include "MaskVolume.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace med
+{
+	MaskVolume::MaskVolume(Size size, std::uint32_t roiCount) :
+		m_Size(size), m_RoiCount(roiCount)
+	{
+		const auto [x, y, z] = size;
+		m_SliceVoxels = static_cast<std::size_t>(x) * y;
+		m_SliceWords = (m_SliceVoxels + kWordBits - 1) / kWordBits;
+		m_RoiWords = m_SliceWords * z;
+		m_Bits.assign(m_RoiWords * roiCount, 0);
+		m_RoiSlices.resize(roiCount);
+	}
+
+	bool MaskVolume::Contains(std::uint32_t roi, std::uint32_t x, std::uint32_t y, std::uint32_t z) const
+	{
+		return Contains(roi, z * m_SliceVoxels + static_cast<std::size_t>(y) * std::get<0>(m_Size) + x);
+	}
+
+	bool MaskVolume::ContainsAny(std::size_t index) const
+	{
+		for (std::uint32_t roi = 0; roi < m_RoiCount; ++roi)
+		{
+			if (Contains(roi, index))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	std::span<MaskVolume::Word> MaskVolume::GetSliceBits(std::uint32_t roi, std::uint32_t z)
+	{
+		assert(roi < m_RoiCount && z < std::get<2>(m_Size) && "Slice out of bounds");
+		return { m_Bits.data() + roi * m_RoiWords + z * m_SliceWords, m_SliceWords };
+	}
+
+	std::span<const MaskVolume::Word> MaskVolume::GetSliceBits(std::uint32_t roi, std::uint32_t z) const
+	{
+		assert(roi < m_RoiCount && z < std::get<2>(m_Size) && "Slice out of bounds");
+		return { m_Bits.data() + roi * m_RoiWords + z * m_SliceWords, m_SliceWords };
+	}
+
+	std::size_t MaskVolume::CountVoxels(std::uint32_t roi) const
+	{
+		std::size_t count = 0;
+		for (std::size_t w = roi * m_RoiWords; w < (roi + 1) * m_RoiWords; ++w)
+		{
+			count += std::popcount(m_Bits[w]);
+		}
+		return count;
+	}
+
+	void MaskVolume::WriteLabelTexels(std::uint32_t firstRoi, std::uint32_t bytesPerTexel, std::uint32_t zBegin, std::uint32_t depth,
+		std::span<std::byte> dst) const
+	{
+		assert((bytesPerTexel == 1 || bytesPerTexel == 4) && "Label texels are R8Uint or R32Uint");
+		assert(dst.size() >= depth * m_SliceVoxels * bytesPerTexel && "Destination is too small");
+
+		std::fill(dst.begin(), dst.end(), std::byte{ 0 });
+		if (firstRoi >= m_RoiCount)
+		{
+			return;
+		}
+
+		const std::uint32_t roiCount = std::min(m_RoiCount - firstRoi, bytesPerTexel * 8);
+
+		// Bits of one ROI are or-ed into the texels word by word, texels without any ROI are not touched
+		auto scatter = [&]<typename T>(T* texels)
+		{
+			for (std::uint32_t r = 0; r < roiCount; ++r)
+			{
+				const T flag = static_cast<T>(T(1) << r);
+				for (std::uint32_t z = 0; z < depth; ++z)
+				{
+					const auto bits = GetSliceBits(firstRoi + r, zBegin + z);
+					T* slice = texels + z * m_SliceVoxels;
+
+					for (std::size_t w = 0; w < bits.size(); ++w)
+					{
+						Word word = bits[w];
+						while (word != 0)
+						{
+							slice[w * kWordBits + std::countr_zero(word)] |= flag;
+							word &= word - 1;
+						}
+					}
+				}
+			}
+		};
+
+		if (bytesPerTexel == 1)
+		{
+			scatter(reinterpret_cast<std::uint8_t*>(dst.data()));
+		}
+		else
+		{
+			scatter(reinterpret_cast<std::uint32_t*>(dst.data()));
+		}
+	}
+
+	void MaskVolume::SetBits(std::span<Word> bits, std::size_t first, std::size_t last)
+	{
+		constexpr Word kAll = ~Word(0);
+		const std::size_t firstWord = first / kWordBits;
+		const std::size_t lastWord = last / kWordBits;
+		const Word head = kAll << (first % kWordBits);
+		const Word tail = kAll >> (kWordBits - 1 - last % kWordBits);
+
+		if (firstWord == lastWord)
+		{
+			bits[firstWord] |= head & tail;
+			return;
+		}
+
+		bits[firstWord] |= head;
+		std::fill(bits.begin() + firstWord + 1, bits.begin() + lastWord, kAll);
+		bits[lastWord] |= tail;
+	}
+
+	void MaskVolume::SetRoiSlices(std::vector<std::vector<int>> slices)
+	{
+		assert(slices.size() == m_RoiCount && "One list of slices per ROI");
+		m_RoiSlices = std::move(slices);
+	}
+
+	const std::vector<int>& MaskVolume::GetRoiSlices(std::uint32_t roi) const
+	{
+		return m_RoiSlices[roi];
+	}
+
+	MaskVolume::Size MaskVolume::GetSize() const
+	{
+		return m_Size;
+	}
+
+	std::uint32_t MaskVolume::GetRoiCount() const
+	{
+		return m_RoiCount;
+	}
+
+	std::size_t MaskVolume::GetVoxelCount() const
+	{
+		return m_SliceVoxels * std::get<2>(m_Size);
+	}
+
+	std::size_t MaskVolume::GetSizeInBytes() const
+	{
+		return m_Bits.size() * sizeof(Word);
+	}
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Binary masks of any number of ROIs (e.g. RT structures) over one volume, 1 bit per ROI per voxel.
+	 * Every ROI has its own bit plane (voxel index z * x * y + y * x + x), slices of a plane start at a word boundary,
+	 * so different ROIs and slices can be written in parallel and a single ROI is scanned without touching the others.
+	 * GPU gets label texels instead, bit r of the texel is ROI firstRoi + r (see WriteLabelTexels).
+	 */
+	class MaskVolume
+	{
+	public:
+		using Size = std::tuple<std::uint16_t, std::uint16_t, std::uint16_t>;
+		using Word = std::uint64_t;
+
+		static constexpr std::uint32_t kWordBits = 64;
+
+		MaskVolume() = default;
+
+		/**
+		 * @brief Allocates empty masks.
+		 */
+		MaskVolume(Size size, std::uint32_t roiCount);
+
+		[[nodiscard]] bool Contains(std::uint32_t roi, std::size_t index) const
+		{
+			const auto [word, bit] = Locate(roi, index);
+			return (m_Bits[word] >> bit) & 1;
+		}
+
+		[[nodiscard]] bool Contains(std::uint32_t roi, std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+
+		/**
+		 * @brief Any ROI contains the voxel.
+		 */
+		[[nodiscard]] bool ContainsAny(std::size_t index) const;
+
+		void Set(std::uint32_t roi, std::size_t index, bool value = true)
+		{
+			const auto [word, bit] = Locate(roi, index);
+			if (value)
+			{
+				m_Bits[word] |= Word(1) << bit;
+			}
+			else
+			{
+				m_Bits[word] &= ~(Word(1) << bit);
+			}
+		}
+
+		/**
+		 * @brief Words of one slice of the ROI, bit i of the slice is voxel (i % x, i / x), trailing bits of the last word are unused.
+		 */
+		[[nodiscard]] std::span<Word> GetSliceBits(std::uint32_t roi, std::uint32_t z);
+		[[nodiscard]] std::span<const Word> GetSliceBits(std::uint32_t roi, std::uint32_t z) const;
+
+		/**
+		 * @brief Sets bits [first, last] of a slice (see GetSliceBits), whole words at once.
+		 */
+		static void SetBits(std::span<Word> bits, std::size_t first, std::size_t last);
+
+		/**
+		 * @brief Calls f(std::size_t index) for every voxel of the ROI in increasing order, empty words are skipped.
+		 */
+		template<typename F>
+		void ForEachVoxel(std::uint32_t roi, F&& f) const;
+
+		/**
+		 * @brief Number of voxels inside of the ROI.
+		 */
+		[[nodiscard]] std::size_t CountVoxels(std::uint32_t roi) const;
+
+		/**
+		 * @brief Writes label texels of slices [zBegin, zBegin + depth), bit r of the texel is set when ROI firstRoi + r contains the voxel.
+		 * ROIs that do not fit into the texel are left out (more than 32 ROIs need more textures). Signature follows SlabUploader::Fill.
+		 * @param bytesPerTexel 1 (R8Uint) or 4 (R32Uint)
+		 */
+		void WriteLabelTexels(std::uint32_t firstRoi, std::uint32_t bytesPerTexel, std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const;
+
+		/**
+		 * @brief Slices where the contours of the ROI are defined (see StructureFileDcm::Create3DMask), processing may skip the rest.
+		 */
+		void SetRoiSlices(std::vector<std::vector<int>> slices);
+		[[nodiscard]] const std::vector<int>& GetRoiSlices(std::uint32_t roi) const;
+
+		[[nodiscard]] Size GetSize() const;
+		[[nodiscard]] std::uint32_t GetRoiCount() const;
+		[[nodiscard]] std::size_t GetVoxelCount() const;
+		[[nodiscard]] std::size_t GetSizeInBytes() const;
+
+	private:
+		[[nodiscard]] std::pair<std::size_t, std::uint32_t> Locate(std::uint32_t roi, std::size_t index) const
+		{
+			const std::size_t z = index / m_SliceVoxels;
+			const std::size_t i = index - z * m_SliceVoxels;
+			return { roi * m_RoiWords + z * m_SliceWords + i / kWordBits, static_cast<std::uint32_t>(i % kWordBits) };
+		}
+
+	private:
+		Size m_Size{ 0, 0, 0 };
+		std::uint32_t m_RoiCount = 0;
+		std::size_t m_SliceVoxels = 0;
+		std::size_t m_SliceWords = 0;
+		std::size_t m_RoiWords = 0;
+		std::vector<Word> m_Bits{};
+		std::vector<std::vector<int>> m_RoiSlices{};
+	};
+
+	template<typename F>
+	void MaskVolume::ForEachVoxel(std::uint32_t roi, F&& f) const
+	{
+		const std::size_t zSize = std::get<2>(m_Size);
+		const Word* plane = m_Bits.data() + roi * m_RoiWords;
+
+		for (std::size_t z = 0; z < zSize; ++z)
+		{
+			const Word* slice = plane + z * m_SliceWords;
+			const std::size_t sliceBegin = z * m_SliceVoxels;
+
+			for (std::size_t w = 0; w < m_SliceWords; ++w)
+			{
+				Word word = slice[w];
+				while (word != 0)
+				{
+					f(sliceBegin + w * kWordBits + static_cast<std::size_t>(std::countr_zero(word)));
+					word &= word - 1;
+				}
+			}
+		}
+	}
+}
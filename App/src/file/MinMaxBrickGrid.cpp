@@ -0,0 +1,110 @@
+#include "MinMaxBrickGrid.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace med
+{
+	MinMaxBrickGrid::MinMaxBrickGrid(const VolumeFile& file, std::uint32_t brickSize) :
+		m_BrickSize(std::max<std::uint32_t>(brickSize, 1))
+	{
+		const auto& data = file.GetDensityBuffer();
+		assert(data.GetChannels() == 1 && "Brick grid is built from single channel data");
+
+		const auto [xS, yS, zS] = file.GetSize();
+		const auto bricks = [this](std::uint16_t size)
+		{
+			return static_cast<std::uint16_t>((size + m_BrickSize - 1) / m_BrickSize);
+		};
+		m_GridSize = { bricks(xS), bricks(yS), bricks(zS) };
+
+		const auto [gx, gy, gz] = m_GridSize;
+		m_Ranges.assign(static_cast<size_t>(gx) * gy * gz, glm::vec2(0.0f));
+
+		const float scale = file.GetDensityScale();
+		const int b = static_cast<int>(m_BrickSize);
+
+		data.Visit([&](auto voxels)
+		{
+			using T = std::remove_cvref_t<decltype(voxels[0])>;
+
+			// One task per row of bricks along x, bricks of the row share the rows of voxels
+			base::ThreadPool::Get().ParallelFor(0, static_cast<size_t>(gy) * gz, [&](size_t row)
+			{
+				const int by = static_cast<int>(row % gy);
+				const int bz = static_cast<int>(row / gy);
+
+				std::vector<T> minimum(gx, std::numeric_limits<T>::max());
+				std::vector<T> maximum(gx, std::numeric_limits<T>::lowest());
+
+				const int zEnd = std::min<int>(zS, (bz + 1) * b + 1);
+				const int yEnd = std::min<int>(yS, (by + 1) * b + 1);
+				for (int z = std::max(0, bz * b - 1); z < zEnd; ++z)
+				{
+					for (int y = std::max(0, by * b - 1); y < yEnd; ++y)
+					{
+						const T* line = voxels.data() + (static_cast<size_t>(z) * yS + y) * xS;
+						for (int bx = 0; bx < gx; ++bx)
+						{
+							const int xEnd = std::min<int>(xS, (bx + 1) * b + 1);
+							for (int x = std::max(0, bx * b - 1); x < xEnd; ++x)
+							{
+								minimum[bx] = std::min(minimum[bx], line[x]);
+								maximum[bx] = std::max(maximum[bx], line[x]);
+							}
+						}
+					}
+				}
+
+				glm::vec2* ranges = m_Ranges.data() + row * gx;
+				for (int bx = 0; bx < gx; ++bx)
+				{
+					ranges[bx] = glm::vec2(static_cast<float>(minimum[bx]) * scale, static_cast<float>(maximum[bx]) * scale);
+				}
+			});
+		});
+	}
+
+	std::pair<std::size_t, std::size_t> MinMaxBrickGrid::GetTexelRange(glm::vec2 range, std::size_t resolution)
+	{
+		assert(resolution > 0 && "TF has no texels");
+
+		// Texel i is centered at (i + 0.5) / resolution, samples in between blend the two neighbours
+		const auto texel = [resolution](float density, auto round)
+		{
+			const double position = round(static_cast<double>(density) * resolution - 0.5);
+			return static_cast<size_t>(std::clamp(position, 0.0, static_cast<double>(resolution - 1)));
+		};
+
+		return { texel(range.x, [](double v) { return std::floor(v); }), texel(range.y, [](double v) { return std::ceil(v); }) };
+	}
+
+	std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> MinMaxBrickGrid::GetGridSize() const
+	{
+		return m_GridSize;
+	}
+
+	std::uint32_t MinMaxBrickGrid::GetBrickSize() const
+	{
+		return m_BrickSize;
+	}
+
+	std::size_t MinMaxBrickGrid::GetBrickCount() const
+	{
+		return m_Ranges.size();
+	}
+
+	glm::vec2 MinMaxBrickGrid::GetRange(std::size_t brick) const
+	{
+		return m_Ranges[brick];
+	}
+
+	const std::vector<glm::vec2>& MinMaxBrickGrid::GetRanges() const
+	{
+		return m_Ranges;
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "VolumeFile.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Min/max density of every brick (brickSize^3 voxels) of the volume, used for empty space skipping.
+	 * Ranges include one voxel apron around the brick, so they also bound the values linearly interpolated at its border.
+	 * Densities are the ones the shaders sample (normalized if the file is normalized).
+	 */
+	class MinMaxBrickGrid
+	{
+	public:
+		// Has to match BRICK_SIZE in the shaders
+		static constexpr std::uint32_t kDefaultBrickSize = 8;
+
+		MinMaxBrickGrid() = default;
+
+		/**
+		 * @brief Builds the grid in one pass over the density, single channel data only.
+		 */
+		explicit MinMaxBrickGrid(const VolumeFile& file, std::uint32_t brickSize = kDefaultBrickSize);
+
+		/**
+		 * @brief Inclusive range of TF texels that contribute to samples of densities within [range.x, range.y].
+		 */
+		[[nodiscard]] static std::pair<std::size_t, std::size_t> GetTexelRange(glm::vec2 range, std::size_t resolution);
+
+		[[nodiscard]] std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> GetGridSize() const;
+		[[nodiscard]] std::uint32_t GetBrickSize() const;
+		[[nodiscard]] std::size_t GetBrickCount() const;
+
+		/**
+		 * @brief Min (x) and max (y) density of the brick.
+		 */
+		[[nodiscard]] glm::vec2 GetRange(std::size_t brick) const;
+		[[nodiscard]] const std::vector<glm::vec2>& GetRanges() const;
+
+	private:
+		std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> m_GridSize{ 0, 0, 0 };
+		std::uint32_t m_BrickSize = kDefaultBrickSize;
+		std::vector<glm::vec2> m_Ranges{};
+	};
+}
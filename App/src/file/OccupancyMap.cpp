@@ -0,0 +1,118 @@
+#include "OccupancyMap.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+
+namespace med
+{
+	OccupancyMap::OccupancyMap(MinMaxBrickGrid grid) :
+		m_Grid(std::move(grid)), m_Occupancy(m_Grid.GetBrickCount(), 0)
+	{
+	}
+
+	void OccupancyMap::Classify(std::span<const float> opacity)
+	{
+		m_Occupancy.assign(m_Grid.GetBrickCount(), 0);
+		// Whole map is rewritten
+		m_DirtyBricks = m_Occupancy.empty() ? std::pair<std::size_t, std::size_t>{ 1, 0 } : std::pair<std::size_t, std::size_t>{ 0, m_Occupancy.size() - 1 };
+
+		if (opacity.empty())
+		{
+			m_VisiblePrefix.clear();
+			m_TexelRanges.clear();
+			m_TexelResolution = 0;
+			return;
+		}
+
+		m_VisiblePrefix.assign(opacity.size() + 1, 0);
+		UpdatePrefix(opacity, 0);
+
+		// Texel ranges are recomputed only when the resolution changes
+		const auto& ranges = m_Grid.GetRanges();
+		const bool rangesValid = m_TexelResolution == opacity.size() && m_TexelRanges.size() == ranges.size();
+		m_TexelRanges.resize(ranges.size());
+		m_TexelResolution = opacity.size();
+
+		base::ThreadPool::Get().ParallelFor(0, ranges.size(), [&](size_t brick)
+		{
+			if (!rangesValid)
+			{
+				const auto [first, last] = MinMaxBrickGrid::GetTexelRange(ranges[brick], opacity.size());
+				m_TexelRanges[brick] = { static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last) };
+			}
+			m_Occupancy[brick] = IsVisible(m_TexelRanges[brick]) ? 255 : 0;
+		}, 1 << 12);
+	}
+
+	bool OccupancyMap::Update(std::span<const float> opacity, std::pair<std::size_t, std::size_t> editedTexels)
+	{
+		if (opacity.size() + 1 != m_VisiblePrefix.size())
+		{
+			Classify(opacity);
+			return true;
+		}
+
+		const auto first = static_cast<std::uint32_t>(std::min(editedTexels.first, opacity.size() - 1));
+		const auto last = static_cast<std::uint32_t>(std::min(editedTexels.second, opacity.size() - 1));
+		assert(first <= last && "Edited texel range is empty");
+
+		UpdatePrefix(opacity, first);
+
+		// Bounds of the changed bricks, SIZE_MAX > 0 if none has changed
+		std::atomic<std::size_t> firstChanged = SIZE_MAX;
+		std::atomic<std::size_t> lastChanged = 0;
+		base::ThreadPool::Get().ParallelFor(0, m_TexelRanges.size(), [&](size_t brick)
+		{
+			const auto texels = m_TexelRanges[brick];
+			if (texels.second < first || texels.first > last)
+			{
+				return;
+			}
+
+			const std::uint8_t visibility = IsVisible(texels) ? 255 : 0;
+			if (m_Occupancy[brick] != visibility)
+			{
+				m_Occupancy[brick] = visibility;
+
+				std::size_t lower = firstChanged.load(std::memory_order_relaxed);
+				while (brick < lower && !firstChanged.compare_exchange_weak(lower, brick, std::memory_order_relaxed)) {}
+				std::size_t upper = lastChanged.load(std::memory_order_relaxed);
+				while (brick > upper && !lastChanged.compare_exchange_weak(upper, brick, std::memory_order_relaxed)) {}
+			}
+		}, 1 << 12);
+
+		m_DirtyBricks = { firstChanged.load(), lastChanged.load() };
+		return m_DirtyBricks.first <= m_DirtyBricks.second;
+	}
+
+	std::pair<std::size_t, std::size_t> OccupancyMap::GetDirtyBricks() const
+	{
+		return m_DirtyBricks;
+	}
+
+	const std::vector<std::uint8_t>& OccupancyMap::GetOccupancy() const
+	{
+		return m_Occupancy;
+	}
+
+	const MinMaxBrickGrid& OccupancyMap::GetGrid() const
+	{
+		return m_Grid;
+	}
+
+	void OccupancyMap::UpdatePrefix(std::span<const float> opacity, std::size_t first)
+	{
+		for (std::size_t i = first; i < opacity.size(); ++i)
+		{
+			m_VisiblePrefix[i + 1] = m_VisiblePrefix[i] + (opacity[i] > 0.0f ? 1 : 0);
+		}
+	}
+
+	bool OccupancyMap::IsVisible(std::pair<std::uint32_t, std::uint32_t> texels) const
+	{
+		return m_VisiblePrefix[texels.second + 1] != m_VisiblePrefix[texels.first];
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "MinMaxBrickGrid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Visibility of the bricks of MinMaxBrickGrid under the opacity TF, 255 if any density within the brick range
+	 * maps to non-zero opacity, 0 otherwise. Layout matches the occupancy texture (x fastest).
+	 * Visibility of a brick is an O(1) query on the prefix count of visible TF texels, so TF edits re-evaluate
+	 * only the bricks whose texel range overlaps the edited interval.
+	 */
+	class OccupancyMap
+	{
+	public:
+		OccupancyMap() = default;
+		explicit OccupancyMap(MinMaxBrickGrid grid);
+
+		/**
+		 * @brief Re-evaluates every brick.
+		 * @param opacity TF texels over [0, 1], sampled with linear filtering and clamp to edge as in the shaders
+		 */
+		void Classify(std::span<const float> opacity);
+
+		/**
+		 * @brief Re-evaluates only the bricks whose texel range overlaps the edited texels (inclusive),
+		 * falls back to Classify if the TF resolution has changed.
+		 * @return true if visibility of any brick has changed
+		 */
+		bool Update(std::span<const float> opacity, std::pair<std::size_t, std::size_t> editedTexels);
+
+		/**
+		 * @brief Inclusive range of bricks (linear index, x fastest) changed by the last Classify or Update, first > last if none.
+		 * Only these have to be uploaded (VolumeTexture::UpdateOccupancy).
+		 */
+		[[nodiscard]] std::pair<std::size_t, std::size_t> GetDirtyBricks() const;
+
+		[[nodiscard]] const std::vector<std::uint8_t>& GetOccupancy() const;
+		[[nodiscard]] const MinMaxBrickGrid& GetGrid() const;
+
+	private:
+		/*
+		* Prefix count of visible texels from the texel 'first' onwards, texels below did not change.
+		*/
+		void UpdatePrefix(std::span<const float> opacity, std::size_t first);
+
+		bool IsVisible(std::pair<std::uint32_t, std::uint32_t> texels) const;
+
+	private:
+		MinMaxBrickGrid m_Grid{};
+		// Inclusive TF texel range of every brick, depends on the TF resolution only
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> m_TexelRanges{};
+		// TF resolution the texel ranges were computed for, 0 if there are none
+		std::size_t m_TexelResolution = 0;
+		// m_VisiblePrefix[i] is the number of texels below i with non-zero opacity
+		std::vector<std::uint32_t> m_VisiblePrefix{};
+		std::vector<std::uint8_t> m_Occupancy{};
+		std::pair<std::size_t, std::size_t> m_DirtyBricks{ 1, 0 };
+	};
+}
@@ -0,0 +1,169 @@
+#include "SeparableFilter.h"
+
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace med
+{
+	void SeparableFilter::Apply(const VoxelBuffer& src, Size size, float scale, std::span<const float> kernelX, std::span<const float> kernelY,
+		std::span<const float> kernelZ, std::span<float> dst)
+	{
+		assert(src.GetChannels() == 1 && "Filter is applied on single channel data");
+		assert(kernelZ.size() % 2 == 1 && "Kernel has to have odd size");
+
+		const auto [xS, yS, zS] = size;
+		const std::size_t sliceSize = static_cast<std::size_t>(xS) * yS;
+		const int radiusZ = static_cast<int>(kernelZ.size() / 2);
+
+		assert(dst.size() == sliceSize * zS && "Output does not match the volume");
+
+		base::ThreadPool::Get().ParallelFor(0, zS, [&](std::size_t z)
+		{
+			// Input slices z - r .. z + r, then z-combined, y-filtered slice
+			std::vector<float> inputs(kernelZ.size() * sliceSize);
+			std::vector<const float*> slices(kernelZ.size(), nullptr);
+			std::vector<float> combined(sliceSize);
+			std::vector<float> columns(sliceSize);
+
+			for (int i = 0; i < static_cast<int>(kernelZ.size()); ++i)
+			{
+				const int sz = static_cast<int>(z) + i - radiusZ;
+				if (sz < 0 || sz >= zS || kernelZ[i] == 0.0f)
+				{
+					continue;
+				}
+				std::span<float> slice(inputs.data() + i * sliceSize, sliceSize);
+				LoadSlice(src, size, sz, scale, slice);
+				slices[i] = slice.data();
+			}
+
+			CombineSlices(slices, combined, kernelZ);
+			ConvolveColumns(combined, columns, xS, yS, kernelY);
+			ConvolveRows(columns, dst.subspan(z * sliceSize, sliceSize), xS, yS, kernelX);
+		});
+	}
+
+	void SeparableFilter::ConvolveRows(std::span<const float> src, std::span<float> dst, std::uint32_t width, std::uint32_t height, std::span<const float> kernel)
+	{
+		assert(kernel.size() % 2 == 1 && "Kernel has to have odd size");
+		const std::uint32_t r = static_cast<std::uint32_t>(kernel.size() / 2);
+		const float* k = kernel.data();
+
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			const float* in = src.data() + static_cast<std::size_t>(y) * width;
+			float* out = dst.data() + static_cast<std::size_t>(y) * width;
+
+			// Borders, taps outside of the row are skipped
+			auto border = [&](std::uint32_t x)
+			{
+				float sum = 0.0f;
+				for (std::uint32_t i = 0; i < kernel.size(); ++i)
+				{
+					const std::int64_t sx = static_cast<std::int64_t>(x) + i - r;
+					if (sx >= 0 && sx < width)
+					{
+						sum += k[i] * in[sx];
+					}
+				}
+				out[x] = sum;
+			};
+
+			const std::uint32_t interiorEnd = width > r ? width - r : 0;
+			const std::uint32_t interiorBegin = std::min(r, interiorEnd);
+
+			for (std::uint32_t x = 0; x < interiorBegin; ++x)
+			{
+				border(x);
+			}
+
+			// Interior, no bounds checks, tap by tap so the inner loop is contiguous
+			for (std::uint32_t x = interiorBegin; x < interiorEnd; ++x)
+			{
+				out[x] = k[0] * in[x - r];
+			}
+			for (std::uint32_t i = 1; i < kernel.size(); ++i)
+			{
+				const float w = k[i];
+				const float* shifted = in + i - r;
+				for (std::uint32_t x = interiorBegin; x < interiorEnd; ++x)
+				{
+					out[x] += w * shifted[x];
+				}
+			}
+
+			for (std::uint32_t x = std::max(interiorEnd, interiorBegin); x < width; ++x)
+			{
+				border(x);
+			}
+		}
+	}
+
+	void SeparableFilter::ConvolveColumns(std::span<const float> src, std::span<float> dst, std::uint32_t width, std::uint32_t height, std::span<const float> kernel)
+	{
+		assert(kernel.size() % 2 == 1 && "Kernel has to have odd size");
+		const int r = static_cast<int>(kernel.size() / 2);
+
+		for (std::uint32_t y = 0; y < height; ++y)
+		{
+			float* out = dst.data() + static_cast<std::size_t>(y) * width;
+			std::fill_n(out, width, 0.0f);
+
+			// Whole rows are accumulated, inner loop is contiguous
+			for (int i = 0; i < static_cast<int>(kernel.size()); ++i)
+			{
+				const int sy = static_cast<int>(y) + i - r;
+				const float w = kernel[i];
+				if (sy < 0 || sy >= static_cast<int>(height) || w == 0.0f)
+				{
+					continue;
+				}
+
+				const float* in = src.data() + static_cast<std::size_t>(sy) * width;
+				for (std::uint32_t x = 0; x < width; ++x)
+				{
+					out[x] += w * in[x];
+				}
+			}
+		}
+	}
+
+	void SeparableFilter::CombineSlices(std::span<const float* const> slices, std::span<float> dst, std::span<const float> kernel)
+	{
+		assert(slices.size() == kernel.size() && "Each kernel weight needs a slice");
+		std::ranges::fill(dst, 0.0f);
+
+		for (std::size_t i = 0; i < slices.size(); ++i)
+		{
+			const float* in = slices[i];
+			const float w = kernel[i];
+			if (in == nullptr || w == 0.0f)
+			{
+				continue;
+			}
+
+			for (std::size_t v = 0; v < dst.size(); ++v)
+			{
+				dst[v] += w * in[v];
+			}
+		}
+	}
+
+	void SeparableFilter::LoadSlice(const VoxelBuffer& src, Size size, std::uint32_t z, float scale, std::span<float> dst)
+	{
+		const auto [xS, yS, zS] = size;
+		const std::size_t sliceSize = static_cast<std::size_t>(xS) * yS;
+
+		src.Visit([&](auto data)
+		{
+			const auto slice = data.subspan(z * sliceSize, sliceSize);
+			for (std::size_t v = 0; v < sliceSize; ++v)
+			{
+				dst[v] = static_cast<float>(slice[v]) * scale;
+			}
+		});
+	}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "VoxelBuffer.h"
+
+#include <cstdint>
+#include <span>
+#include <tuple>
+
+namespace med
+{
+	/**
+	 * @brief Separable 3D convolution, kernel k(x, y, z) = kx(x) * ky(y) * kz(z) is applied as three 1D passes on contiguous data.
+	 * Kernels have odd length 2r + 1 and are applied as correlation, dst[x] = sum_i k[i] * src[x + i - r].
+	 * Values outside of the volume are 0.
+	 */
+	class SeparableFilter
+	{
+	public:
+		using Size = std::tuple<std::uint16_t, std::uint16_t, std::uint16_t>;
+
+		/**
+		 * @brief Convolves the whole volume, work is split into z-slices on the thread pool, each slice is filtered
+		 * along z (combination of 2r + 1 input slices), then along y and x inside a slice sized scratch buffer.
+		 * @param src single channel volume in its native type
+		 * @param scale multiplies input values (e.g. density normalization)
+		 * @param dst output, one float per voxel
+		 */
+		static void Apply(const VoxelBuffer& src, Size size, float scale, std::span<const float> kernelX, std::span<const float> kernelY,
+			std::span<const float> kernelZ, std::span<float> dst);
+
+		/**
+		 * @brief 1D pass along x (rows) of width x height slice.
+		 */
+		static void ConvolveRows(std::span<const float> src, std::span<float> dst, std::uint32_t width, std::uint32_t height, std::span<const float> kernel);
+
+		/**
+		 * @brief 1D pass along y (columns) of width x height slice, rows are processed as a whole so the access stays contiguous.
+		 */
+		static void ConvolveColumns(std::span<const float> src, std::span<float> dst, std::uint32_t width, std::uint32_t height, std::span<const float> kernel);
+
+		/**
+		 * @brief 1D pass along z, dst = sum_i kernel[i] * slices[i]. Missing slices (outside of the volume) are nullptr.
+		 */
+		static void CombineSlices(std::span<const float* const> slices, std::span<float> dst, std::span<const float> kernel);
+
+		/**
+		 * @brief Converts one z-slice of the volume to float and multiplies it by scale.
+		 */
+		static void LoadSlice(const VoxelBuffer& src, Size size, std::uint32_t z, float scale, std::span<float> dst);
+	};
+}
@@ -0,0 +1,235 @@
+#include "SparseMask.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace med
+{
+	namespace
+	{
+		/*
+		* First position in [from, limit) whose bit equals value, limit if there is none.
+		*/
+		std::size_t FindBit(std::span<const MaskVolume::Word> bits, std::size_t from, std::size_t limit, bool value)
+		{
+			while (from < limit)
+			{
+				const std::size_t offset = from % MaskVolume::kWordBits;
+				const MaskVolume::Word word = (value ? bits[from / MaskVolume::kWordBits] : ~bits[from / MaskVolume::kWordBits]) >> offset;
+				if (word != 0)
+				{
+					return std::min(from + std::countr_zero(word), limit);
+				}
+				from += MaskVolume::kWordBits - offset;
+			}
+			return limit;
+		}
+
+		bool Precedes(const SparseMask::Span& a, const SparseMask::Span& b)
+		{
+			return a.Row < b.Row || (a.Row == b.Row && a.Begin < b.Begin);
+		}
+	}
+
+	SparseMask::SparseMask(Size size) :
+		m_Size(size)
+	{
+		Finalize();
+	}
+
+	SparseMask SparseMask::FromMask(const MaskVolume& mask, std::uint32_t roi)
+	{
+		SparseMask result(mask.GetSize());
+		const auto [xSize, ySize, zSize] = mask.GetSize();
+
+		// Every slice is encoded on its own, slices are concatenated in order afterwards
+		std::vector<std::vector<Span>> sliceSpans(zSize);
+		base::ThreadPool::Get().ParallelFor(0, zSize, [&](size_t z)
+		{
+			const auto bits = mask.GetSliceBits(roi, static_cast<std::uint32_t>(z));
+			for (std::uint32_t y = 0; y < ySize; ++y)
+			{
+				const std::size_t rowBegin = static_cast<std::size_t>(y) * xSize;
+				const std::size_t rowEnd = rowBegin + xSize;
+				const auto row = static_cast<std::uint32_t>(z * ySize + y);
+
+				std::size_t begin = FindBit(bits, rowBegin, rowEnd, true);
+				while (begin < rowEnd)
+				{
+					const std::size_t end = FindBit(bits, begin, rowEnd, false);
+					sliceSpans[z].push_back({ row, static_cast<std::uint16_t>(begin - rowBegin), static_cast<std::uint16_t>(end - rowBegin) });
+					begin = FindBit(bits, end, rowEnd, true);
+				}
+			}
+		});
+
+		for (auto& spans : sliceSpans)
+		{
+			result.m_Spans.insert(result.m_Spans.end(), spans.begin(), spans.end());
+		}
+		result.Finalize();
+		return result;
+	}
+
+	void SparseMask::WriteTo(MaskVolume& mask, std::uint32_t roi) const
+	{
+		assert(mask.GetSize() == m_Size && "Mask sizes do not match");
+
+		const auto [xSize, ySize, zSize] = m_Size;
+		base::ThreadPool::Get().ParallelFor(0, zSize, [&](size_t z)
+		{
+			const auto bits = mask.GetSliceBits(roi, static_cast<std::uint32_t>(z));
+			for (const Span& span : GetSliceSpans(static_cast<std::uint32_t>(z)))
+			{
+				const std::size_t rowBegin = static_cast<std::size_t>(span.Row - z * ySize) * xSize;
+				MaskVolume::SetBits(bits, rowBegin + span.Begin, rowBegin + span.End - 1);
+			}
+		});
+	}
+
+	SparseMask SparseMask::Union(const SparseMask& a, const SparseMask& b)
+	{
+		assert(a.m_Size == b.m_Size && "Mask sizes do not match");
+
+		SparseMask result(a.m_Size);
+		result.m_Spans.reserve(a.m_Spans.size() + b.m_Spans.size());
+
+		// Merge of two ordered lists, Append joins the overlaps
+		size_t i = 0;
+		size_t j = 0;
+		while (i < a.m_Spans.size() || j < b.m_Spans.size())
+		{
+			const bool takeA = j == b.m_Spans.size() || (i < a.m_Spans.size() && Precedes(a.m_Spans[i], b.m_Spans[j]));
+			const Span& span = takeA ? a.m_Spans[i++] : b.m_Spans[j++];
+			result.Append(span.Row, span.Begin, span.End);
+		}
+
+		result.Finalize();
+		return result;
+	}
+
+	SparseMask SparseMask::Intersection(const SparseMask& a, const SparseMask& b)
+	{
+		assert(a.m_Size == b.m_Size && "Mask sizes do not match");
+
+		SparseMask result(a.m_Size);
+
+		size_t i = 0;
+		size_t j = 0;
+		while (i < a.m_Spans.size() && j < b.m_Spans.size())
+		{
+			const Span& sa = a.m_Spans[i];
+			const Span& sb = b.m_Spans[j];
+
+			if (sa.Row != sb.Row)
+			{
+				if (sa.Row < sb.Row)
+				{
+					++i;
+				}
+				else
+				{
+					++j;
+				}
+				continue;
+			}
+
+			const std::uint16_t begin = std::max(sa.Begin, sb.Begin);
+			const std::uint16_t end = std::min(sa.End, sb.End);
+			if (begin < end)
+			{
+				result.Append(sa.Row, begin, end);
+			}
+
+			// Span that ends first cannot overlap anything else
+			if (sa.End < sb.End)
+			{
+				++i;
+			}
+			else
+			{
+				++j;
+			}
+		}
+
+		result.Finalize();
+		return result;
+	}
+
+	bool SparseMask::Contains(std::uint32_t x, std::uint32_t y, std::uint32_t z) const
+	{
+		const auto spans = GetSliceSpans(z);
+		const Span key{ z * std::get<1>(m_Size) + y, static_cast<std::uint16_t>(x), 0 };
+
+		// Last span that starts at or before the voxel
+		auto it = std::upper_bound(spans.begin(), spans.end(), key, Precedes);
+
+		if (it == spans.begin())
+		{
+			return false;
+		}
+		--it;
+		return it->Row == key.Row && x < it->End;
+	}
+
+	std::span<const SparseMask::Span> SparseMask::GetSpans() const
+	{
+		return m_Spans;
+	}
+
+	std::span<const SparseMask::Span> SparseMask::GetSliceSpans(std::uint32_t z) const
+	{
+		assert(z < std::get<2>(m_Size) && "Slice out of bounds");
+		return std::span<const Span>(m_Spans).subspan(m_SliceOffsets[z], m_SliceOffsets[z + 1] - m_SliceOffsets[z]);
+	}
+
+	std::size_t SparseMask::CountVoxels() const
+	{
+		return m_VoxelCount;
+	}
+
+	SparseMask::Size SparseMask::GetSize() const
+	{
+		return m_Size;
+	}
+
+	bool SparseMask::IsEmpty() const
+	{
+		return m_Spans.empty();
+	}
+
+	std::size_t SparseMask::GetSizeInBytes() const
+	{
+		return m_Spans.size() * sizeof(Span) + m_SliceOffsets.size() * sizeof(std::size_t);
+	}
+
+	void SparseMask::Append(std::uint32_t row, std::uint32_t begin, std::uint32_t end)
+	{
+		if (!m_Spans.empty() && m_Spans.back().Row == row && begin <= m_Spans.back().End)
+		{
+			m_Spans.back().End = std::max(m_Spans.back().End, static_cast<std::uint16_t>(end));
+			return;
+		}
+		m_Spans.push_back({ row, static_cast<std::uint16_t>(begin), static_cast<std::uint16_t>(end) });
+	}
+
+	void SparseMask::Finalize()
+	{
+		const auto [xSize, ySize, zSize] = m_Size;
+
+		m_SliceOffsets.assign(static_cast<size_t>(zSize) + 1, 0);
+		m_VoxelCount = 0;
+		for (const Span& span : m_Spans)
+		{
+			++m_SliceOffsets[span.Row / ySize + 1];
+			m_VoxelCount += span.End - span.Begin;
+		}
+
+		for (size_t z = 0; z < zSize; ++z)
+		{
+			m_SliceOffsets[z + 1] += m_SliceOffsets[z];
+		}
+	}
+}
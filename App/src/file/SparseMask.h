@@ -0,0 +1,121 @@
+#pragma once
+
+#include "MaskVolume.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Run-length encoded binary mask of one ROI, inside voxels are stored as spans of rows ordered by (row, begin).
+	 * Memory and iteration cost follow the size of the ROI, not the size of the volume (calibration, DVH-like statistics).
+	 * Spans are indexed per slice, so a slice is reached without a search. Dense MaskVolume is used for the upload.
+	 */
+	class SparseMask
+	{
+	public:
+		using Size = MaskVolume::Size;
+
+		/**
+		 * @brief Inside voxels [Begin, End) of one row, Row is z * y + y.
+		 */
+		struct Span
+		{
+			std::uint32_t Row = 0;
+			std::uint16_t Begin = 0;
+			std::uint16_t End = 0;
+		};
+
+		SparseMask() = default;
+
+		/**
+		 * @brief Empty mask.
+		 */
+		explicit SparseMask(Size size);
+
+		/**
+		 * @brief Encodes one ROI of the dense mask, slices are encoded in parallel.
+		 */
+		[[nodiscard]] static SparseMask FromMask(const MaskVolume& mask, std::uint32_t roi);
+
+		/**
+		 * @brief Sets the bits of the inside voxels in the ROI plane (bits already set are kept).
+		 */
+		void WriteTo(MaskVolume& mask, std::uint32_t roi) const;
+
+		/**
+		 * @brief Voxels inside of a or b, both masks must have the same size.
+		 */
+		[[nodiscard]] static SparseMask Union(const SparseMask& a, const SparseMask& b);
+
+		/**
+		 * @brief Voxels inside of a and b, both masks must have the same size.
+		 */
+		[[nodiscard]] static SparseMask Intersection(const SparseMask& a, const SparseMask& b);
+
+		[[nodiscard]] bool Contains(std::uint32_t x, std::uint32_t y, std::uint32_t z) const;
+
+		/**
+		 * @brief Calls f(std::size_t first, std::size_t count) for every span, first is the linear index of its first voxel.
+		 */
+		template<typename F>
+		void ForEachSpan(F&& f) const;
+
+		/**
+		 * @brief Calls f(std::size_t index) for every inside voxel in increasing order.
+		 */
+		template<typename F>
+		void ForEachVoxel(F&& f) const;
+
+		[[nodiscard]] std::span<const Span> GetSpans() const;
+		[[nodiscard]] std::span<const Span> GetSliceSpans(std::uint32_t z) const;
+
+		[[nodiscard]] std::size_t CountVoxels() const;
+		[[nodiscard]] Size GetSize() const;
+		[[nodiscard]] bool IsEmpty() const;
+		[[nodiscard]] std::size_t GetSizeInBytes() const;
+
+	private:
+		/*
+		* Appends span, spans have to come in (row, begin) order, overlapping and touching spans of a row are merged.
+		*/
+		void Append(std::uint32_t row, std::uint32_t begin, std::uint32_t end);
+
+		/*
+		* Builds the slice index and the voxel count once all spans are appended.
+		*/
+		void Finalize();
+
+	private:
+		Size m_Size{ 0, 0, 0 };
+		std::vector<Span> m_Spans{};
+		// Spans of slice z are [m_SliceOffsets[z], m_SliceOffsets[z + 1])
+		std::vector<std::size_t> m_SliceOffsets{};
+		std::size_t m_VoxelCount = 0;
+	};
+
+	template<typename F>
+	void SparseMask::ForEachSpan(F&& f) const
+	{
+		const std::size_t xSize = std::get<0>(m_Size);
+		for (const Span& span : m_Spans)
+		{
+			f(static_cast<std::size_t>(span.Row) * xSize + span.Begin, static_cast<std::size_t>(span.End - span.Begin));
+		}
+	}
+
+	template<typename F>
+	void SparseMask::ForEachVoxel(F&& f) const
+	{
+		ForEachSpan([&f](std::size_t first, std::size_t count)
+		{
+			for (std::size_t i = first; i < first + count; ++i)
+			{
+				f(i);
+			}
+		});
+	}
+}
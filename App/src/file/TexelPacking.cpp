@@ -0,0 +1,219 @@
+#include "TexelPacking.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace med
+{
+	namespace
+	{
+		glm::vec2 SignNotZero(glm::vec2 v)
+		{
+			return { v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f };
+		}
+	}
+
+	DensityTexelFormat TexelPacking::ChooseDensityFormat(bool normalized, int usedBits, bool isInteger)
+	{
+		// Raw values are not in [0, 1], 16 bit float would not keep integers above 2048
+		if (!normalized)
+		{
+			return DensityTexelFormat::R32Float;
+		}
+
+		if (!isInteger)
+		{
+			return DensityTexelFormat::R16Float;
+		}
+
+		// Levels are k / range, 8 bit unorm keeps 256 of them. Half float spacing within [0.5, 1] is 2^-11,
+		// so the rounding error stays below half of the level step up to 11 bits
+		if (usedBits <= 8)
+		{
+			return DensityTexelFormat::R8Unorm;
+		}
+		if (usedBits <= 11)
+		{
+			return DensityTexelFormat::R16Float;
+		}
+		return DensityTexelFormat::R32Float;
+	}
+
+	std::uint32_t TexelPacking::GetBytesPerTexel(DensityTexelFormat format)
+	{
+		switch (format)
+		{
+		case DensityTexelFormat::R8Unorm:
+			return 1;
+		case DensityTexelFormat::R16Float:
+			return 2;
+		case DensityTexelFormat::R32Float:
+			return 4;
+		}
+		return 0;
+	}
+
+	void TexelPacking::PackDensity(DensityTexelFormat format, float density, std::byte* dst)
+	{
+		switch (format)
+		{
+		case DensityTexelFormat::R8Unorm:
+		{
+			const auto value = static_cast<std::uint8_t>(std::lround(std::clamp(density, 0.0f, 1.0f) * 255.0f));
+			std::memcpy(dst, &value, sizeof(value));
+			break;
+		}
+		case DensityTexelFormat::R16Float:
+		{
+			const std::uint16_t value = FloatToHalf(density);
+			std::memcpy(dst, &value, sizeof(value));
+			break;
+		}
+		case DensityTexelFormat::R32Float:
+			std::memcpy(dst, &density, sizeof(density));
+			break;
+		}
+	}
+
+	float TexelPacking::UnpackDensity(DensityTexelFormat format, const std::byte* src)
+	{
+		switch (format)
+		{
+		case DensityTexelFormat::R8Unorm:
+			return static_cast<float>(std::to_integer<std::uint8_t>(src[0])) / 255.0f;
+		case DensityTexelFormat::R16Float:
+		{
+			std::uint16_t value;
+			std::memcpy(&value, src, sizeof(value));
+			return HalfToFloat(value);
+		}
+		case DensityTexelFormat::R32Float:
+		{
+			float value;
+			std::memcpy(&value, src, sizeof(value));
+			return value;
+		}
+		}
+		return 0.0f;
+	}
+
+	void TexelPacking::PackGradient(glm::vec3 gradient, float invMaxMagnitude, std::byte* dst)
+	{
+		const float magnitude = glm::length(gradient) * invMaxMagnitude;
+		const glm::vec2 direction = magnitude > 0.0f ? EncodeOctahedral(gradient) : glm::vec2(0.0f);
+
+		const std::int8_t texel[kGradientTexelBytes] = { FloatToSnorm8(direction.x), FloatToSnorm8(direction.y), FloatToSnorm8(magnitude), 0 };
+		std::memcpy(dst, texel, kGradientTexelBytes);
+	}
+
+	glm::vec3 TexelPacking::UnpackGradient(const std::byte* src, float maxMagnitude)
+	{
+		std::int8_t texel[kGradientTexelBytes];
+		std::memcpy(texel, src, kGradientTexelBytes);
+
+		const glm::vec2 direction(Snorm8ToFloat(texel[0]), Snorm8ToFloat(texel[1]));
+		return DecodeOctahedral(direction) * Snorm8ToFloat(texel[2]) * maxMagnitude;
+	}
+
+	glm::vec2 TexelPacking::EncodeOctahedral(glm::vec3 direction)
+	{
+		const float l1 = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+		if (l1 == 0.0f)
+		{
+			return glm::vec2(0.0f);
+		}
+
+		glm::vec2 p = glm::vec2(direction.x, direction.y) / l1;
+		// Lower hemisphere is folded over the diagonals
+		if (direction.z < 0.0f)
+		{
+			p = (glm::vec2(1.0f) - glm::abs(glm::vec2(p.y, p.x))) * SignNotZero(p);
+		}
+		return p;
+	}
+
+	glm::vec3 TexelPacking::DecodeOctahedral(glm::vec2 encoded)
+	{
+		glm::vec3 n(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		const float t = std::max(-n.z, 0.0f);
+		n.x += n.x >= 0.0f ? -t : t;
+		n.y += n.y >= 0.0f ? -t : t;
+		return glm::normalize(n);
+	}
+
+	std::uint16_t TexelPacking::FloatToHalf(float value)
+	{
+		std::uint32_t bits;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const std::uint32_t sign = (bits >> 16) & 0x8000u;
+		const std::uint32_t absBits = bits & 0x7fffffffu;
+
+		// Inf, NaN
+		if (absBits >= 0x7f800000u)
+		{
+			return static_cast<std::uint16_t>(sign | (absBits > 0x7f800000u ? 0x7e00u : 0x7c00u));
+		}
+		// Rounds above the largest half (65504)
+		if (absBits >= 0x477ff000u)
+		{
+			return static_cast<std::uint16_t>(sign | 0x7c00u);
+		}
+		// Subnormal half, multiples of 2^-24 (nearbyint rounds half to even)
+		if (absBits < 0x38800000u)
+		{
+			const float scaled = std::abs(value) * 16777216.0f;
+			return static_cast<std::uint16_t>(sign | static_cast<std::uint32_t>(std::nearbyint(scaled)));
+		}
+
+		const std::uint32_t exponent = (absBits >> 23) - 127 + 15;
+		const std::uint32_t mantissa = absBits & 0x7fffffu;
+		std::uint32_t half = (exponent << 10) | (mantissa >> 13);
+
+		// Round to nearest even, carry may overflow into the exponent which is still correct
+		const std::uint32_t rest = mantissa & 0x1fffu;
+		if (rest > 0x1000u || (rest == 0x1000u && (half & 1u) != 0))
+		{
+			++half;
+		}
+		return static_cast<std::uint16_t>(sign | half);
+	}
+
+	float TexelPacking::HalfToFloat(std::uint16_t value)
+	{
+		const std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000u) << 16;
+		const std::uint32_t exponent = (value >> 10) & 0x1fu;
+		const std::uint32_t mantissa = value & 0x3ffu;
+
+		if (exponent == 0)
+		{
+			const float magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+			return sign != 0 ? -magnitude : magnitude;
+		}
+
+		std::uint32_t bits;
+		if (exponent == 0x1fu)
+		{
+			bits = sign | 0x7f800000u | (mantissa << 13);
+		}
+		else
+		{
+			bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+		}
+
+		float result;
+		std::memcpy(&result, &bits, sizeof(result));
+		return result;
+	}
+
+	std::int8_t TexelPacking::FloatToSnorm8(float value)
+	{
+		return static_cast<std::int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+	}
+
+	float TexelPacking::Snorm8ToFloat(std::int8_t value)
+	{
+		return std::max(static_cast<float>(value) / 127.0f, -1.0f);
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "glm/glm.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace med
+{
+	/**
+	 * @brief GPU representation of the density, see TexelPacking::ChooseDensityFormat.
+	 */
+	enum class DensityTexelFormat
+	{
+		R8Unorm,
+		R16Float,
+		R32Float
+	};
+
+	/**
+	 * @brief CPU side packing of the texels uploaded to the GPU, no GPU is needed (shaders decode the same layouts).
+	 * Gradient texel is RGBA8Snorm: rg - octahedral encoded direction, b - magnitude relative to the largest one, a - 0.
+	 */
+	class TexelPacking
+	{
+	public:
+		static constexpr std::uint32_t kGradientTexelBytes = 4;
+
+		/**
+		 * @brief Smallest format that keeps distinct density levels distinct.
+		 * @param normalized density is in [0, 1], raw values are kept in 32 bit float
+		 * @param usedBits bits needed by the largest value (integer data)
+		 * @param isInteger false for float data
+		 */
+		[[nodiscard]] static DensityTexelFormat ChooseDensityFormat(bool normalized, int usedBits, bool isInteger);
+
+		[[nodiscard]] static std::uint32_t GetBytesPerTexel(DensityTexelFormat format);
+
+		/**
+		 * @brief Writes one density texel, dst has GetBytesPerTexel(format) bytes.
+		 */
+		static void PackDensity(DensityTexelFormat format, float density, std::byte* dst);
+		[[nodiscard]] static float UnpackDensity(DensityTexelFormat format, const std::byte* src);
+
+		/**
+		 * @brief Writes one gradient texel (kGradientTexelBytes).
+		 * @param invMaxMagnitude 1 / largest gradient magnitude within the volume
+		 */
+		static void PackGradient(glm::vec3 gradient, float invMaxMagnitude, std::byte* dst);
+		[[nodiscard]] static glm::vec3 UnpackGradient(const std::byte* src, float maxMagnitude);
+
+		/**
+		 * @brief Unit vector to the octahedron unfolded into [-1, 1]^2 and back.
+		 */
+		[[nodiscard]] static glm::vec2 EncodeOctahedral(glm::vec3 direction);
+		[[nodiscard]] static glm::vec3 DecodeOctahedral(glm::vec2 encoded);
+
+		/**
+		 * @brief IEEE 754 binary16, round to nearest even.
+		 */
+		[[nodiscard]] static std::uint16_t FloatToHalf(float value);
+		[[nodiscard]] static float HalfToFloat(std::uint16_t value);
+
+		[[nodiscard]] static std::int8_t FloatToSnorm8(float value);
+		[[nodiscard]] static float Snorm8ToFloat(std::int8_t value);
+	};
+}
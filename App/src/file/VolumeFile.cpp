@@ -1,32 +1,68 @@
 #include "VolumeFile.h"
+#include "GradientEngine.h"
+#include "HistogramEngine.h"
 #include "Base/Base.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
 
 namespace med
 {
-	VolumeFile::VolumeFile(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, FileDataType type, std::vector<glm::vec4>& data) : 
-		m_Path(std::move(path)), m_Size(size), m_FileDataType(type), m_Data(std::move(data))
+	namespace
 	{
-		m_MaxNumber = GetMaxNumber(m_Data);
+		/*
+		* Trilinear interpolation over the linear buffer, clamp to edge.
+		*/
+		template<typename T>
+		float SampleLinear(std::span<const T> data, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, glm::vec3 position)
+		{
+			const auto [xS, yS, zS] = size;
+			const glm::ivec3 dims(xS, yS, zS);
+			const glm::vec3 coord = position * glm::vec3(dims) - glm::vec3(0.5f);
+			const glm::vec3 base = glm::floor(coord);
+			const glm::vec3 t = coord - base;
+			const glm::ivec3 i0 = glm::clamp(glm::ivec3(base), glm::ivec3(0), dims - glm::ivec3(1));
+			const glm::ivec3 i1 = glm::clamp(glm::ivec3(base) + glm::ivec3(1), glm::ivec3(0), dims - glm::ivec3(1));
+
+			const auto at = [&](int x, int y, int z)
+			{
+				return static_cast<float>(data[(static_cast<size_t>(z) * yS + y) * xS + x]);
+			};
+
+			const float c00 = glm::mix(at(i0.x, i0.y, i0.z), at(i1.x, i0.y, i0.z), t.x);
+			const float c10 = glm::mix(at(i0.x, i1.y, i0.z), at(i1.x, i1.y, i0.z), t.x);
+			const float c01 = glm::mix(at(i0.x, i0.y, i1.z), at(i1.x, i0.y, i1.z), t.x);
+			const float c11 = glm::mix(at(i0.x, i1.y, i1.z), at(i1.x, i1.y, i1.z), t.x);
+			return glm::mix(glm::mix(c00, c10, t.y), glm::mix(c01, c11, t.y), t.z);
+		}
 	}
 
-	VolumeFile::VolumeFile(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, FileDataType type, std::vector<glm::vec4>& data, size_t maxNumber) :
-		m_Path(std::move(path)), m_Size(size), m_FileDataType(type), m_Data(std::move(data)), m_MaxNumber(maxNumber)
+	VolumeFile::VolumeFile(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, VoxelBuffer data, size_t maxNumber) :
+		m_Path(std::move(path)), m_Size(size), m_FileDataType(data.GetType()), m_Data(std::move(data)), m_MaxNumber(maxNumber)
 	{
 		if (m_MaxNumber == 0)
 		{
-			m_MaxNumber = GetMaxNumber(m_Data);
+			m_MaxNumber = static_cast<size_t>(m_Data.GetMaxValue());
 		}
 	}
 
-
-	void VolumeFile::SetData(std::vector<glm::vec4> &src)
+	void VolumeFile::SetData(VoxelBuffer src)
 	{
 		m_Data = std::move(src);
-	}
-
-	void VolumeFile::SetFileDataType(FileDataType type)
-	{
-		m_FileDataType = type;
+		m_FileDataType = m_Data.GetType();
+		// Bricked copy follows the new data
+		if (!m_Bricked.IsEmpty())
+		{
+			m_Bricked = m_Data.GetChannels() == 1 ? BrickedVolume(m_Data, m_Size) : BrickedVolume();
+		}
+		m_Gradient.clear();
+		m_HasGradient = false;
+		m_GradientMaxMagnitude = 0.0f;
+		m_Histogram = {};
 	}
 
 	void VolumeFile::SetDataSize(std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size)
@@ -50,15 +86,6 @@ namespace med
 		return static_cast<float>(value) / 100;
 	}
 
-	size_t VolumeFile::GetMaxNumber(const std::vector<glm::vec4>& vec, int index) const
-	{
-		const std::vector<glm::vec4>::const_iterator maxElement = std::max_element(vec.begin(), vec.end(), [&](const glm::vec4& a, const glm::vec4& b) {
-			return a[index] < b[index];
-		});
-
-		return maxElement != vec.end() ? (*maxElement)[index] : 0;
-	}
-
 	size_t VolumeFile::GetMaxNumber() const
 	{
 		return m_MaxNumber;
@@ -84,34 +111,11 @@ namespace med
 
 		LOG_INFO("Computing gradients");
 		auto [xS, yS, zS] = m_Size;
+		m_Gradient.assign(static_cast<size_t>(xS) * yS * zS, glm::vec3(0.0f));
+
+		GradientEngine::Sobel(m_Data, m_Size, GetDensityScale(), m_Gradient);
+		m_GradientMaxMagnitude = ComputeGradientMaxMagnitude();
 
-		for (int z = 1; z < zS - 1; ++z)
-		{
-			for (int y = 1; y < yS - 1; ++y)
-			{
-				for (int x = 1; x < xS - 1; ++x)
-				{
-					float gx = 0.0f, gy = 0.0f, gz = 0.0f;
-					for (int i = -1; i <= 1; ++i)
-					{
-						for (int j = -1; j <= 1; ++j)
-						{
-							for (int k = -1; k <= 1; ++k)
-							{
-								glm::vec4 voxel = GetVoxelData(x + i, y + j, z + k);
-								gx += voxel.a * m_SobelX[k + 1][j + 1][i + 1];
-								gy += voxel.a * m_SobelY[k + 1][j + 1][i + 1];
-								gz += voxel.a * m_SobelZ[k + 1][j + 1][i + 1];
-							}
-						}
-					}
-					int c = GetIndexFrom3D(x, y, z);
-					m_Data[c].x = gx;
-					m_Data[c].y = gy;
-					m_Data[c].z = gz;
-				}
-			}
-		}
 		m_HasGradient = true;
 		LOG_INFO("Done");
 	}
@@ -125,41 +129,11 @@ namespace med
 			LOG_WARN("Gradient not computed.");
 			PreComputeGradient();
 		}
-		kernelSize = (kernelSize - 1) / 2;
-		auto [xS, yS, zS] = m_Size;
-
-		// Data traverse
-		for (int z = 0; z < zS; ++z)
-		{
-			for (int y = 0; y < yS; ++y)
-			{
-				for (int x = 0; x < xS; ++x)
-				{
-					glm::vec3 sum{ 0.0f };
-					int count = 0;
-					// Convolution
-					for (int k = z - kernelSize; k <= z + kernelSize; k++)
-					{
-						for (int j = y - kernelSize; j <= y + kernelSize; j++)
-						{
-							for (int i = x - kernelSize; i <= x + kernelSize; i++)
-							{
-								int c = GetIndexFrom3D(x, y, z);
-								if (c != -1)
-								{
-									sum.r = m_Data[c].r;
-									sum.g = m_Data[c].g;
-									sum.b = m_Data[c].b;
-									++count;
-								}
-							}
-						}
-					}
-					// End conv
-					sum /= static_cast<float>(count);
-				}
-			}
-		}
+		// Kernel is centered, even sizes are rounded down
+		GradientEngine::BoxAverage(m_Gradient, m_Size, (kernelSize - 1) / 2);
+		// Averaging flattens the peaks, tighter bound keeps more precision of the packed gradient
+		m_GradientMaxMagnitude = ComputeGradientMaxMagnitude();
+		LOG_INFO("Done");
 	}
 
 	void VolumeFile::NormalizeData(int normalizationValue)
@@ -174,12 +148,8 @@ namespace med
 			normalizationValue = GetMaxNumber();
 		}
 
+		// Applied lazily on access, native data are kept as they are
 		m_NormalizationValue = normalizationValue;
-		
-		for (auto& vec : m_Data)
-		{
-			vec.a /= m_NormalizationValue;
-		}
 		m_IsNormalized = true;
 	}
 
@@ -201,61 +171,68 @@ namespace med
 			return;
 		}
 		
-		float maxGradMag = 0.0f;
-
 		LOG_INFO("Computing gradients");
 		auto[xS,yS,zS] = m_Size;
+		m_Gradient.resize(static_cast<size_t>(xS) * yS * zS);
 
-		for (int z = 0; z < zS; ++z)
-		{
-			for (int y = 0; y < yS; ++y)
-			{
-				for (int x = 0; x < xS; ++x)
-				{
-					// Index of point where we are computing the gradient
-					int c = GetIndexFrom3D(x, y, z);
-
-					glm::vec3 p(0.0f), m(0.0f);
-					// X direction
-					m.x = GetVoxelData(x - 1, y, z).a;
-					p.x = GetVoxelData(x + 1, y, z).a;
-					// Y direciton
-					m.y = GetVoxelData(x, y - 1, z).a;
-					p.y = GetVoxelData(x, y + 1, z).a;
-					// Z direciton
-					m.z =  GetVoxelData(x, y, z - 1).a;
-					p.z = GetVoxelData(x, y, z + 1).a;
-					glm::vec3 temp = (-(p - m)) * glm::vec3(0.5); // 1/2h,  h = 1
-					if (normToZeroOne)
-					{
-						float mag = glm::length(temp);
-						if (mag > maxGradMag)
-						{
-							maxGradMag = mag;
-						}
-					}
-					m_Data[c].x = temp.x;
-					m_Data[c].y = temp.y;
-					m_Data[c].z = temp.z;
-				}
-			}
-		}
+		// Slab row kernel streams the linear buffer, it stays faster than the bricked variant (see VoxelLayoutBenchmark)
+		const float maxGradMag = GradientEngine::CentralDifference(m_Data, m_Size, GetDensityScale(), m_Gradient);
+		m_GradientMaxMagnitude = maxGradMag;
 
-		if (normToZeroOne)
+		if (normToZeroOne && maxGradMag > 0.0f)
 		{
 			LOG_INFO("Normalizing gradients to [0,1]");
-			for (auto& v : m_Data)
-			{
-				v.x /= maxGradMag;
-				v.y /= maxGradMag;
-				v.z /= maxGradMag;
-			}
+			ScaleGradient(1.0f / maxGradMag);
 		}
 
 		m_HasGradient = true;
 		LOG_INFO("Done");
 	}
 
+	void VolumeFile::SetGradient(std::vector<glm::vec3> gradient, float maxMagnitude, bool normToZeroOne)
+	{
+		assert(gradient.size() == m_Data.GetVoxelCount() && "Gradient does not match the volume");
+
+		m_Gradient = std::move(gradient);
+		m_GradientMaxMagnitude = maxMagnitude;
+		m_HasGradient = true;
+
+		// Normalized gradient does not depend on the density scale
+		const float factor = normToZeroOne ? (maxMagnitude > 0.0f ? 1.0f / maxMagnitude : 1.0f) : GetDensityScale();
+		if (factor != 1.0f)
+		{
+			ScaleGradient(factor);
+		}
+	}
+
+	void VolumeFile::ScaleGradient(float factor)
+	{
+		base::ThreadPool::Get().ParallelFor(0, m_Gradient.size(), [&](size_t i)
+		{
+			m_Gradient[i] *= factor;
+		}, 1 << 16);
+		m_GradientMaxMagnitude *= factor;
+	}
+
+	float VolumeFile::ComputeGradientMaxMagnitude() const
+	{
+		constexpr size_t chunkSize = 1 << 16;
+		std::vector<float> chunkMax((m_Gradient.size() + chunkSize - 1) / chunkSize, 0.0f);
+
+		base::ThreadPool::Get().ParallelFor(0, chunkMax.size(), [&](size_t chunk)
+		{
+			const size_t end = std::min(m_Gradient.size(), (chunk + 1) * chunkSize);
+			float maxSquared = 0.0f;
+			for (size_t i = chunk * chunkSize; i < end; ++i)
+			{
+				maxSquared = std::max(maxSquared, glm::dot(m_Gradient[i], m_Gradient[i]));
+			}
+			chunkMax[chunk] = maxSquared;
+		});
+
+		return chunkMax.empty() ? 0.0f : std::sqrt(*std::max_element(chunkMax.begin(), chunkMax.end()));
+	}
+
 	std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> VolumeFile::GetSize() const
 	{
 		return m_Size;
@@ -274,14 +251,160 @@ namespace med
 		return m_FileDataType;
 	}
 
-	const void * VolumeFile::GetVoidPtr() const
+	const VoxelBuffer& VolumeFile::GetDensityBuffer() const
 	{
-		return m_Data.data();
+		return m_Data;
 	}
 
-	const std::vector<glm::vec4>& VolumeFile::GetVecReference() const
+	const std::vector<glm::vec3>& VolumeFile::GetGradient() const
 	{
-		return m_Data;
+		return m_Gradient;
+	}
+
+	std::vector<glm::vec4> VolumeFile::CreateTextureData() const
+	{
+		std::vector<glm::vec4> result(m_Data.GetVoxelCount());
+		WriteTextureData(0, std::get<2>(m_Size), std::as_writable_bytes(std::span(result)));
+		return result;
+	}
+
+	void VolumeFile::WriteTextureData(std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const
+	{
+		const std::uint8_t channels = m_Data.GetChannels();
+		const float factor = GetDensityScale();
+		const auto [begin, count] = GetSlabRange(zBegin, depth);
+
+		assert(dst.size() >= count * sizeof(glm::vec4) && "Destination is too small");
+		glm::vec4* result = reinterpret_cast<glm::vec4*>(dst.data());
+		std::fill_n(result, count, glm::vec4(0.0f));
+
+		m_Data.Visit([&](auto data)
+		{
+			if (channels == 1)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					result[i].a = static_cast<float>(data[begin + i]) * factor;
+				}
+			}
+			else
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					for (std::uint8_t c = 0; c < std::min<std::uint8_t>(channels, 4); ++c)
+					{
+						result[i][c] = static_cast<float>(data[(begin + i) * channels + c]) * factor;
+					}
+				}
+			}
+		});
+
+		if (m_HasGradient && channels == 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				result[i].r = m_Gradient[begin + i].r;
+				result[i].g = m_Gradient[begin + i].g;
+				result[i].b = m_Gradient[begin + i].b;
+			}
+		}
+	}
+
+	DensityTexelFormat VolumeFile::GetDensityTexelFormat() const
+	{
+		const bool isInteger = m_FileDataType != FileDataType::Float && m_FileDataType != FileDataType::Double;
+		// Normalized levels are k / range, every level of the range has to stay distinct
+		const int usedBits = std::max(GetMaxUsedBitDepth(), static_cast<int>(std::bit_width(GetDataRange())));
+
+		const DensityTexelFormat format = TexelPacking::ChooseDensityFormat(m_IsNormalized, usedBits, isInteger);
+
+		// Custom normalization value below the maximum leaves densities above 1, unorm would clamp them
+		if (format == DensityTexelFormat::R8Unorm && GetMaxNumber() > GetDataRange())
+		{
+			return DensityTexelFormat::R16Float;
+		}
+		return format;
+	}
+
+	void VolumeFile::WriteDensityTexels(DensityTexelFormat format, std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const
+	{
+		assert(m_Data.GetChannels() == 1 && "Density texels are written from single channel data");
+
+		const std::uint32_t texelBytes = TexelPacking::GetBytesPerTexel(format);
+		const float factor = GetDensityScale();
+		const auto [begin, count] = GetSlabRange(zBegin, depth);
+
+		assert(dst.size() >= count * texelBytes && "Destination is too small");
+
+		m_Data.Visit([&](auto data)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				TexelPacking::PackDensity(format, static_cast<float>(data[begin + i]) * factor, dst.data() + i * texelBytes);
+			}
+		});
+	}
+
+	void VolumeFile::WriteGradientTexels(std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const
+	{
+		const auto [begin, count] = GetSlabRange(zBegin, depth);
+
+		assert(dst.size() >= count * TexelPacking::kGradientTexelBytes && "Destination is too small");
+
+		if (!m_HasGradient)
+		{
+			std::fill_n(dst.begin(), count * TexelPacking::kGradientTexelBytes, std::byte{ 0 });
+			return;
+		}
+
+		const float invMaxMagnitude = m_GradientMaxMagnitude > 0.0f ? 1.0f / m_GradientMaxMagnitude : 0.0f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			TexelPacking::PackGradient(m_Gradient[begin + i], invMaxMagnitude, dst.data() + i * TexelPacking::kGradientTexelBytes);
+		}
+	}
+
+	float VolumeFile::GetGradientMaxMagnitude() const
+	{
+		return m_GradientMaxMagnitude;
+	}
+
+	std::pair<size_t, size_t> VolumeFile::GetSlabRange(std::uint32_t zBegin, std::uint32_t depth) const
+	{
+		const size_t sliceSize = static_cast<size_t>(std::get<0>(m_Size)) * std::get<1>(m_Size);
+		const size_t voxelCount = m_Data.GetVoxelCount();
+		const size_t begin = std::min(zBegin * sliceSize, voxelCount);
+		return { begin, std::min(depth * sliceSize, voxelCount - begin) };
+	}
+
+	void VolumeFile::SetVoxelLayout(VoxelLayout layout)
+	{
+		if (layout == VoxelLayout::Linear)
+		{
+			m_Bricked = {};
+			return;
+		}
+
+		if (m_Data.GetChannels() != 1)
+		{
+			LOG_WARN("Bricked layout is supported for single channel data only, keeping linear layout");
+			return;
+		}
+
+		if (m_Bricked.IsEmpty())
+		{
+			m_Bricked = BrickedVolume(m_Data, m_Size);
+		}
+	}
+
+	VoxelLayout VolumeFile::GetVoxelLayout() const
+	{
+		return m_Bricked.IsEmpty() ? VoxelLayout::Linear : VoxelLayout::Bricked;
+	}
+
+	const BrickedVolume& VolumeFile::GetBrickedDensity() const
+	{
+		return m_Bricked;
 	}
 
 	int VolumeFile::GetIndexFrom3D(int x, int y, int z) const
@@ -311,8 +434,68 @@ namespace med
 		int index = GetIndexFrom3D(x, y, z);
 		if (index != -1)
 		{
-			return m_Data[index];
+			glm::vec3 gradient = m_HasGradient ? m_Gradient[index] : glm::vec3(0.0f);
+			if (!m_Bricked.IsEmpty())
+			{
+				const size_t brickedIndex = m_Bricked.GetIndex(x, y, z);
+				const float value = m_Bricked.Visit([brickedIndex](auto data) { return static_cast<float>(data[brickedIndex]); });
+				return glm::vec4(gradient, m_IsNormalized ? value / static_cast<float>(m_NormalizationValue) : value);
+			}
+			return glm::vec4(gradient, GetDensity(index));
 		}
 		return glm::vec4(0.0f);
 	}
+
+	float VolumeFile::GetDensity(size_t index) const
+	{
+		const float value = m_Data.Get(index);
+		return m_IsNormalized ? value / static_cast<float>(m_NormalizationValue) : value;
+	}
+
+	float VolumeFile::SampleDensity(glm::vec3 position) const
+	{
+		if (!m_Bricked.IsEmpty())
+		{
+			return m_Bricked.Sample(position) * GetDensityScale();
+		}
+
+		assert(m_Data.GetChannels() == 1 && "Density is sampled from single channel data");
+		return m_Data.Visit([&](auto data)
+		{
+			using T = std::remove_cvref_t<decltype(data[0])>;
+			return data.empty() ? 0.0f : SampleLinear(std::span<const T>(data.data(), data.size()), m_Size, position);
+		}) * GetDensityScale();
+	}
+
+	DensityHistogram VolumeFile::ComputeDensityHistogram(size_t binCount) const
+	{
+		assert(m_Data.GetChannels() == 1 && "Histogram is computed from single channel data");
+
+		DensityHistogram histogram;
+		histogram.Range = GetDataRange();
+		histogram.Counts.assign(binCount, 0);
+
+		if (binCount == 0 || histogram.Range == 0)
+		{
+			return histogram;
+		}
+
+		histogram.Counts = HistogramEngine::Compute(m_Data, HistogramBinning::FromRange(binCount, static_cast<double>(histogram.Range)));
+		return histogram;
+	}
+
+	void VolumeFile::SetDensityHistogram(DensityHistogram histogram)
+	{
+		m_Histogram = std::move(histogram);
+	}
+
+	const DensityHistogram& VolumeFile::GetDensityHistogram() const
+	{
+		return m_Histogram;
+	}
+
+	float VolumeFile::GetDensityScale() const
+	{
+		return m_IsNormalized ? 1.0f / static_cast<float>(m_NormalizationValue) : 1.0f;
+	}
 }
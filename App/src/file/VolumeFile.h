@@ -1,7 +1,12 @@
 #pragma once
 #include "FileDataType.h"
+#include "TexelPacking.h"
+#include "VoxelBuffer.h"
+#include "BrickedVolume.h"
 
+#include <cstddef>
 #include <filesystem>
+#include <span>
 #include <utility>
 #include <vector>
 #include <tuple>
@@ -11,27 +16,45 @@
 
 namespace med
 {
+	/**
+	 * @brief Density counts in bins of equal width over [0, Range], values above the range fall into the last bin.
+	 */
+	struct DensityHistogram
+	{
+		std::vector<std::uint32_t> Counts{};
+		size_t Range = 0;
+	};
+
+	/**
+	 * @brief CPU storage backing the random access accessors (GetVoxelData, SampleDensity).
+	 * Linear buffer is kept in both cases, it is the one uploaded to the GPU and streamed by the slab kernels.
+	 */
+	enum class VoxelLayout
+	{
+		Linear,
+		Bricked
+	};
+
 	/**
 	 * @brief Class representing a volume file, this class is used to load and store volume data.
-	 * This class is used to store the data in a contiguous memory, so it can be easily uploaded to the GPU.
-	 * Can be templatized to store different types of data, but for now, this is sufficient.
+	 * Density is stored in a contiguous memory in its native type (see VoxelBuffer), gradient is an optional separate channel.
+	 * GPU friendly representation is created on demand (CreateTextureData).
 	 */
 	class VolumeFile
 	{
 	public:
 		VolumeFile() = default;
+		/**
+		 * @param maxNumber maximum within the data if known (e.g. from the header), if 0 it is computed
+		 */
 		VolumeFile(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size,
-			FileDataType type, std::vector<glm::vec4>& data);
-		VolumeFile(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size,
-			FileDataType type, std::vector<glm::vec4>& data, size_t maxNumber);
+			VoxelBuffer data, size_t maxNumber = 0);
 
 		virtual ~VolumeFile() = default;
 
 	protected:
 
-		void SetData(std::vector<glm::vec4>& src);
-		
-		void SetFileDataType(FileDataType type);
+		void SetData(VoxelBuffer src);
 
 		void SetDataSize(std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size);
 
@@ -48,15 +71,25 @@ namespace med
 		 */
 		void PreComputeGradient(bool normToZeroOne=false);
 		void PreComputeGradientSobel();
+
+		/**
+		 * @brief Takes gradient computed elsewhere (e.g. while loading, see VolumeStreamProcessor), values are in native density units
+		 * and are scaled the same way PreComputeGradient would do it.
+		 * @param maxMagnitude largest gradient magnitude in native units
+		 * @param normToZeroOne if true, the gradient will be normalized to the range [0, 1]
+		 */
+		void SetGradient(std::vector<glm::vec3> gradient, float maxMagnitude, bool normToZeroOne = false);
 		
 		/*
-		* @brief Computes average of the gradient within the kernel.
+		* @brief Smooths the gradient in place, each gradient is replaced by the average within the kernel (box, voxels outside
+		* of the volume are not counted). Cost does not depend on the kernel size.
 		* @param kernelSize: Convolution kernel size
 		*/
 		void AverageGradient(int kernelSize);
 
 		/*
 		* @brief Normalizes the density values to [0, 1] interval.
+		* Data stay in the native type, the factor is applied on access (GetDensity, GetVoxelData, CreateTextureData).
 		* Gradient values are untouched if already pre-computed.
 		* @param normalizationValue: if 0 max number is taken as normalization factor
 		*/
@@ -78,19 +111,57 @@ namespace med
 		[[nodiscard]] FileDataType GetFileType() const;
 		
 		/**
-		* @brief Pointer to the contiguous memory where the data is stored.
+		* @brief Density in its native type.
 		*/
-		[[nodiscard]] const void* GetVoidPtr() const;
+		[[nodiscard]] const VoxelBuffer& GetDensityBuffer() const;
 
-		[[nodiscard]] const std::vector<glm::vec4>& GetVecReference() const;
+		/**
+		* @brief Pre-computed gradient, empty if HasGradient() is false.
+		*/
+		[[nodiscard]] const std::vector<glm::vec3>& GetGradient() const;
+
+		/**
+		* @brief Creates interleaved RGBA32F representation (rgb - gradient, a - density) used by the shaders.
+		* Multi-channel data (mask) are written channel by channel. Buffer is temporary, release it after upload.
+		*/
+		[[nodiscard]] std::vector<glm::vec4> CreateTextureData() const;
+
+		/**
+		* @brief Same representation as CreateTextureData, only for slices [zBegin, zBegin + depth), used to stream
+		* the volume to the GPU by slabs (see Texture::Upload). Thread safe.
+		* @param dst depth slices of RGBA32F texels
+		*/
+		void WriteTextureData(std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const;
+
+		/**
+		* @brief Smallest density format that keeps the precision of the data, chosen from the data type and the used bit depth.
+		* Single channel data only, multi-channel data (mask) stay in the RGBA32F representation.
+		*/
+		[[nodiscard]] DensityTexelFormat GetDensityTexelFormat() const;
+
+		/**
+		* @brief Density only texels of slices [zBegin, zBegin + depth), see TexelPacking::PackDensity. Thread safe.
+		* @param dst depth slices of TexelPacking::GetBytesPerTexel(format) sized texels
+		*/
+		void WriteDensityTexels(DensityTexelFormat format, std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const;
+
+		/**
+		* @brief Gradient only texels (octahedral direction + relative magnitude, see TexelPacking::PackGradient)
+		* of slices [zBegin, zBegin + depth). Thread safe.
+		* @param dst depth slices of TexelPacking::kGradientTexelBytes sized texels
+		*/
+		void WriteGradientTexels(std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst) const;
+
+		/**
+		* @brief Largest magnitude of the pre-computed gradient (1 for the gradient normalized to [0, 1]).
+		*/
+		[[nodiscard]] float GetGradientMaxMagnitude() const;
 
 		/*
 		* @brief Maximum number within the dataset.
 		*/
 		[[nodiscard]] size_t GetMaxNumber() const;
 
-		[[nodiscard]] size_t GetMaxNumber(const std::vector<glm::vec4>& vec, int index = 0) const;
-
 		[[nodiscard]] int GetMaxUsedBitDepth() const;
 
 		/*
@@ -99,8 +170,21 @@ namespace med
 		*/
 		[[nodiscard]] size_t GetDataRange() const;
 
+		/*
+		* @brief Bricked layout builds a bricked copy of the density (see BrickedVolume), single channel data only.
+		* Switching back to Linear frees the copy.
+		*/
+		void SetVoxelLayout(VoxelLayout layout);
+
+		[[nodiscard]] VoxelLayout GetVoxelLayout() const;
+
+		/*
+		* @brief Bricked copy of the density, empty unless the layout is Bricked.
+		*/
+		[[nodiscard]] const BrickedVolume& GetBrickedDensity() const;
+
 		/**
-		 * @brief Maps 3D coordinate to the 1D data.
+		 * @brief Maps 3D coordinate to the 1D data (linear buffer and gradient).
 		 * @param x coordinate
 		 * @param y coordinate
 		 * @param z coordinate
@@ -113,11 +197,57 @@ namespace med
 		 * @param x coordinate
 		 * @param y coordinate
 		 * @param z coordinate
-		 * @return density, if coords are outside of the volume returns vec4(0.0f)
+		 * @return gradient (rgb) and density (a), if coords are outside of the volume returns vec4(0.0f)
 		 */
 		[[nodiscard]] glm::vec4 GetVoxelData(int x, int y, int z) const;
 
+		/**
+		 * @brief Density at 1D index, normalized if NormalizeData was called.
+		 */
+		[[nodiscard]] float GetDensity(size_t index) const;
+
+		/**
+		 * @brief Trilinearly interpolated density at the normalized position (texel centers, clamp to edge as the linear sampler),
+		 * normalized if NormalizeData was called. Reads the bricked copy if the layout is Bricked.
+		 */
+		[[nodiscard]] float SampleDensity(glm::vec3 position) const;
+
+		/**
+		 * @brief Counts of the native density over [0, GetDataRange()], single channel data only.
+		 */
+		[[nodiscard]] DensityHistogram ComputeDensityHistogram(size_t binCount) const;
+
+		/**
+		 * @brief Keeps histogram that is known ahead (e.g. from cache), so it does not have to be computed again.
+		 */
+		void SetDensityHistogram(DensityHistogram histogram);
+
+		/**
+		 * @brief Histogram set by SetDensityHistogram, empty if not known.
+		 */
+		[[nodiscard]] const DensityHistogram& GetDensityHistogram() const;
+
+		/*
+		* @brief Factor that converts native density to the normalized one (1 if not normalized).
+		*/
+		[[nodiscard]] float GetDensityScale() const;
+
 	protected:
+		/*
+		* Multiplies every gradient by the factor.
+		*/
+		void ScaleGradient(float factor);
+
+		/*
+		* Largest magnitude of the current gradient.
+		*/
+		[[nodiscard]] float ComputeGradientMaxMagnitude() const;
+
+		/*
+		* Voxel range [begin, begin + count) covered by slices [zBegin, zBegin + depth), clamped to the volume.
+		*/
+		[[nodiscard]] std::pair<size_t, size_t> GetSlabRange(std::uint32_t zBegin, std::uint32_t depth) const;
+
 		bool m_HasGradient = false;
 		bool m_IsNormalized = false;
 
@@ -129,25 +259,12 @@ namespace med
 		size_t m_MaxNumber = 0;
 		int m_CustomBitWidth = 0;
 		int m_NormalizationValue = 0;
+		float m_GradientMaxMagnitude = 0.0f;
 
-		std::vector<glm::vec4> m_Data{};
-		std::vector<float> m_DataSqueezed{};
-		//TODO: Uploads to the gpu are 4x bigger rn, in the future use templates or when really needed use squeezed arr
-
-		float m_SobelX[3][3][3] = {
-			{ { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } },
-			{ { -2, 0, 2 }, { -4, 0, 4 }, { -2, 0, 2 } },
-			{ { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } }
-		};
-		float m_SobelY[3][3][3] = {
-			{ { -1, -2, -1 }, { 0, 0, 0 }, { 1, 2, 1 } },
-			{ { -2, -4, -2 }, { 0, 0, 0 }, { 2, 4, 2 } },
-			{ { -1, -2, -1 }, { 0, 0, 0 }, { 1, 2, 1 } }
-		};
-		float m_SobelZ[3][3][3] = {
-			{ { -1, -2, -1 }, { -2, -4, -2 }, { -1, -2, -1 } },
-			{ { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } },
-			{ { 1, 2, 1 }, { 2, 4, 2 }, { 1, 2, 1 } }
-		};
+		VoxelBuffer m_Data{};
+		// Empty unless the layout is Bricked
+		BrickedVolume m_Bricked{};
+		std::vector<glm::vec3> m_Gradient{};
+		DensityHistogram m_Histogram{};
 	};
 }
\ No newline at end of file
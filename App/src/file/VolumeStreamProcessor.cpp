@@ -0,0 +1,130 @@
+#include "VolumeStreamProcessor.h"
+#include "GradientEngine.h"
+#include "Base/Base.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <span>
+
+namespace med
+{
+	VolumeStreamProcessor::VolumeStreamProcessor(const VoxelBuffer& data, Size size, VolumePreprocessOptions options) :
+		m_Data(data), m_Size(size), m_Options(options)
+	{
+		assert(data.GetChannels() == 1 && "Only single channel volumes are pre-processed");
+
+		const auto [xS, yS, zS] = size;
+		m_SliceSize = static_cast<std::size_t>(xS) * yS;
+
+		assert(data.GetVoxelCount() == m_SliceSize * zS && "Size does not match the volume");
+
+		m_Loaded = std::make_unique<std::atomic<bool>[]>(zS);
+		m_GradientClaimed = std::make_unique<std::atomic<bool>[]>(zS);
+		for (std::size_t z = 0; z < zS; ++z)
+		{
+			m_Loaded[z] = false;
+			m_GradientClaimed[z] = false;
+		}
+
+		m_SliceMin.assign(zS, std::numeric_limits<double>::max());
+		m_SliceMax.assign(zS, std::numeric_limits<double>::lowest());
+		m_SliceGradientMax.assign(zS, 0.0f);
+
+		if (m_Options.Gradient)
+		{
+			m_Gradient.resize(m_SliceSize * zS);
+		}
+	}
+
+	void VolumeStreamProcessor::OnSlicesLoaded(std::uint32_t zBegin, std::uint32_t count)
+	{
+		const std::uint32_t zEnd = std::min<std::uint32_t>(zBegin + count, std::get<2>(m_Size));
+
+		for (std::uint32_t z = zBegin; z < zEnd; ++z)
+		{
+			ComputeRange(z);
+			m_Loaded[z] = true;
+		}
+
+		// Reported slices can complete the window of their neighbours too
+		for (std::int64_t z = static_cast<std::int64_t>(zBegin) - 1; z <= static_cast<std::int64_t>(zEnd); ++z)
+		{
+			TryComputeGradient(z);
+		}
+	}
+
+	VolumePreprocessResult VolumeStreamProcessor::Finish()
+	{
+		const std::uint32_t zS = std::get<2>(m_Size);
+
+		for (std::uint32_t z = 0; z < zS; ++z)
+		{
+			if (!m_Loaded[z])
+			{
+				LOG_WARN("Slice was not reported by the loader, processing it now");
+				OnSlicesLoaded(z);
+			}
+		}
+
+		VolumePreprocessResult result;
+
+		if (zS > 0 && m_SliceSize > 0)
+		{
+			result.Min = *std::min_element(m_SliceMin.begin(), m_SliceMin.end());
+			result.Max = *std::max_element(m_SliceMax.begin(), m_SliceMax.end());
+		}
+
+		if (m_Options.Gradient)
+		{
+			result.MaxGradientMagnitude = zS > 0 ? *std::max_element(m_SliceGradientMax.begin(), m_SliceGradientMax.end()) : 0.0f;
+			result.Gradient = std::move(m_Gradient);
+		}
+
+		return result;
+	}
+
+	void VolumeStreamProcessor::ComputeRange(std::uint32_t z)
+	{
+		m_Data.Visit([&](auto data)
+		{
+			const auto slice = data.subspan(z * m_SliceSize, m_SliceSize);
+			if (slice.empty())
+			{
+				return;
+			}
+
+			const auto [min, max] = std::ranges::minmax_element(slice);
+			m_SliceMin[z] = static_cast<double>(*min);
+			m_SliceMax[z] = static_cast<double>(*max);
+		});
+	}
+
+	void VolumeStreamProcessor::TryComputeGradient(std::int64_t z)
+	{
+		if (!m_Options.Gradient || z < 0 || z >= std::get<2>(m_Size))
+		{
+			return;
+		}
+
+		// Neighbours outside of the volume count as loaded
+		if (!IsLoaded(z - 1) || !IsLoaded(z) || !IsLoaded(z + 1))
+		{
+			return;
+		}
+
+		if (m_GradientClaimed[z].exchange(true))
+		{
+			return;
+		}
+
+		// Native units, normalization is applied by the volume file once the range is known
+		const std::span<glm::vec3> out(m_Gradient.data() + z * m_SliceSize, m_SliceSize);
+		m_SliceGradientMax[z] = GradientEngine::CentralDifferenceSlice(m_Data, m_Size, static_cast<std::uint32_t>(z), 1.0f, out);
+	}
+
+	bool VolumeStreamProcessor::IsLoaded(std::int64_t z) const
+	{
+		return z < 0 || z >= std::get<2>(m_Size) || m_Loaded[z];
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "VoxelBuffer.h"
+
+#include "glm/glm.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief What should be done with the volume while it is being loaded.
+	 */
+	struct VolumePreprocessOptions
+	{
+		// Density is normalized to [0, 1] (see VolumeFile::NormalizeData), gradient is then in normalized units
+		bool Normalize = false;
+		// Central difference gradient (see VolumeFile::PreComputeGradient)
+		bool Gradient = false;
+		// Gradient is divided by the largest magnitude
+		bool NormalizeGradient = false;
+		// Result is restored from / stored to on-disk cache (see DicomVolumeCache), only for loaders that support it
+		bool UseCache = false;
+	};
+
+	/**
+	 * @brief Value range and gradient gathered while the slices were arriving.
+	 */
+	struct VolumePreprocessResult
+	{
+		double Min = 0.0;
+		double Max = 0.0;
+		// Native density units, empty if it was not requested
+		std::vector<glm::vec3> Gradient{};
+		float MaxGradientMagnitude = 0.0f;
+	};
+
+	/**
+	 * @brief Pre-processes the volume while the loader is filling it, so the data are not walked again once loaded.
+	 * Slices can be reported in any order and from any thread. Min/max of the slice is computed when it is reported
+	 * (data are still in the cache), gradient of slice z is computed as soon as the window z - 1, z, z + 1 is complete,
+	 * by whichever thread completed it.
+	 */
+	class VolumeStreamProcessor
+	{
+	public:
+		using Size = std::tuple<std::uint16_t, std::uint16_t, std::uint16_t>;
+
+		/**
+		 * @param data single channel volume being loaded, has to stay alive (and must not be reallocated) until Finish
+		 */
+		VolumeStreamProcessor(const VoxelBuffer& data, Size size, VolumePreprocessOptions options);
+
+		/**
+		 * @brief Slices [zBegin, zBegin + count) have been written to the volume. Thread safe, each slice is reported once.
+		 */
+		void OnSlicesLoaded(std::uint32_t zBegin, std::uint32_t count = 1);
+
+		/**
+		 * @brief Call once all slices have been reported, slices that were never reported are processed here.
+		 */
+		[[nodiscard]] VolumePreprocessResult Finish();
+
+	private:
+		void ComputeRange(std::uint32_t z);
+
+		/*
+		* Computes gradient of the slice if its window is complete and no one else took it yet.
+		*/
+		void TryComputeGradient(std::int64_t z);
+
+		bool IsLoaded(std::int64_t z) const;
+
+	private:
+		const VoxelBuffer& m_Data;
+		Size m_Size;
+		VolumePreprocessOptions m_Options;
+		std::size_t m_SliceSize = 0;
+
+		// Per slice state, each slice is written by a single thread
+		std::unique_ptr<std::atomic<bool>[]> m_Loaded;
+		std::unique_ptr<std::atomic<bool>[]> m_GradientClaimed;
+		std::vector<double> m_SliceMin;
+		std::vector<double> m_SliceMax;
+		std::vector<float> m_SliceGradientMax;
+
+		std::vector<glm::vec3> m_Gradient;
+	};
+}
@@ -0,0 +1,120 @@
+#include "VoxelBuffer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace med
+{
+	VoxelBuffer::VoxelBuffer(FileDataType type, std::size_t voxelCount, std::uint8_t channels) : m_Channels(channels)
+	{
+		const std::size_t count = voxelCount * channels;
+		switch (type)
+		{
+		case FileDataType::Uint8:
+			m_Storage = std::vector<std::uint8_t>(count, 0);
+			break;
+		case FileDataType::Uint16:
+			m_Storage = std::vector<std::uint16_t>(count, 0);
+			break;
+		case FileDataType::Uint32:
+			m_Storage = std::vector<std::uint32_t>(count, 0);
+			break;
+		case FileDataType::Float:
+			m_Storage = std::vector<float>(count, 0.0f);
+			break;
+		case FileDataType::Double:
+			m_Storage = std::vector<double>(count, 0.0);
+			break;
+		default:
+			assert(false && "VoxelBuffer cannot be allocated with undefined type");
+			break;
+		}
+	}
+
+	VoxelBuffer::VoxelBuffer(FileDataType type, std::span<const std::byte> bytes, std::shared_ptr<const void> owner, std::uint8_t channels) :
+		m_Channels(channels), m_ExternalType(type), m_External(bytes), m_ExternalOwner(std::move(owner))
+	{
+		assert(type != FileDataType::Undefined && "External memory has to have a type");
+	}
+
+	float VoxelBuffer::Get(std::size_t index, std::uint8_t channel) const
+	{
+		assert(channel < m_Channels && "Channel out of bounds");
+		return Visit([&](auto data) -> float
+		{
+			return static_cast<float>(data[index * m_Channels + channel]);
+		});
+	}
+
+	double VoxelBuffer::GetMaxValue(std::uint8_t channel) const
+	{
+		return Visit([&](auto data) -> double
+		{
+			double maxValue = 0.0;
+			for (std::size_t i = channel; i < data.size(); i += m_Channels)
+			{
+				maxValue = std::max(maxValue, static_cast<double>(data[i]));
+			}
+			return maxValue;
+		});
+	}
+
+	FileDataType VoxelBuffer::GetType() const
+	{
+		return IsExternal() ? m_ExternalType : static_cast<FileDataType>(m_Storage.index());
+	}
+
+	std::uint8_t VoxelBuffer::GetChannels() const
+	{
+		return m_Channels;
+	}
+
+	std::size_t VoxelBuffer::GetVoxelCount() const
+	{
+		return Visit([&](auto data) -> std::size_t { return data.size() / m_Channels; });
+	}
+
+	std::uint32_t VoxelBuffer::GetBytesPerElement() const
+	{
+		return Visit([](auto data) -> std::uint32_t { return sizeof(typename decltype(data)::value_type); });
+	}
+
+	std::size_t VoxelBuffer::GetSizeInBytes() const
+	{
+		return Visit([](auto data) -> std::size_t { return data.size_bytes(); });
+	}
+
+	const void* VoxelBuffer::GetVoidPtr() const
+	{
+		return Visit([](auto data) -> const void* { return data.data(); });
+	}
+
+	bool VoxelBuffer::IsEmpty() const
+	{
+		return GetSizeInBytes() == 0;
+	}
+
+	bool VoxelBuffer::IsExternal() const
+	{
+		return m_ExternalType != FileDataType::Undefined;
+	}
+
+	void VoxelBuffer::MakeOwned()
+	{
+		if (!IsExternal())
+		{
+			return;
+		}
+
+		m_Storage = std::as_const(*this).Visit([](auto data) -> Storage
+		{
+			using T = typename decltype(data)::value_type;
+			return std::vector<T>(data.begin(), data.end());
+		});
+
+		m_ExternalType = FileDataType::Undefined;
+		m_External = {};
+		m_ExternalOwner.reset();
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include "FileDataType.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <variant>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Contiguous voxel storage that keeps values in their native type (as they are stored in the file).
+	 * Element type is described by FileDataType, typed access is done through Visit or As<T>.
+	 * Voxels with more than one channel (e.g. 3D mask, one channel per contour) are interleaved.
+	 * Buffer may also view external read-only memory (e.g. memory mapped file), it is copied only when mutable access is requested.
+	 */
+	class VoxelBuffer
+	{
+	public:
+		VoxelBuffer() = default;
+
+		/**
+		 * @brief Allocates zero initialized buffer.
+		 * @param type native type of one channel
+		 * @param voxelCount number of voxels (not elements)
+		 * @param channels number of interleaved channels per voxel
+		 */
+		VoxelBuffer(FileDataType type, std::size_t voxelCount, std::uint8_t channels = 1);
+
+		/**
+		 * @brief Takes ownership of already decoded data, no copy is made.
+		 */
+		template<typename T>
+		explicit VoxelBuffer(std::vector<T>&& data, std::uint8_t channels = 1) : m_Storage(std::move(data)), m_Channels(channels) {}
+
+		/**
+		 * @brief Views external memory without copying it.
+		 * @param type native type of one channel
+		 * @param bytes voxel payload, has to be aligned to the type
+		 * @param owner keeps the memory alive (e.g. memory mapping) as long as the buffer views it
+		 */
+		VoxelBuffer(FileDataType type, std::span<const std::byte> bytes, std::shared_ptr<const void> owner, std::uint8_t channels = 1);
+
+		/**
+		 * @brief Calls f(std::span<const T>) with the native type of the buffer.
+		 * Hot loops should go through this instead of Get, so the type is resolved only once.
+		 */
+		template<typename F>
+		decltype(auto) Visit(F&& f) const;
+
+		/**
+		 * @brief Mutable access, external memory is copied into owned storage first.
+		 */
+		template<typename F>
+		decltype(auto) Visit(F&& f);
+
+		/**
+		 * @brief Typed view, T must match the stored type. Mutable version copies external memory first.
+		 */
+		template<typename T>
+		[[nodiscard]] std::span<const T> As() const;
+
+		template<typename T>
+		[[nodiscard]] std::span<T> As();
+
+		/**
+		 * @brief Value of one channel converted to float, convenient but slow (type is resolved per call).
+		 */
+		[[nodiscard]] float Get(std::size_t index, std::uint8_t channel = 0) const;
+
+		[[nodiscard]] double GetMaxValue(std::uint8_t channel = 0) const;
+
+		[[nodiscard]] FileDataType GetType() const;
+		[[nodiscard]] std::uint8_t GetChannels() const;
+		[[nodiscard]] std::size_t GetVoxelCount() const;
+		[[nodiscard]] std::uint32_t GetBytesPerElement() const;
+		[[nodiscard]] std::size_t GetSizeInBytes() const;
+		[[nodiscard]] const void* GetVoidPtr() const;
+		[[nodiscard]] bool IsEmpty() const;
+
+		/**
+		 * @brief True if the data are viewed, not owned.
+		 */
+		[[nodiscard]] bool IsExternal() const;
+
+	private:
+		/*
+		* Copies external memory into owned storage.
+		*/
+		void MakeOwned();
+
+		template<typename T>
+		[[nodiscard]] std::span<const T> ExternalAs() const;
+
+	private:
+		// Index of the alternative must follow FileDataType
+		using Storage = std::variant<std::monostate, std::vector<std::uint8_t>, std::vector<std::uint16_t>, std::vector<std::uint32_t>,
+			std::vector<float>, std::vector<double>>;
+
+		Storage m_Storage{};
+		std::uint8_t m_Channels = 1;
+
+		// External read-only memory, used instead of m_Storage when m_ExternalType is defined
+		FileDataType m_ExternalType = FileDataType::Undefined;
+		std::span<const std::byte> m_External{};
+		std::shared_ptr<const void> m_ExternalOwner{};
+	};
+
+	template<typename F>
+	decltype(auto) VoxelBuffer::Visit(F&& f) const
+	{
+		if (IsExternal())
+		{
+			switch (m_ExternalType)
+			{
+			case FileDataType::Uint8:
+				return f(ExternalAs<std::uint8_t>());
+			case FileDataType::Uint16:
+				return f(ExternalAs<std::uint16_t>());
+			case FileDataType::Uint32:
+				return f(ExternalAs<std::uint32_t>());
+			case FileDataType::Float:
+				return f(ExternalAs<float>());
+			case FileDataType::Double:
+				return f(ExternalAs<double>());
+			default:
+				return f(std::span<const std::uint8_t>{});
+			}
+		}
+
+		return std::visit([&](const auto& vec) -> decltype(auto)
+		{
+			using V = std::decay_t<decltype(vec)>;
+			if constexpr (std::is_same_v<V, std::monostate>)
+			{
+				return f(std::span<const std::uint8_t>{});
+			}
+			else
+			{
+				return f(std::span<const typename V::value_type>(vec));
+			}
+		}, m_Storage);
+	}
+
+	template<typename F>
+	decltype(auto) VoxelBuffer::Visit(F&& f)
+	{
+		MakeOwned();
+		return std::visit([&](auto& vec) -> decltype(auto)
+		{
+			using V = std::decay_t<decltype(vec)>;
+			if constexpr (std::is_same_v<V, std::monostate>)
+			{
+				return f(std::span<std::uint8_t>{});
+			}
+			else
+			{
+				return f(std::span<typename V::value_type>(vec));
+			}
+		}, m_Storage);
+	}
+
+	template<typename T>
+	std::span<const T> VoxelBuffer::As() const
+	{
+		return Visit([](auto data) -> std::span<const T>
+		{
+			if constexpr (std::is_same_v<typename decltype(data)::value_type, T>)
+			{
+				return data;
+			}
+			else
+			{
+				return {};
+			}
+		});
+	}
+
+	template<typename T>
+	std::span<T> VoxelBuffer::As()
+	{
+		MakeOwned();
+		auto* vec = std::get_if<std::vector<T>>(&m_Storage);
+		return vec != nullptr ? std::span<T>(*vec) : std::span<T>{};
+	}
+
+	template<typename T>
+	std::span<const T> VoxelBuffer::ExternalAs() const
+	{
+		return std::span<const T>(reinterpret_cast<const T*>(m_External.data()), m_External.size() / sizeof(T));
+	}
+}
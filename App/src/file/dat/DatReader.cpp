@@ -1,8 +1,9 @@
 #include "DatReader.h"
 #include "Base/Base.h"
 #include "../FileSystem.h"
+#include "../MappedFile.h"
 
-#include <fstream>
+#include <cstring>
 #include <string>
 #include <sstream>
 
@@ -12,9 +13,10 @@ namespace med
 	{
 		using ushort = unsigned short;
 
-		std::ifstream file(FileSystem::GetDefaultPath() / name, std::ios_base::binary);
+		// File is mapped, voxels are not copied, pages are loaded when the data are accessed
+		auto mapping = MappedFile::Open(FileSystem::GetDefaultPath() / name);
 
-		if (file.fail() || !file.is_open())
+		if (mapping == nullptr)
 		{
 			throw std::exception("Check file");
 		}
@@ -23,8 +25,15 @@ namespace med
 		static_assert(sizeof(ushort) == 2);
 
 		constexpr int HEADER_SIZE = 6;
+		const auto bytes = mapping->GetBytes();
+
+		if (bytes.size() < HEADER_SIZE)
+		{
+			throw std::exception("Check file");
+		}
+
 		ushort dims[3];
-		file.read(reinterpret_cast<char*>(dims), HEADER_SIZE);
+		std::memcpy(dims, bytes.data(), HEADER_SIZE);
 
 		std::stringstream dimsStr;
 		dimsStr << dims[0] << " x " << dims[1] << " x " << dims[2] << "\n";
@@ -32,16 +41,18 @@ namespace med
 		LOG_INFO("Dat File");
 		LOG_INFO(dimsStr.str().c_str());
 
-		const unsigned int res = dims[0] * dims[1] * dims[2];
+		const std::size_t res = static_cast<std::size_t>(dims[0]) * dims[1] * dims[2];
 		assert(res != 0 && "File is empty");
 
-		std::vector<ushort> rawImg(res);
-		std::vector<glm::vec4> data(res);
-
-		file.read(reinterpret_cast<char*>(rawImg.data()), res * 2); // times two since one number is two bytes
-		std::ranges::transform(rawImg, std::back_inserter(data), [](auto& value) { return glm::vec4(value); });
+		// times two since one number is two bytes
+		if (bytes.size() - HEADER_SIZE < res * 2)
+		{
+			LOG_ERROR("Dat file is smaller than its header says");
+			throw std::exception("Check file");
+		}
 
-		// Create new Volume file (more like data class)
-		return VolumeFile(FileSystem::GetDefaultPath() / name, { dims[0], dims[1], dims[2] }, FileDataType::Uint16, data);
+		// Create new Volume file (more like data class), data are kept in the native type and are viewed directly inside the mapping
+		const auto payload = bytes.subspan(HEADER_SIZE, res * 2);
+		return VolumeFile(FileSystem::GetDefaultPath() / name, { dims[0], dims[1], dims[2] }, VoxelBuffer(FileDataType::Uint16, payload, std::move(mapping)));
 	}
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "ContourRasterizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace med
+{
+	namespace
+	{
+		/*
+		* Non-horizontal polygon edge, covers scanlines [FirstRow, LastRow] (half-open in y, shared vertices are counted once).
+		*/
+		struct Edge
+		{
+			int FirstRow = 0;
+			int LastRow = 0;
+			// x at FirstRow and its increment per row
+			float X = 0.0f;
+			float Slope = 0.0f;
+			// +1 for edges going up in y, -1 otherwise
+			int Winding = 0;
+		};
+
+		struct Crossing
+		{
+			float X = 0.0f;
+			int Winding = 0;
+		};
+	}
+
+	void ContourRasterizer::Fill(std::span<const std::vector<glm::vec2>> polygons, int xSize, int ySize, std::span<MaskVolume::Word> slice,
+		FillRule rule)
+	{
+		assert(slice.size() * MaskVolume::kWordBits >= static_cast<size_t>(xSize) * ySize && "Slice does not match its size");
+
+		std::vector<Edge> edges;
+		for (const auto& polygon : polygons)
+		{
+			for (size_t i = 0; i < polygon.size(); ++i)
+			{
+				// Contours are closed, last vertex connects to the first one
+				const glm::vec2 a = polygon[i];
+				const glm::vec2 b = polygon[(i + 1) % polygon.size()];
+				MarkLine(a, b, xSize, ySize, slice);
+
+				const glm::vec2 low = a.y < b.y ? a : b;
+				const glm::vec2 high = a.y < b.y ? b : a;
+				const int firstRow = std::max(static_cast<int>(std::ceil(low.y)), 0);
+				const int lastRow = std::min(static_cast<int>(std::ceil(high.y)) - 1, ySize - 1);
+				if (firstRow > lastRow)
+				{
+					// Horizontal or between two rows, the outline covers it
+					continue;
+				}
+
+				Edge edge;
+				edge.FirstRow = firstRow;
+				edge.LastRow = lastRow;
+				edge.Slope = (high.x - low.x) / (high.y - low.y);
+				edge.X = low.x + (static_cast<float>(firstRow) - low.y) * edge.Slope;
+				edge.Winding = a.y < b.y ? 1 : -1;
+				edges.push_back(edge);
+			}
+		}
+
+		if (edges.empty())
+		{
+			return;
+		}
+
+		// Active edge list, edges enter in the order of their first row
+		std::ranges::sort(edges, {}, &Edge::FirstRow);
+		std::vector<Edge> active;
+		std::vector<Crossing> crossings;
+		size_t next = 0;
+
+		for (int y = edges.front().FirstRow; y < ySize && (next < edges.size() || !active.empty()); ++y)
+		{
+			std::erase_if(active, [y](const Edge& edge) { return edge.LastRow < y; });
+			while (next < edges.size() && edges[next].FirstRow == y)
+			{
+				active.push_back(edges[next++]);
+			}
+
+			crossings.clear();
+			for (Edge& edge : active)
+			{
+				crossings.push_back({ edge.X, edge.Winding });
+				edge.X += edge.Slope;
+			}
+			std::ranges::sort(crossings, {}, &Crossing::X);
+
+			const size_t row = static_cast<size_t>(y) * xSize;
+			auto fillSpan = [&](float from, float to)
+			{
+				const int begin = std::max(static_cast<int>(std::ceil(from)), 0);
+				const int end = std::min(static_cast<int>(std::floor(to)), xSize - 1);
+				if (begin <= end)
+				{
+					MaskVolume::SetBits(slice, row + begin, row + end);
+				}
+			};
+
+			if (rule == FillRule::EvenOdd)
+			{
+				for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+				{
+					fillSpan(crossings[i].X, crossings[i + 1].X);
+				}
+			}
+			else
+			{
+				int winding = 0;
+				for (size_t i = 0; i + 1 < crossings.size(); ++i)
+				{
+					winding += crossings[i].Winding;
+					if (winding != 0)
+					{
+						fillSpan(crossings[i].X, crossings[i + 1].X);
+					}
+				}
+			}
+		}
+	}
+
+	void ContourRasterizer::MarkLine(glm::vec2 start, glm::vec2 end, int xSize, int ySize, std::span<MaskVolume::Word> slice)
+	{
+		int x = static_cast<int>(std::lround(start.x));
+		int y = static_cast<int>(std::lround(start.y));
+		const int xEnd = static_cast<int>(std::lround(end.x));
+		const int yEnd = static_cast<int>(std::lround(end.y));
+
+		const int dx = std::abs(xEnd - x);
+		const int dy = -std::abs(yEnd - y);
+		const int stepX = x < xEnd ? 1 : -1;
+		const int stepY = y < yEnd ? 1 : -1;
+		int error = dx + dy;
+
+		for (;;)
+		{
+			if (x >= 0 && x < xSize && y >= 0 && y < ySize)
+			{
+				const size_t bit = static_cast<size_t>(y) * xSize + x;
+				slice[bit / MaskVolume::kWordBits] |= MaskVolume::Word(1) << (bit % MaskVolume::kWordBits);
+			}
+			if (x == xEnd && y == yEnd)
+			{
+				break;
+			}
+
+			const int error2 = 2 * error;
+			if (error2 >= dy)
+			{
+				error += dy;
+				x += stepX;
+			}
+			if (error2 <= dx)
+			{
+				error += dx;
+				y += stepY;
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "../MaskVolume.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace med
+{
+	enum class FillRule
+	{
+		EvenOdd,
+		NonZero
+	};
+
+	/**
+	 * @brief Scanline rasterization of planar contours given in voxel coordinates of one slice (voxel centers at integer coordinates).
+	 * All polygons of one ROI on one slice are rasterized together, so with the even-odd rule inner contours cut holes.
+	 * Output is one slice of a MaskVolume bit plane, different ROIs and slices can be rasterized in parallel.
+	 */
+	class ContourRasterizer
+	{
+	protected:
+		ContourRasterizer() = default;
+	public:
+		/*
+		* @brief Sets the bit of every voxel whose center lies inside of the polygons, so are bits of voxels the outlines pass through.
+		* @param slice: Bits of xSize * ySize voxels of the slice, x fastest (MaskVolume::GetSliceBits)
+		*/
+		static void Fill(std::span<const std::vector<glm::vec2>> polygons, int xSize, int ySize, std::span<MaskVolume::Word> slice,
+			FillRule rule = FillRule::EvenOdd);
+
+	private:
+		/*
+		* Bresenham line between the voxels nearest to the end points, voxels outside of the slice are skipped.
+		*/
+		static void MarkLine(glm::vec2 start, glm::vec2 end, int xSize, int ySize, std::span<MaskVolume::Word> slice);
+	};
+}
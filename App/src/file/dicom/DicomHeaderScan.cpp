@@ -0,0 +1,286 @@
+#include "DicomHeaderScan.h"
+
+#include "DicomParseUtil.h"
+
+#include <charconv>
+#include <fstream>
+#include <string>
+
+namespace med
+{
+	namespace
+	{
+		constexpr std::uint32_t kMetaGroupLengthTag = 0x00020000;
+		constexpr std::uint32_t kTransferSyntaxTag = 0x00020010;
+		constexpr std::uint32_t kInstanceNumberTag = 0x00200013;
+		constexpr std::uint32_t kImagePositionPatientTag = 0x00200032;
+		constexpr std::uint32_t kBitsAllocatedTag = 0x00280100;
+		constexpr std::uint32_t kPixelRepresentationTag = 0x00280103;
+		constexpr std::uint32_t kPixelDataTag = 0x7FE00010;
+		constexpr std::uint32_t kItemDelimitationTag = 0xFFFEE00D;
+		constexpr std::uint32_t kSequenceDelimitationTag = 0xFFFEE0DD;
+		constexpr std::uint32_t kUndefinedLength = 0xFFFFFFFF;
+		// Guards against corrupted files with endlessly nested sequences
+		constexpr int kMaxSequenceDepth = 32;
+
+		const std::string kImplicitVRLittleEndian = "1.2.840.10008.1.2";
+		const std::string kExplicitVRLittleEndian = "1.2.840.10008.1.2.1";
+		const std::string kDeflatedExplicitVRLittleEndian = "1.2.840.10008.1.2.1.99";
+		const std::string kExplicitVRBigEndian = "1.2.840.10008.1.2.2";
+
+		struct ElementHeader
+		{
+			std::uint32_t Tag = 0;
+			std::uint32_t Length = 0;
+		};
+
+		bool ReadU16(std::ifstream& in, std::uint16_t& value)
+		{
+			unsigned char b[2];
+			if (!in.read(reinterpret_cast<char*>(b), 2))
+			{
+				return false;
+			}
+			value = static_cast<std::uint16_t>(b[0] | (b[1] << 8));
+			return true;
+		}
+
+		bool ReadU32(std::ifstream& in, std::uint32_t& value)
+		{
+			unsigned char b[4];
+			if (!in.read(reinterpret_cast<char*>(b), 4))
+			{
+				return false;
+			}
+			value = static_cast<std::uint32_t>(b[0]) | (static_cast<std::uint32_t>(b[1]) << 8) |
+				(static_cast<std::uint32_t>(b[2]) << 16) | (static_cast<std::uint32_t>(b[3]) << 24);
+			return true;
+		}
+
+		bool ReadElementHeader(std::ifstream& in, bool explicitVR, ElementHeader& header)
+		{
+			std::uint16_t group = 0;
+			std::uint16_t element = 0;
+			if (!ReadU16(in, group) || !ReadU16(in, element))
+			{
+				return false;
+			}
+			header.Tag = (static_cast<std::uint32_t>(group) << 16) | element;
+
+			// Items and delimiters never have VR
+			if (!explicitVR || group == 0xFFFE)
+			{
+				return ReadU32(in, header.Length);
+			}
+
+			char vr[2];
+			if (!in.read(vr, 2))
+			{
+				return false;
+			}
+
+			const std::string vrStr(vr, 2);
+			const bool hasLongLength = vrStr == "OB" || vrStr == "OD" || vrStr == "OF" || vrStr == "OL" || vrStr == "OV" ||
+				vrStr == "OW" || vrStr == "SQ" || vrStr == "SV" || vrStr == "UC" || vrStr == "UN" || vrStr == "UR" || vrStr == "UT" || vrStr == "UV";
+
+			if (hasLongLength)
+			{
+				in.seekg(2, std::ios::cur); // reserved
+				return ReadU32(in, header.Length);
+			}
+
+			std::uint16_t length = 0;
+			if (!ReadU16(in, length))
+			{
+				return false;
+			}
+			header.Length = length;
+			return true;
+		}
+
+		bool ReadValue(std::ifstream& in, std::uint32_t length, std::string& value)
+		{
+			value.resize(length);
+			if (!in.read(value.data(), length))
+			{
+				return false;
+			}
+			// Values are padded with space or null to even length
+			while (!value.empty() && (value.back() == ' ' || value.back() == '\0'))
+			{
+				value.pop_back();
+			}
+			return true;
+		}
+
+		/*
+		* Skips content of sequence or item with undefined length, stops after its delimitation item.
+		*/
+		bool SkipUndefinedLength(std::ifstream& in, bool explicitVR, int depth)
+		{
+			if (depth > kMaxSequenceDepth)
+			{
+				return false;
+			}
+
+			ElementHeader header;
+			while (ReadElementHeader(in, explicitVR, header))
+			{
+				if (header.Tag == kItemDelimitationTag || header.Tag == kSequenceDelimitationTag)
+				{
+					return true;
+				}
+
+				if (header.Length == kUndefinedLength)
+				{
+					if (!SkipUndefinedLength(in, explicitVR, depth + 1))
+					{
+						return false;
+					}
+				}
+				else
+				{
+					in.seekg(header.Length, std::ios::cur);
+				}
+			}
+			return false;
+		}
+	}
+
+	std::optional<DicomSliceHeader> DicomHeaderScan::Scan(const std::filesystem::path& path)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+		{
+			return std::nullopt;
+		}
+
+		// Preamble (128 bytes) and DICM prefix
+		char prefix[4];
+		in.seekg(128, std::ios::beg);
+		if (!in.read(prefix, 4) || std::string(prefix, 4) != "DICM")
+		{
+			return std::nullopt;
+		}
+
+		// File meta information is always explicit VR little endian, its size is in the first element
+		ElementHeader header;
+		std::uint32_t metaLength = 0;
+		if (!ReadElementHeader(in, true, header) || header.Tag != kMetaGroupLengthTag || !ReadU32(in, metaLength))
+		{
+			return std::nullopt;
+		}
+
+		const std::streamoff metaEnd = static_cast<std::streamoff>(in.tellg()) + metaLength;
+		std::string transferSyntax{};
+
+		while (in.tellg() < metaEnd && ReadElementHeader(in, true, header))
+		{
+			if (header.Tag == kTransferSyntaxTag)
+			{
+				if (!ReadValue(in, header.Length, transferSyntax))
+				{
+					return std::nullopt;
+				}
+			}
+			else
+			{
+				in.seekg(header.Length, std::ios::cur);
+			}
+		}
+
+		if (transferSyntax == kDeflatedExplicitVRLittleEndian || transferSyntax == kExplicitVRBigEndian || !in)
+		{
+			return std::nullopt;
+		}
+
+		in.seekg(metaEnd, std::ios::beg);
+		const bool explicitVR = transferSyntax != kImplicitVRLittleEndian;
+
+		DicomSliceHeader result{};
+		result.Path = path;
+
+		std::string value{};
+		while (ReadElementHeader(in, explicitVR, header))
+		{
+			if (header.Tag == kPixelDataTag)
+			{
+				// Undefined length means encapsulated (compressed) fragments
+				result.PixelDataOffset = static_cast<std::uint64_t>(in.tellg());
+				result.PixelDataLength = header.Length;
+				result.IsRawPixelData = header.Length != kUndefinedLength &&
+					(transferSyntax == kImplicitVRLittleEndian || transferSyntax == kExplicitVRLittleEndian);
+				return result;
+			}
+
+			if (header.Length == kUndefinedLength)
+			{
+				if (!SkipUndefinedLength(in, explicitVR, 0))
+				{
+					return std::nullopt;
+				}
+				continue;
+			}
+
+			if (header.Tag == kInstanceNumberTag)
+			{
+				int number = 0;
+				if (!ReadValue(in, header.Length, value))
+				{
+					return std::nullopt;
+				}
+				const auto first = value.find_first_not_of(' ');
+				if (first != std::string::npos)
+				{
+					const auto [ptr, ec] = std::from_chars(value.data() + first, value.data() + value.size(), number);
+					if (ec == std::errc())
+					{
+						result.InstanceNumber = number;
+					}
+				}
+			}
+			else if ((header.Tag == kBitsAllocatedTag || header.Tag == kPixelRepresentationTag) && header.Length == 2)
+			{
+				std::uint16_t number = 0;
+				if (!ReadU16(in, number))
+				{
+					return std::nullopt;
+				}
+				(header.Tag == kBitsAllocatedTag ? result.BitsAllocated : result.PixelRepresentation) = number;
+			}
+			else if (header.Tag == kImagePositionPatientTag)
+			{
+				if (!ReadValue(in, header.Length, value))
+				{
+					return std::nullopt;
+				}
+				result.ImagePositionPatient = ParseStringToNumArr<double, 3>(value);
+			}
+			else
+			{
+				in.seekg(header.Length, std::ios::cur);
+			}
+		}
+
+		// File without pixel data
+		return std::nullopt;
+	}
+
+	bool DicomHeaderScan::ReadPixelData(const DicomSliceHeader& header, std::span<std::byte> dst)
+	{
+		// Odd sized values are padded by one byte
+		if (!header.IsRawPixelData || header.PixelDataLength < dst.size() || header.PixelDataLength > dst.size() + 1)
+		{
+			return false;
+		}
+
+		std::ifstream in(header.Path, std::ios::binary);
+		if (!in)
+		{
+			return false;
+		}
+
+		in.seekg(static_cast<std::streamoff>(header.PixelDataOffset), std::ios::beg);
+		return static_cast<bool>(in.read(reinterpret_cast<char*>(dst.data()), static_cast<std::streamsize>(dst.size())));
+	}
+}
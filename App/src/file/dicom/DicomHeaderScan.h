@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+
+namespace med
+{
+	/**
+	 * @brief Information about one slice gathered without loading the whole file.
+	 */
+	struct DicomSliceHeader
+	{
+		std::filesystem::path Path{};
+		std::optional<int> InstanceNumber{};							// (0020,0013) Instance Number
+		std::array<double, 3> ImagePositionPatient{ 0.0 };				// (0020,0032) Image Position (Patient)
+		std::optional<std::uint16_t> BitsAllocated{};					// (0028,0100) Bits Allocated
+		std::optional<std::uint16_t> PixelRepresentation{};				// (0028,0103) Pixel Representation
+		std::uint64_t PixelDataOffset = 0;								// Byte offset of (7FE0,0010) Pixel Data value
+		std::uint64_t PixelDataLength = 0;
+		// Uncompressed little endian pixel data with defined length, value can be read as is
+		bool IsRawPixelData = false;
+	};
+
+	/**
+	 * @brief Minimal DICOM parser that walks data elements only until Pixel Data (7FE0,0010), values of
+	 * other elements are skipped (seek), so only the header bytes are read from disk.
+	 * Supports Part 10 files (preamble + DICM) in implicit/explicit VR little endian and compressed transfer
+	 * syntaxes with explicit VR little endian data set (pixel data are then flagged as not raw).
+	 */
+	class DicomHeaderScan
+	{
+	public:
+		/**
+		 * @brief Scans the header of the file.
+		 * @return std::nullopt if the file is not Part 10 file or the transfer syntax is not supported (deflate, big endian)
+		 */
+		[[nodiscard]] static std::optional<DicomSliceHeader> Scan(const std::filesystem::path& path);
+
+		/**
+		 * @brief Reads bulk pixel bytes found by Scan directly into dst, nothing is decoded (host is expected to be little endian).
+		 * @return false if pixel data are not raw or their size does not match dst
+		 */
+		[[nodiscard]] static bool ReadPixelData(const DicomSliceHeader& header, std::span<std::byte> dst);
+	};
+}
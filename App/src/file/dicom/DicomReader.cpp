@@ -1,11 +1,14 @@
 #include "DicomReader.h"
+#include "DicomVolumeCache.h"
 
 #include "Base/Log.h"
+#include "Base/ThreadPool.h"
 #include "VolumeFileDcm.h"
 #include "StructureFileDcm.h"
 #include "dcm/defs.h"
 #include "DicomParams.h"
 #include "DicomParseUtil.h"
+#include "DicomHeaderScan.h"
 #include "StructVisitor.h"
 #include "../FileSystem.h"
 
@@ -13,6 +16,7 @@
 #include <cassert>
 #include <string>
 #include <cctype>
+#include <algorithm>
 
 namespace med
 {
@@ -23,13 +27,13 @@ namespace med
 	const dcm::Tag kFrameOfReference = 0x00200052;
 	const dcm::Tag kLargestPixelValue = 0x00280107;
 	const dcm::Tag kSmallestPixelValue = 0x00280106;
+	const dcm::Tag kPixelRepresentation = 0x00280103;
 
 
 
-	std::shared_ptr<VolumeFileDcm> DicomReader::ReadVolumeFile(std::filesystem::path name)
+	std::shared_ptr<VolumeFileDcm> DicomReader::ReadVolumeFile(std::filesystem::path name, VolumePreprocessOptions options)
 	{
 		DicomReader reader;
-		bool firstRun = true; // First file
 
 		// Full path
 		name = FileSystem::GetDefaultPath() / name;
@@ -37,12 +41,12 @@ namespace med
 		// Init
 		bool isDir = FileSystem::IsDirectory(name);
 		bool hasSoloFile = false;
-		std::vector<std::filesystem::path> paths;
+		std::vector<std::filesystem::path> files;
+		std::vector<DicomSliceHeader> slices;
 
 		if (isDir)
 		{
-			paths = SortDicomSlices(FileSystem::ListDirFiles(name, /*extension=*/".dcm"));
-			hasSoloFile = paths.size() == 1;
+			files = FileSystem::ListDirFiles(name, /*extension=*/".dcm");
 		}
 		else
 		{
@@ -52,10 +56,53 @@ namespace med
 				throw std::exception("Error!");
 			}
 
-			paths.push_back(name);
+			files.push_back(name);
 		}
 
-		std::size_t numberOfFiles = paths.size();
+		// Builds the file the same way whether the data come from the series or from the cache
+		auto createVolumeFile = [&](const DicomVolumeParams& params, VoxelBuffer data, double maxValue)
+		{
+			std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size = { params.X, params.Y, params.Z };
+			auto file = std::make_shared<VolumeFileDcm>(FileSystem::GetDefaultPath() / name, size, params, std::move(data),
+				static_cast<std::size_t>(maxValue));
+
+			if (options.Normalize)
+			{
+				file->NormalizeData();
+			}
+			return file;
+		};
+
+		std::optional<std::uint64_t> cacheKey;
+		if (options.UseCache && !files.empty())
+		{
+			cacheKey = DicomVolumeCache::ComputeKey(files, options);
+
+			if (auto cached = DicomVolumeCache::Load(*cacheKey); cached.has_value())
+			{
+				LOG_INFO("Volume restored from cache");
+				auto file = createVolumeFile(cached->Params, std::move(cached->Density), cached->Preprocessed.Max);
+				file->SetDensityHistogram(std::move(cached->Histogram));
+
+				if (options.Gradient)
+				{
+					file->SetGradient(std::move(cached->Preprocessed.Gradient), cached->Preprocessed.MaxGradientMagnitude, options.NormalizeGradient);
+				}
+				return file;
+			}
+		}
+
+		if (isDir)
+		{
+			slices = ScanDicomSlices(files);
+			hasSoloFile = slices.size() == 1;
+		}
+		else
+		{
+			slices.push_back(DicomSliceHeader{ .Path = name });
+		}
+
+		std::size_t numberOfFiles = slices.size();
 
 		if (numberOfFiles == 0)
 		{
@@ -64,37 +111,98 @@ namespace med
 		}
 
 
-		// Reading
-		for (const auto& file : paths)
+		// Reading, first file (serially) provides the parameters and the size of the volume
+		std::uint16_t pixelRepresentation = 0;
 		{
-			dcm::DicomFile f(file.c_str());
+			dcm::DicomFile f(slices[0].Path.c_str());
 
-			if (f.Load())
+			if (!f.Load())
 			{
-				if (firstRun)
-				{
-					reader.ReadDicomVolumeVariables(f);
-					reader.m_Params.Modality = ResolveModality(f.GetString(dcm::tags::kModality));
-					reader.PreAllocateMemory(numberOfFiles, isDir);
-				}
-				firstRun = false;
-
-				reader.ReadData(f);
+				LOG_ERROR("Cannot continue, unable to open: ", slices[0].Path.string());
+				throw std::exception("Error!");
 			}
-			else
+
+			reader.ReadDicomVolumeVariables(f);
+			f.GetUint16(kPixelRepresentation, &pixelRepresentation);
+			reader.m_Params.Modality = ResolveModality(f.GetString(dcm::tags::kModality));
+			reader.PreAllocateMemory(numberOfFiles, isDir);
+			reader.ReadData(f, 0);
+		}
+
+		// Raw pixel bytes are copied as they are, so every slice has to store its pixels the same way as the first one
+		// (mandatory attributes, raw slice without them is rejected as well)
+		for (std::size_t i = 1; i < numberOfFiles; ++i)
+		{
+			const auto& slice = slices[i];
+			const bool sameBits = slice.BitsAllocated ? *slice.BitsAllocated == reader.m_Params.BitsAllocated : !slice.IsRawPixelData;
+			const bool sameRepresentation = slice.PixelRepresentation ? *slice.PixelRepresentation == pixelRepresentation : !slice.IsRawPixelData;
+			if (!sameBits || !sameRepresentation)
 			{
-				LOG_ERROR("Cannot continue, unable to open: ", file.string());
+				std::string err = "Cannot continue, pixel format differs from the first slice: " + slice.Path.string();
+				LOG_ERROR(err.c_str());
 				throw std::exception("Error!");
 			}
 		}
 
+		// Final depth of the volume is given by the allocation (frames of one file or one frame per file)
+		const std::size_t frameSize = static_cast<std::size_t>(reader.m_Params.X) * reader.m_Params.Y;
+		const std::size_t depth = frameSize != 0 ? reader.m_Data.GetVoxelCount() / frameSize : 0;
+		const std::uint32_t framesPerFile = std::max<std::uint32_t>(reader.m_Params.Z, 1);
+		VolumeStreamProcessor processor(reader.m_Data, { reader.m_Params.X, reader.m_Params.Y, static_cast<std::uint16_t>(depth) }, options);
+		processor.OnSlicesLoaded(0, framesPerFile);
+
+		// Remaining slices are decoded in parallel, each one is written at its own z-offset.
+		// Headers were already scanned, so raw pixel data are read as bulk bytes without parsing the file again.
+		// Decoded slices are handed to the processor right away, while they are still in the cache.
+		const std::size_t sliceVoxels = frameSize * reader.m_Params.Z;
+		std::vector<std::uint8_t> loaded(numberOfFiles, 1);
+
+		base::ThreadPool::Get().ParallelFor(1, numberOfFiles, [&](std::size_t i)
+		{
+			if (!reader.ReadRawData(slices[i], i * sliceVoxels))
+			{
+				// Compressed or unusual file, full load
+				dcm::DicomFile f(slices[i].Path.c_str());
+
+				if (!f.Load())
+				{
+					loaded[i] = 0;
+					return;
+				}
+
+				reader.ReadData(f, i * sliceVoxels);
+			}
+
+			processor.OnSlicesLoaded(static_cast<std::uint32_t>(i * framesPerFile), framesPerFile);
+		});
+
+		if (auto it = std::ranges::find(loaded, 0); it != loaded.end())
+		{
+			LOG_ERROR("Cannot continue, unable to open: ", slices[std::distance(loaded.begin(), it)].Path.string());
+			throw std::exception("Error!");
+		}
+
 		if (isDir && !hasSoloFile)
 		{
 			reader.m_Params.Z = numberOfFiles;
 		}
 
-		std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size = { reader.m_Params.X, reader.m_Params.Y, reader.m_Params.Z };
-		return std::make_shared<VolumeFileDcm>(FileSystem::GetDefaultPath() / name, size, reader.m_FileDataType, reader.m_Params, reader.m_Data);
+		auto preprocessed = processor.Finish();
+		auto file = createVolumeFile(reader.m_Params, std::move(reader.m_Data), preprocessed.Max);
+
+		// Cache keeps the gradient in native units, it is scaled below
+		if (cacheKey.has_value())
+		{
+			file->SetDensityHistogram(file->ComputeDensityHistogram(DicomVolumeCache::kHistogramBins));
+			DicomVolumeCache::Store(*cacheKey, reader.m_Params, file->GetDensityBuffer(), preprocessed, file->GetDensityHistogram());
+		}
+
+		if (options.Gradient)
+		{
+			file->SetGradient(std::move(preprocessed.Gradient), preprocessed.MaxGradientMagnitude, options.NormalizeGradient);
+		}
+
+		return file;
 	}
 
 	std::shared_ptr<StructureFileDcm> DicomReader::ReadStructFile(std::filesystem::path name)
@@ -221,30 +329,40 @@ namespace med
 
 	bool DicomReader::PreAllocateMemory(std::size_t frames, bool isDir)
 	{
-		// Pre-allocating
-		m_Data.reserve(m_Params.X * m_Params.Y * (isDir ? frames : m_Params.Z));
+		// Pre-allocating, slices are then written directly at their offset
+		m_Data = VoxelBuffer(m_FileDataType, static_cast<std::size_t>(m_Params.X) * m_Params.Y * (isDir ? frames : m_Params.Z));
 
-		return true;
+		return !m_Data.IsEmpty();
 	}
 
-	void DicomReader::ReadData(const dcm::DicomFile& f)
+	void DicomReader::ReadData(const dcm::DicomFile& f, std::size_t voxelOffset)
 	{
+		// Copies decoded frame(s) into the pre-allocated buffer, never past the frame(s) of this file,
+		// so concurrent calls with different offsets do not overlap
+		auto writeFrames = [&](const auto& vec)
+		{
+			using T = typename std::decay_t<decltype(vec)>::value_type;
+			const std::size_t frameVoxels = static_cast<std::size_t>(m_Params.X) * m_Params.Y * m_Params.Z;
+			assert(vec.size() == frameVoxels && "Expected resolution of image does not match with loaded one");
+			auto dst = m_Data.As<T>().subspan(voxelOffset);
+			const std::size_t count = std::min({ vec.size(), dst.size(), frameVoxels });
+			std::copy_n(vec.begin(), count, dst.begin());
+		};
+
 		switch (m_FileDataType)
 		{
 		case FileDataType::Uint16:
 		{
 			std::vector<std::uint16_t> vec;
 			f.GetUint16Array(dcm::tags::kPixelData, &vec);
-			assert(vec.size() == (m_Params.X * m_Params.Y * m_Params.Z) && "Expected resolution of image does not match with loaded one");
-			std::ranges::transform(vec, std::back_inserter(m_Data), [](auto& value) { return glm::vec4(value); });
+			writeFrames(vec);
 			break;
 		}
 		case FileDataType::Uint32:
 		{
 			std::vector<std::uint32_t> vec;
 			f.GetUint32Array(dcm::tags::kPixelData, &vec);
-			assert(vec.size() == (m_Params.X * m_Params.Y * m_Params.Z) && "Expected resolution of image does not match with loaded one");
-			std::ranges::transform(vec, std::back_inserter(m_Data), [](auto& value) { return glm::vec4(value); });
+			writeFrames(vec);
 			break;
 		}
 		case FileDataType::Double:
@@ -254,46 +372,66 @@ namespace med
 		}
 	}
 
-	std::vector<std::filesystem::path> DicomReader::SortDicomSlices(const std::vector<std::filesystem::path>& paths)
+	bool DicomReader::ReadRawData(const DicomSliceHeader& slice, std::size_t voxelOffset)
 	{
-		if (paths.size() < 2)
+		const std::size_t frameVoxels = static_cast<std::size_t>(m_Params.X) * m_Params.Y * m_Params.Z;
+
+		return m_Data.Visit([&](auto data) -> bool
 		{
-			return paths;
-		}
+			if (voxelOffset + frameVoxels > data.size())
+			{
+				return false;
+			}
+			return DicomHeaderScan::ReadPixelData(slice, std::as_writable_bytes(data.subspan(voxelOffset, frameVoxels)));
+		});
+	}
 
-		std::vector< std::pair<int, std::filesystem::path> > pairs;
+	std::vector<std::filesystem::path> DicomReader::SortDicomSlices(const std::vector<std::filesystem::path>& paths)
+	{
 		std::vector<std::filesystem::path> result;
+		std::ranges::transform(ScanDicomSlices(paths), std::back_inserter(result), [](const auto& slice) { return slice.Path; });
+		return result;
+	}
+
+	std::vector<DicomSliceHeader> DicomReader::ScanDicomSlices(const std::vector<std::filesystem::path>& paths)
+	{
+		std::vector<DicomSliceHeader> slices(paths.size());
 
-		// Assigns passed reference slice number, returns false when fails
-		auto retrieveOrder = [&](const std::filesystem::path& path) -> void
+		// Header only scan, parsing stops at the pixel data. Files the scanner does not understand are loaded fully.
+		base::ThreadPool::Get().ParallelFor(0, paths.size(), [&](std::size_t i)
 		{
-			std::string value;
-			dcm::DicomFile f(path.c_str());
-			if (f.Load() && !f.GetString(kInstanceNumber, &value))
+			if (auto header = DicomHeaderScan::Scan(paths[i]); header.has_value())
 			{
-				LOG_ERROR("Error missing instnace number in dicom file");
+				slices[i] = std::move(*header);
 				return;
 			}
-			int order = std::stoi(value);
-			pairs.emplace_back(order, path);
-		};
 
-		// Initialize each file with its relative position within the directory
-		std::ranges::for_each(paths, retrieveOrder);
+			slices[i].Path = paths[i];
+			std::string value;
+			dcm::DicomFile f(paths[i].c_str());
+			if (f.Load() && f.GetString(kInstanceNumber, &value))
+			{
+				slices[i].InstanceNumber = ParseStringToNumArr<int, 1>(value)[0];
+			}
+		});
 
-		if (paths.size() != pairs.size())
+		if (slices.size() < 2)
 		{
+			return slices;
+		}
+
+		if (!std::ranges::all_of(slices, [](const auto& slice) { return slice.InstanceNumber.has_value(); }))
+		{
+			LOG_ERROR("Error missing instnace number in dicom file");
 			LOG_WARN("Default order of path is going to be used.");
-			return paths;
+			return slices;
 		}
 
 		// Sort them in ascending order
-		std::ranges::sort(pairs, [](const auto& pair1, const auto& pair2) { return pair1.first < pair2.first; });
-		// Transform it to the final result
-		std::ranges::transform(pairs, std::back_inserter(result), [](const auto& pair) {return pair.second; });
+		std::ranges::sort(slices, [](const auto& slice1, const auto& slice2) { return *slice1.InstanceNumber < *slice2.InstanceNumber; });
 
 		LOG_TRACE("DICOM sorting success");
-		return result;
+		return slices;
 	}
 
 	void DicomReader::ResolveFileType()
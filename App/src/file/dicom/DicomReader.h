@@ -3,6 +3,8 @@
 #include "VolumeFileDcm.h"
 #include "StructureFileDcm.h"
 #include "DicomParams.h"
+#include "DicomHeaderScan.h"
+#include "../VolumeStreamProcessor.h"
 
 #include "dcm/dicom_file.h"
 
@@ -19,10 +21,12 @@ namespace med
 	public:
 		/**
 		 * @brief Reads the dicom file and stores the data in the VolumeFileDcm object, used for parsing image data
+		 * Value range and requested pre-processing are computed while the slices are being decoded (see VolumeStreamProcessor).
 		 * @param name path to the file
+		 * @param options pre-processing done during loading, result is the same as calling NormalizeData / PreComputeGradient later
 		 * @return VolumeFileDcm object with the data
 		 */
-		[[nodiscard]] static std::shared_ptr<VolumeFileDcm> ReadVolumeFile(std::filesystem::path name);
+		[[nodiscard]] static std::shared_ptr<VolumeFileDcm> ReadVolumeFile(std::filesystem::path name, VolumePreprocessOptions options = {});
 
 		/**
 		 * @brief Reads the dicom file and stores the data in the StructureFile object, is used for parsing contours
@@ -56,6 +60,15 @@ namespace med
 		 */
 		[[nodiscard]] static std::vector<std::filesystem::path> SortDicomSlices(const std::vector<std::filesystem::path>& paths);
 
+		/**
+		 * @brief Scans headers of the dicom files (parsing stops before pixel data) and sorts them by the Instance number tag,
+		 * if one file is missing this tag, original order is kept. Pixel data offsets are recorded, so they can be read later
+		 * without parsing the file again.
+		 * @param paths dicom files
+		 * @return slice headers in ascending order
+		 */
+		[[nodiscard]] static std::vector<DicomSliceHeader> ScanDicomSlices(const std::vector<std::filesystem::path>& paths);
+
 		[[nodiscard]] static bool IsDicomFile(const std::filesystem::path& path);
 
 	private:
@@ -71,10 +84,19 @@ namespace med
 		bool PreAllocateMemory(std::size_t frames, bool isDir);
 		
 		/**
-		 * @brief Reads data into allocated memory (stored within the class to avoid copying)
+		 * @brief Reads data into allocated memory (stored within the class to avoid copying), data are kept in the native type
+		 * Thread safe as long as the calls write to different offsets.
 		 * @param f opened dicom file
+		 * @param voxelOffset where the frame(s) of this file start within the volume
+		 */
+		void ReadData(const dcm::DicomFile& f, std::size_t voxelOffset);
+
+		/**
+		 * @brief Reads uncompressed pixel data of the scanned slice straight into allocated memory, file is not parsed again.
+		 * Thread safe as long as the calls write to different offsets.
+		 * @return false if the pixel data cannot be read as bulk bytes, full load is needed
 		 */
-		void ReadData(const dcm::DicomFile& f);
+		[[nodiscard]] bool ReadRawData(const DicomSliceHeader& slice, std::size_t voxelOffset);
 
 		/**
 		 * @brief Initiliazes file type based on allocated bits tag in dicom file.
@@ -84,6 +106,6 @@ namespace med
 	private:
 		DicomVolumeParams m_Params;
 		FileDataType m_FileDataType = FileDataType::Undefined;
-		std::vector<glm::vec4> m_Data{};
+		VoxelBuffer m_Data{};
 	};
 }
\ No newline at end of file
@@ -0,0 +1,329 @@
+#include "DicomVolumeCache.h"
+#include "Base/Base.h"
+#include "Base/ThreadPool.h"
+#include "../FileSystem.h"
+#include "../MappedFile.h"
+#include "../BinaryStream.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace med
+{
+	namespace
+	{
+		constexpr std::array<char, 4> kMagic = { 'V', 'R', 'V', 'C' };
+		// Written in native order, file created on machine with other endianness is rejected
+		constexpr std::uint32_t kByteOrder = 0x01020304;
+		constexpr std::size_t kAlignment = 64;
+		constexpr float kGradientQuantization = 32767.0f;
+
+		std::uint32_t BytesPerElement(FileDataType type)
+		{
+			switch (type)
+			{
+			case FileDataType::Uint8:
+				return 1;
+			case FileDataType::Uint16:
+				return 2;
+			case FileDataType::Uint32:
+			case FileDataType::Float:
+				return 4;
+			case FileDataType::Double:
+				return 8;
+			default:
+				return 0;
+			}
+		}
+
+		// FNV-1a
+		class Hash
+		{
+		public:
+			void Add(const void* data, std::size_t size)
+			{
+				const auto* bytes = static_cast<const std::uint8_t*>(data);
+				for (std::size_t i = 0; i < size; ++i)
+				{
+					m_Value = (m_Value ^ bytes[i]) * 0x100000001b3ull;
+				}
+			}
+
+			template<typename T>
+			void Add(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				Add(&value, sizeof(T));
+			}
+
+			void Add(const std::string& value)
+			{
+				Add(value.size());
+				Add(value.data(), value.size());
+			}
+
+			[[nodiscard]] std::uint64_t GetValue() const { return m_Value; }
+
+		private:
+			std::uint64_t m_Value = 0xcbf29ce484222325ull;
+		};
+
+		template<typename T, std::size_t N>
+		void WriteArray(BinaryWriter& writer, const std::array<T, N>& values)
+		{
+			writer.Write(values.data(), sizeof(T) * N);
+		}
+
+		template<typename T, std::size_t N>
+		void ReadArray(BinaryReader& reader, std::array<T, N>& values)
+		{
+			for (auto& value : values)
+			{
+				value = reader.Read<T>();
+			}
+		}
+
+		void WriteParams(BinaryWriter& writer, const DicomVolumeParams& params)
+		{
+			writer.Write(static_cast<std::int32_t>(params.Modality));
+			writer.Write(params.FrameOfReference);
+			writer.Write(params.X);
+			writer.Write(params.Y);
+			writer.Write(params.Z);
+			writer.Write(params.BitsStored);
+			writer.Write(params.BitsAllocated);
+			writer.Write(params.NumberOfFrames);
+			writer.Write(params.LargestPixelValue);
+			writer.Write(params.SmallestPixelValue);
+			writer.Write(params.SliceThickness);
+			WriteArray(writer, params.ImagePositionPatient);
+			WriteArray(writer, params.ImageOrientationPatient);
+			WriteArray(writer, params.PixelSpacing);
+			writer.Write(params.MainAxis);
+		}
+
+		DicomVolumeParams ReadParams(BinaryReader& reader)
+		{
+			DicomVolumeParams params;
+			params.Modality = static_cast<DicomModality>(reader.Read<std::int32_t>());
+			params.FrameOfReference = reader.ReadString();
+			params.X = reader.Read<std::uint16_t>();
+			params.Y = reader.Read<std::uint16_t>();
+			params.Z = reader.Read<std::uint16_t>();
+			params.BitsStored = reader.Read<std::uint16_t>();
+			params.BitsAllocated = reader.Read<std::uint16_t>();
+			params.NumberOfFrames = reader.Read<std::int16_t>();
+			params.LargestPixelValue = reader.Read<std::uint16_t>();
+			params.SmallestPixelValue = reader.Read<std::uint16_t>();
+			params.SliceThickness = reader.Read<double>();
+			ReadArray(reader, params.ImagePositionPatient);
+			ReadArray(reader, params.ImageOrientationPatient);
+			ReadArray(reader, params.PixelSpacing);
+			params.MainAxis = reader.ReadString();
+			return params;
+		}
+	}
+
+	std::uint64_t DicomVolumeCache::ComputeKey(std::vector<std::filesystem::path> files, VolumePreprocessOptions options)
+	{
+		// Listing order is not guaranteed
+		std::ranges::sort(files);
+
+		Hash hash;
+		hash.Add(kVersion);
+		hash.Add(options.Normalize);
+		hash.Add(options.Gradient);
+		hash.Add(options.NormalizeGradient);
+
+		for (const auto& file : files)
+		{
+			std::error_code error;
+			const auto size = std::filesystem::file_size(file, error);
+			const auto time = std::filesystem::last_write_time(file, error);
+
+			hash.Add(std::filesystem::absolute(file).generic_string());
+			hash.Add(static_cast<std::uint64_t>(size));
+			hash.Add(static_cast<std::int64_t>(time.time_since_epoch().count()));
+		}
+
+		return hash.GetValue();
+	}
+
+	std::filesystem::path DicomVolumeCache::GetCachePath(std::uint64_t key)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.vcache", static_cast<unsigned long long>(key));
+		return FileSystem::GetDefaultPath() / "cache" / name;
+	}
+
+	std::optional<CachedDicomVolume> DicomVolumeCache::Load(std::uint64_t key)
+	{
+		const auto path = GetCachePath(key);
+		if (!std::filesystem::exists(path))
+		{
+			return std::nullopt;
+		}
+
+		auto mapping = MappedFile::Open(path);
+		if (mapping == nullptr)
+		{
+			LOG_WARN("Unable to map volume cache, ignoring it");
+			return std::nullopt;
+		}
+
+		BinaryReader reader(mapping->GetBytes());
+
+		std::array<char, 4> magic{};
+		ReadArray(reader, magic);
+		if (magic != kMagic || reader.Read<std::uint32_t>() != kVersion || reader.Read<std::uint32_t>() != kByteOrder
+			|| reader.Read<std::uint64_t>() != key)
+		{
+			LOG_WARN("Volume cache is outdated, ignoring it");
+			return std::nullopt;
+		}
+
+		CachedDicomVolume result;
+		result.Params = ReadParams(reader);
+		result.Preprocessed.Min = reader.Read<double>();
+		result.Preprocessed.Max = reader.Read<double>();
+		result.Preprocessed.MaxGradientMagnitude = reader.Read<float>();
+
+		const auto type = static_cast<FileDataType>(reader.Read<std::uint8_t>());
+		const auto voxelCount = reader.Read<std::uint64_t>();
+		const auto gradientCount = reader.Read<std::uint64_t>();
+		result.Histogram.Range = reader.Read<std::uint64_t>();
+		const auto histogramBins = reader.Read<std::uint64_t>();
+
+		const std::uint32_t bytesPerElement = BytesPerElement(type);
+		const std::size_t expectedVoxels = static_cast<std::size_t>(result.Params.X) * result.Params.Y * result.Params.Z;
+		if (reader.HasFailed() || bytesPerElement == 0 || voxelCount != expectedVoxels || (gradientCount != 0 && gradientCount != voxelCount))
+		{
+			LOG_WARN("Volume cache is damaged, ignoring it");
+			return std::nullopt;
+		}
+
+		// Density stays in the mapped file
+		reader.Align(kAlignment);
+		const auto density = reader.Take(voxelCount * bytesPerElement);
+
+		reader.Align(kAlignment);
+		const auto gradient = reader.Take(gradientCount * 3 * sizeof(std::int16_t));
+
+		reader.Align(kAlignment);
+		const auto histogram = reader.Take(histogramBins * sizeof(std::uint32_t));
+
+		if (reader.HasFailed())
+		{
+			LOG_WARN("Volume cache is truncated, ignoring it");
+			return std::nullopt;
+		}
+
+		result.Density = VoxelBuffer(type, density, mapping);
+
+		if (gradientCount != 0)
+		{
+			const float scale = result.Preprocessed.MaxGradientMagnitude / kGradientQuantization;
+			const auto* quantized = reinterpret_cast<const std::int16_t*>(gradient.data());
+			result.Preprocessed.Gradient.resize(gradientCount);
+
+			base::ThreadPool::Get().ParallelFor(0, gradientCount, [&](std::size_t i)
+			{
+				result.Preprocessed.Gradient[i] = glm::vec3(quantized[3 * i], quantized[3 * i + 1], quantized[3 * i + 2]) * scale;
+			}, 1 << 16);
+		}
+
+		result.Histogram.Counts.resize(histogramBins);
+		if (!histogram.empty())
+		{
+			std::memcpy(result.Histogram.Counts.data(), histogram.data(), histogram.size());
+		}
+
+		return result;
+	}
+
+	bool DicomVolumeCache::Store(std::uint64_t key, const DicomVolumeParams& params, const VoxelBuffer& density,
+		const VolumePreprocessResult& preprocessed, const DensityHistogram& histogram)
+	{
+		assert(density.GetChannels() == 1 && "Only single channel volumes are cached");
+
+		const auto path = GetCachePath(key);
+		auto temporary = path;
+		temporary += ".tmp";
+
+		std::error_code error;
+		std::filesystem::create_directories(path.parent_path(), error);
+		if (error)
+		{
+			LOG_WARN("Unable to create volume cache directory");
+			return false;
+		}
+
+		// Quantized relative to the largest magnitude, every component fits into [-1, 1]
+		std::vector<std::int16_t> quantized(preprocessed.Gradient.size() * 3);
+		const float maxMagnitude = preprocessed.MaxGradientMagnitude;
+		if (!preprocessed.Gradient.empty() && maxMagnitude > 0.0f)
+		{
+			const float scale = kGradientQuantization / maxMagnitude;
+			base::ThreadPool::Get().ParallelFor(0, preprocessed.Gradient.size(), [&](std::size_t i)
+			{
+				const glm::vec3 g = glm::clamp(preprocessed.Gradient[i] * scale, -kGradientQuantization, kGradientQuantization);
+				quantized[3 * i] = static_cast<std::int16_t>(std::lround(g.x));
+				quantized[3 * i + 1] = static_cast<std::int16_t>(std::lround(g.y));
+				quantized[3 * i + 2] = static_cast<std::int16_t>(std::lround(g.z));
+			}, 1 << 16);
+		}
+
+		{
+			BinaryWriter writer(temporary);
+
+			WriteArray(writer, kMagic);
+			writer.Write(kVersion);
+			writer.Write(kByteOrder);
+			writer.Write(key);
+
+			WriteParams(writer, params);
+			writer.Write(preprocessed.Min);
+			writer.Write(preprocessed.Max);
+			writer.Write(maxMagnitude);
+
+			writer.Write(static_cast<std::uint8_t>(density.GetType()));
+			writer.Write(static_cast<std::uint64_t>(density.GetVoxelCount()));
+			writer.Write(static_cast<std::uint64_t>(preprocessed.Gradient.size()));
+			writer.Write(static_cast<std::uint64_t>(histogram.Range));
+			writer.Write(static_cast<std::uint64_t>(histogram.Counts.size()));
+
+			writer.Align(kAlignment);
+			writer.Write(density.GetVoidPtr(), density.GetSizeInBytes());
+
+			writer.Align(kAlignment);
+			writer.Write(quantized.data(), quantized.size() * sizeof(std::int16_t));
+
+			writer.Align(kAlignment);
+			writer.Write(histogram.Counts.data(), histogram.Counts.size() * sizeof(std::uint32_t));
+
+			if (!writer.IsGood())
+			{
+				writer.Close();
+				std::filesystem::remove(temporary, error);
+				LOG_WARN("Unable to write volume cache");
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temporary, path, error);
+		if (error)
+		{
+			std::filesystem::remove(temporary, error);
+			LOG_WARN("Unable to write volume cache");
+			return false;
+		}
+
+		return true;
+	}
+}
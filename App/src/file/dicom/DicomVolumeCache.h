@@ -0,0 +1,69 @@
+#pragma once
+
+#include "DicomParams.h"
+#include "../VolumeFile.h"
+#include "../VoxelBuffer.h"
+#include "../VolumeStreamProcessor.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Volume restored from the cache, same state as right after the series was loaded and pre-processed.
+	 */
+	struct CachedDicomVolume
+	{
+		DicomVolumeParams Params{};
+		// View of the mapped cache file
+		VoxelBuffer Density{};
+		VolumePreprocessResult Preprocessed{};
+		DensityHistogram Histogram{};
+	};
+
+	/**
+	 * @brief On-disk cache of pre-processed DICOM series, so the next launch does not parse the series nor recompute gradients.
+	 * Binary file, sections are 64 bytes aligned:
+	 *   header (magic, version, byte order, key), DicomVolumeParams, value range, section sizes
+	 *   density in the native type (mapped, not copied on load)
+	 *   gradient quantized to 3 x int16 (relative to the largest magnitude)
+	 *   histogram counts
+	 * Cache is keyed by a hash of the series (file paths, sizes, modification times) and pre-processing options,
+	 * changed series simply gets a new key. Any mismatch or damaged file means a cache miss, never an error.
+	 */
+	class DicomVolumeCache
+	{
+	public:
+		// Bumped whenever the layout changes, older files are ignored
+		static constexpr std::uint32_t kVersion = 1;
+		// Histogram resolution stored within the cache, divisible by the transfer function resolutions
+		static constexpr std::size_t kHistogramBins = 4096;
+
+		/**
+		 * @brief Hash of the series, only file metadata are read.
+		 */
+		[[nodiscard]] static std::uint64_t ComputeKey(std::vector<std::filesystem::path> files, VolumePreprocessOptions options);
+
+		/**
+		 * @brief Where the cache of the series is stored, FileSystem::GetDefaultPath()/cache.
+		 */
+		[[nodiscard]] static std::filesystem::path GetCachePath(std::uint64_t key);
+
+		/**
+		 * @brief Maps the cache file, density stays mapped (VoxelBuffer external view), gradient is de-quantized.
+		 * @return nullopt if there is no valid cache for the key
+		 */
+		[[nodiscard]] static std::optional<CachedDicomVolume> Load(std::uint64_t key);
+
+		/**
+		 * @brief Writes the cache, file is written under temporary name and renamed, so readers never see partial file.
+		 * @param preprocessed gradient in native units (before VolumeFile scales it)
+		 * @return false if the cache could not be written (loading continues without cache)
+		 */
+		static bool Store(std::uint64_t key, const DicomVolumeParams& params, const VoxelBuffer& density,
+			const VolumePreprocessResult& preprocessed, const DensityHistogram& histogram);
+	};
+}
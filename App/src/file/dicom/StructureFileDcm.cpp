@@ -1,12 +1,15 @@
 #include "StructureFileDcm.h"
+#include "ContourRasterizer.h"
 #include "Base/Base.h"
+#include "Base/ThreadPool.h"
 
 #include <glm/glm.hpp>
 #include <string>
 #include <sstream>
 #include <cassert>
 #include <limits>
-#include <queue>
+#include <map>
+#include <utility>
 
 namespace med
 {
@@ -46,7 +49,7 @@ namespace med
 		return m_Params.FrameOfReference == other.GetBaseParams().FrameOfReference;
 	}
 
-	std::shared_ptr<VolumeFileDcm> StructureFileDcm::Create3DMask(const IDicomFile& other, std::array<int, 4> contourIDs, ContourPostProcess postProcessOpt)
+	std::shared_ptr<MaskVolume> StructureFileDcm::Create3DMask(const IDicomFile& other, const std::vector<int>& contourIDs, ContourPostProcess postProcessOpt)
 	{
 		if ((postProcessOpt & ContourPostProcess::IGNORE) && (~1 & postProcessOpt))
 		{
@@ -89,11 +92,8 @@ namespace med
 		// cast reference to VolumeFileDcm
 		const VolumeFileDcm& reference = dynamic_cast<const VolumeFileDcm&>(other);
 
-		auto [xSize, ySize, zSize] = reference.GetSize();
-		std::vector<glm::vec4> maskData(xSize * ySize * zSize, { 0.0f, 0.0f, 0.0f, 0.0f });
-
-		// uint8_t is enough for mask data but beacuse of VolumeFile implementation we need to use glm::vec4 for now!
-		//std::vector<std::array<uint8_t, 4>> maskData(xSize * ySize * zSize, { 0, 0, 0, 0 });
+		// One bit plane per contour
+		auto mask = std::make_shared<MaskVolume>(reference.GetSize(), static_cast<std::uint32_t>(m_ActiveContourIDs.size()));
 
 		// We assume that the ImagePositionPatient is stored from the first slice (if the data was divided into multiple files)
 		auto [ox, oy, oz] = reference.GetVolumeParams().ImagePositionPatient;
@@ -103,19 +103,35 @@ namespace med
 		glm::vec3 spacing{ sx, sy, sz };
 		glm::vec3 origin{ ox, oy, oz };
 
+		if (postProcessOpt & ContourPostProcess::FILL)
+		{
+			// Filled mask is rasterized directly from the contour polygons, point post-processing is not needed
+			RasterizeContours(reference, origin, spacing, *mask, sliceNumbers);
+		}
+		else
+		{
+			MarkContourPoints(reference, origin, spacing, postProcessOpt, *mask, sliceNumbers);
+		}
+
+		mask->SetRoiSlices(std::move(sliceNumbers));
+		return mask;
+	}
+
+	void StructureFileDcm::MarkContourPoints(const VolumeFileDcm& reference, glm::vec3 origin, glm::vec3 spacing, ContourPostProcess postProcessOpt,
+		MaskVolume& mask, std::vector<std::vector<int>>& sliceNumbers)
+	{
+		auto [xSize, ySize, zSize] = reference.GetSize();
+
 		// Traverse contours
-		for (size_t l = 0; l < finalContours.size(); ++l)
+		for (size_t l = 0; l < m_ActiveContourIDs.size(); ++l)
 		{
-			const auto cId = finalContours[l];
+			const auto cId = m_ActiveContourIDs[l];
 			// Pick contour
 			for (size_t i = 0; i < m_Data[cId].size(); ++i)
 			{
 				assert(m_Data[cId][i].size() % 3 == 0);
 				int sliceNumber = -1;
 
-				std::vector<float> yCoords{};
-				yCoords.reserve(m_Data[cId][i].size());
-
 				// Traverses images where contours are defined
 				for (size_t j = 0; j <= m_Data[cId][i].size() - 3; j += 3)
 				{
@@ -136,14 +152,14 @@ namespace med
 					}
 
 					// if (duplicate or	process non-duplicates anyway) and (ignore flag is deactivated)
-					if ((maskData[index][l] == 1 || postProcessOpt & PROCESS_NON_DUPLICATES) && !(postProcessOpt & ContourPostProcess::IGNORE))
+					if ((mask.Contains(static_cast<std::uint32_t>(l), index) || postProcessOpt & PROCESS_NON_DUPLICATES) && !(postProcessOpt & ContourPostProcess::IGNORE))
 					{
 						// These post-processes are done on point/pixel level
 						if (postProcessOpt & ContourPostProcess::NEAREST_NEIGHBOUR)
 						{
 							glm::ivec2 substituteVoxel = HandleDuplicatesNearestNeighbour(reference, contourPoint, voxel);
 							int newIndex = reference.GetIndexFrom3D(substituteVoxel.x, substituteVoxel.y, static_cast<int>(voxel.z));
-							maskData[newIndex][l] = 1;
+							mask.Set(static_cast<std::uint32_t>(l), newIndex);
 						}
 
 						if (postProcessOpt & ContourPostProcess::RECONSTRUCT_BRESENHAM)
@@ -160,16 +176,15 @@ namespace med
 								for (size_t i = 0; i < derivedVoxels.size() - 1; ++i)
 								{
 									index = reference.GetIndexFrom3D(derivedVoxels[i].x, derivedVoxels[i].y, static_cast<int>(voxel.z));
-									maskData[index][l] = 1;
+									mask.Set(static_cast<std::uint32_t>(l), index);
 								}
 							}
 						}
 
 					}
 
-					yCoords.push_back(voxel.y);
 					// Activate point at index, l is the contour we are processing
-					maskData[index][l] = 1;
+					mask.Set(static_cast<std::uint32_t>(l), index);
 				}
 
 				// Contour l is defined on slice sliceNumber
@@ -178,29 +193,65 @@ namespace med
 				// Process the created image
 				if (postProcessOpt & ContourPostProcess::CLOSING)
 				{
-					MorphologicalOp(maskData, xSize, ySize, sliceNumber, { {1,1,1}, {1,1,1}, {1,1,1} }, false); // Dilation
-					MorphologicalOp(maskData, xSize, ySize, sliceNumber, { {1,1,1}, {1,1,1}, {1,1,1} }, true); // Erosion
+					MorphologicalOp(mask, xSize, ySize, sliceNumber, { {1,1,1}, {1,1,1}, {1,1,1} }, false); // Dilation
+					MorphologicalOp(mask, xSize, ySize, sliceNumber, { {1,1,1}, {1,1,1}, {1,1,1} }, true); // Erosion
 				}
+			}
+		}
+	}
+
+	void StructureFileDcm::RasterizeContours(const VolumeFileDcm& reference, glm::vec3 origin, glm::vec3 spacing,
+		MaskVolume& mask, std::vector<std::vector<int>>& sliceNumbers) const
+	{
+		const auto [xSize, ySize, zSize] = reference.GetSize();
 
-				if (postProcessOpt & ContourPostProcess::FILL)
+		// Polygons of one ROI on one slice are rasterized together (inner contours cut holes), key is (channel, slice)
+		std::map<std::pair<int, int>, std::vector<std::vector<glm::vec2>>> slicePolygons;
+		for (size_t l = 0; l < m_ActiveContourIDs.size(); ++l)
+		{
+			for (const auto& contour : m_Data[m_ActiveContourIDs[l]])
+			{
+				assert(contour.size() % 3 == 0);
+				if (contour.size() < 3)
 				{
-					std::ranges::sort(yCoords);
-					glm::ivec2 seed = FindSeed(static_cast<int>(yCoords[yCoords.size() / 2]), xSize, ySize, sliceNumber, l, maskData);
-					if (seed.x == -1)
-					{
-						LOG_ERROR("Did not find the seed for fill.");
-					}
-					else
-					{
-						FloodFill(seed, xSize, ySize, sliceNumber, l, maskData);
-					}
+					continue;
+				}
+
+				// Contours are planar, slice is given by the first point
+				const int sliceNumber = static_cast<int>(std::round(std::fabs((contour[2] - origin.z) / spacing.z)));
+				if (sliceNumber < 0 || sliceNumber >= zSize)
+				{
+					LOG_WARN("Contour out of bounds, skipping...");
+					continue;
+				}
+
+				// RCS -> Voxel, not rounded, voxel centers are at integer coordinates
+				std::vector<glm::vec2> polygon;
+				polygon.reserve(contour.size() / 3);
+				for (size_t j = 0; j + 2 < contour.size(); j += 3)
+				{
+					polygon.emplace_back((contour[j] - origin.x) / spacing.x, (contour[j + 1] - origin.y) / spacing.y);
 				}
+
+				slicePolygons[{ static_cast<int>(l), sliceNumber }].push_back(std::move(polygon));
+				sliceNumbers[l].push_back(sliceNumber);
 			}
 		}
 
-		auto file = std::make_shared<VolumeFileDcm>(m_Path, reference.GetSize(), FileDataType::Float, reference.GetVolumeParams(), maskData);
-		file->SetContourSliceNumbers(sliceNumbers);
-		return file;
+		// Every task writes its own slice of its own bit plane
+		std::vector<std::pair<const std::pair<int, int>, std::vector<std::vector<glm::vec2>>>*> tasks;
+		tasks.reserve(slicePolygons.size());
+		for (auto& entry : slicePolygons)
+		{
+			tasks.push_back(&entry);
+		}
+
+		base::ThreadPool::Get().ParallelFor(0, tasks.size(), [&](size_t t)
+		{
+			const auto& [key, polygons] = *tasks[t];
+			const auto [channel, sliceNumber] = key;
+			ContourRasterizer::Fill(polygons, xSize, ySize, mask.GetSliceBits(static_cast<std::uint32_t>(channel), static_cast<std::uint32_t>(sliceNumber)));
+		});
 	}
 
 	glm::ivec2 StructureFileDcm::HandleDuplicatesNearestNeighbour(const VolumeFileDcm& reference, glm::vec3 currentRCS, glm::vec3 currentVoxel)
@@ -307,7 +358,7 @@ namespace med
 		return res;
 	}
 
-	void StructureFileDcm::MorphologicalOp(std::vector<glm::vec4>& data, int xSize, int ySize, int sliceNumber, std::vector<std::vector<uint8_t>> structureElement, bool doErosion)
+	void StructureFileDcm::MorphologicalOp(MaskVolume& mask, int xSize, int ySize, int sliceNumber, std::vector<std::vector<uint8_t>> structureElement, bool doErosion)
 	{
 		if (structureElement.size() == 0 || structureElement[0].size() == 0)
 		{
@@ -321,11 +372,6 @@ namespace med
 			return;
 		}
 
-		auto coord3D = [&](int x, int y, int z)
-			{
-				return z * ySize * xSize + y * xSize + x;
-			};
-
 		auto coord2D = [&](int x, int y)
 			{
 				return y * xSize + x;
@@ -334,15 +380,16 @@ namespace med
 		int offy = structureElement.size() / 2;
 		int offx = structureElement[0].size() / 2;
 
-		std::vector<glm::vec4>::const_iterator begin = data.begin() + coord3D(0, 0, sliceNumber);
-		std::vector<glm::vec4>::const_iterator end = data.begin() + coord3D(0, 0, sliceNumber + 1);
-		// Altered stores the slice, where we compute the morphological operation
-		std::vector<glm::vec4> altered(begin, end);
-		
-		assert(altered.size() == xSize * ySize);
-
-		for (int cId = 0; cId < m_ActiveContourIDs.size(); ++cId)
+		for (std::uint32_t cId = 0; cId < mask.GetRoiCount(); ++cId)
 		{
+			auto data = mask.GetSliceBits(cId, static_cast<std::uint32_t>(sliceNumber));
+			// Altered stores the slice, where we compute the morphological operation
+			const std::vector<MaskVolume::Word> altered(data.begin(), data.end());
+			auto isSet = [&altered](int index)
+				{
+					return (altered[index / MaskVolume::kWordBits] >> (index % MaskVolume::kWordBits)) & 1;
+				};
+
 			for (int y = offy; y < ySize - offy; ++y)
 			{
 				for (int x = offx; x < xSize - offx; x++)
@@ -360,12 +407,12 @@ namespace med
 
 							int index = coord2D(x + j, y + i);
 
-							if (doErosion && altered[index][cId] == 0)
+							if (doErosion && !isSet(index))
 							{
 								hasMissed = true;
 								break;
 							}
-							else if (!doErosion && altered[index][cId] == 1)
+							else if (!doErosion && isSet(index))
 							{
 								// Dilation
 								hasHit = true;
@@ -378,11 +425,11 @@ namespace med
 							break;
 					}
 
-					int dataCoord = coord3D(x, y, sliceNumber);
+					int dataCoord = coord2D(x, y);
 
 					if (hasMissed)
 					{
-						data[dataCoord][cId] = 0;
+						data[dataCoord / MaskVolume::kWordBits] &= ~(MaskVolume::Word(1) << (dataCoord % MaskVolume::kWordBits));
 					}
 					//else
 					//{
@@ -393,95 +440,12 @@ namespace med
 
 					if (hasHit)
 					{
-						data[dataCoord][cId] = 1;
-					}
-
-				}
-			}
-		}
-
-	}
-	
-	glm::vec2 StructureFileDcm::FindSeed(int yStart, int xSize, int ySize, int sliceNumber, int contourNumber, std::vector<glm::vec4>& data)
-	{
-		int yCurrent = yStart;
-		constexpr int MAGIC_THRESH = 5;
-
-		// Make VolumeFile get 3D static -- x, y, z, width, height
-		auto GI = [&](int x, int y, int z) -> int
-		{
-			return z * ySize * xSize + y * xSize + x;
-		};
-
-		// Explore only half of the image, we can do this as we start in the middle of the contour
-		while (yCurrent >= 0 && yCurrent < ySize)
-		{
-			for (int x = 0; x < xSize; ++x)
-			{
-				int i = GI(x, yCurrent, sliceNumber);
-
-				// Default, no contour found
-				if (data[i][contourNumber] == 0)
-					continue;
-				if (data[i][contourNumber] == 1)
-				{
-					int numOfOnes = 0;
-					// shoot ray
-					while (x < xSize)
-					{
-						int ii = GI(x, yCurrent, sliceNumber);
-						if (data[ii][contourNumber] == 1)
-						{
-							++numOfOnes;
-						} 
-						else if (data[ii][contourNumber] == 0 && numOfOnes < MAGIC_THRESH)
-						{
-							// We should be inside, magic threshold is here to account for wider edges
-							return glm::ivec2(x, yCurrent);
-						}
-						else if (data[ii][contourNumber] == 0 && numOfOnes >= MAGIC_THRESH)
-						{
-							// We might have passed already filled contour
-							break;
-						}
-						++x;
+						data[dataCoord / MaskVolume::kWordBits] |= MaskVolume::Word(1) << (dataCoord % MaskVolume::kWordBits);
 					}
 
 				}
-
-
 			}
-			++yCurrent;
 		}
 
-
-		return glm::vec2(-1, -1);
-	}
-
-	void StructureFileDcm::FloodFill(glm::ivec2 seed, int xSize, int ySize, int sliceNumber, int contourNumber, std::vector<glm::vec4>& data)
-	{
-		auto GI = [&](int x, int y, int z) -> int
-		{
-			return z * ySize * xSize + y * xSize + x;
-		};
-
-		std::queue<glm::ivec2> q;
-		q.push(seed);
-		
-		while (!q.empty())
-		{
-			glm::ivec2 current = q.front();
-			q.pop();
-
-			int index = GI(current.x, current.y, sliceNumber);// boundaries checked on the next line so it will be caught but later
-			if (current.x >= 0 && current.y >= 0 && current.x < xSize && current.y < ySize && data[index][contourNumber] == 0)
-			{
-				data[index][contourNumber] = 1;
-				q.push(glm::ivec2(current.x - 1, current.y));
-				q.push(glm::ivec2(current.x + 1, current.y));
-				q.push(glm::ivec2(current.x, current.y - 1));
-				q.push(glm::ivec2(current.x, current.y + 1));
-			}
-		}
 	}
 }
\ No newline at end of file
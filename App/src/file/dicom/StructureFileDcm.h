@@ -3,10 +3,10 @@
 #include "IDicomFile.h"
 #include "DicomParams.h"
 #include "VolumeFileDcm.h"
+#include "../MaskVolume.h"
 
 #include <vector>
 #include <memory>
-#include <array>
 #include <filesystem>
 
 namespace med
@@ -39,12 +39,13 @@ namespace med
 		void ListAvailableContours() const;
 
 		/*
-		* @brief Creates a volume file (volume mask) from the contour data.
+		* @brief Creates a volume mask from the contour data, one ROI (bit plane) per valid contour ID in the given order.
 		* @param other: Reference dicom file, file from which this contours were generated
-		* @param contourIDs: IDs of contours to be included inside the max, up to 4 contours can be selected
+		* @param contourIDs: IDs of contours to be included inside the mask, any number of contours can be selected
 		* @param postProcess: What post process actions should be performed on the data.
+		* FILL rasterizes the contour polygons directly (even-odd scanline fill), the other options apply to outline masks only.
 		*/
-		std::shared_ptr<VolumeFileDcm> Create3DMask(const IDicomFile& other, std::array<int, 4> contourIDs, ContourPostProcess duplicateOption);
+		std::shared_ptr<MaskVolume> Create3DMask(const IDicomFile& other, const std::vector<int>& contourIDs, ContourPostProcess duplicateOption);
 		
 		/* IDicom Interface */
 		DicomBaseParams GetBaseParams() const override;
@@ -79,11 +80,22 @@ namespace med
 		* @param doErosion If true Erosion is performed, dilation otherwise
 		* @return None, data are changed inside the method
 		*/
-		void MorphologicalOp(std::vector<glm::vec4>& data, int xSize, int ySize, int sliceNumber,
+		void MorphologicalOp(MaskVolume& mask, int xSize, int ySize, int sliceNumber,
 			std::vector<std::vector<uint8_t>> structureElement, bool doErosion);
 
-		glm::vec2 FindSeed(int yStart, int xSize, int ySize, int sliceNumber, int contourNumber, std::vector<glm::vec4>& data);
-		void FloodFill(glm::ivec2 seed, int xSize, int ySize, int sliceNumber, int contourNumber, std::vector<glm::vec4>& data);
+		/*
+		* @brief Marks the voxels nearest to the contour points and applies the point level post-processes (outline mask).
+		* @param sliceNumbers: Slice of every contour, per active contour ID
+		*/
+		void MarkContourPoints(const VolumeFileDcm& reference, glm::vec3 origin, glm::vec3 spacing, ContourPostProcess postProcessOpt,
+			MaskVolume& mask, std::vector<std::vector<int>>& sliceNumbers);
+
+		/*
+		* @brief Fills the contours by scanline rasterization (see ContourRasterizer), slices and ROIs in parallel.
+		* @param sliceNumbers: Slice of every contour, per active contour ID
+		*/
+		void RasterizeContours(const VolumeFileDcm& reference, glm::vec3 origin, glm::vec3 spacing,
+			MaskVolume& mask, std::vector<std::vector<int>>& sliceNumbers) const;
 
 
 	private:
@@ -7,7 +7,8 @@
 namespace med
 {
 	VolumeFileDcm::VolumeFileDcm(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, 
-		FileDataType type, DicomVolumeParams params, std::vector<glm::vec4>& data) : VolumeFile(path, size, type, data, params.LargestPixelValue), m_Params(params)
+		DicomVolumeParams params, VoxelBuffer data, size_t maxNumber) :
+		VolumeFile(path, size, std::move(data), params.LargestPixelValue != 0 ? params.LargestPixelValue : maxNumber), m_Params(params)
 	{
 		InitializeTransformMatrices();
 		CalcMainAxis();
@@ -14,8 +14,11 @@ namespace med
 	class VolumeFileDcm : public IDicomFile, public VolumeFile
 	{
 	public:
+		/**
+		 * @param maxNumber maximum within the data if known, used when the header does not contain Largest Pixel Value
+		 */
 		VolumeFileDcm(std::filesystem::path path, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size,
-			FileDataType type, DicomVolumeParams params, std::vector<glm::vec4>& data);
+			DicomVolumeParams params, VoxelBuffer data, size_t maxNumber = 0);
 	public:
 
 		/*
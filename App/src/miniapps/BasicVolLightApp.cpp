@@ -12,16 +12,16 @@ namespace med
 	void BasicVolLightApp::OnStart(PipelineBuilder& pipeline)
 	{
 		LOG_INFO("OnStart Basic volume app with light");
+		// Ray is marched until it is fully opaque, as before the threshold became adjustable
+		m_OpacityThreshold = 1.0f;
 
-		 auto ctFile = DicomReader::ReadVolumeFile(FileSystem::GetDefaultPath() / "assets\\HumanHead\\");
+		 auto ctFile = DicomReader::ReadVolumeFile(FileSystem::GetDefaultPath() / "assets\\HumanHead\\", { .Normalize = true, .Gradient = true, .UseCache = true });
 		//auto ctFile = DicomReader::ReadVolumeFile(FileSystem::GetDefaultPath() / "assets\\chestCTContrast\\");
 		//auto ctFile = DicomReader::ReadVolumeFile(FileSystem::GetDefaultPath() / "assets\\716^716_716_CT_2013-04-02_230000_716-1-01_716-1_n81__00000\\");
 
 		//auto ctFile = DicomReader::ReadVolumeFile(FileSystem::GetDefaultPath() / "assets\\AGIA2YVL\\");
 
 
-		ctFile->NormalizeData();
-		ctFile->PreComputeGradient();
 		ctFile->AverageGradient(5);
 
 		ComputeRecommendedSteppingParams(*ctFile);
@@ -35,25 +35,72 @@ namespace med
 
 		p_OpacityTf->SetDataRange(ctFile->GetMaxNumber());
 		p_OpacityTf->ActivateHistogram(*ctFile);
-
-		p_TexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), ctFile->GetVoidPtr(), WGPUTextureDimension_3D, ctFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT data texture");
+		// Density x gradient magnitude TF, replaces the 1D TFs when enabled in the UI
+		p_Tf2D = std::make_unique<TransferFunction2D>();
+		p_Tf2D->ActivateHistogram(*ctFile);
+		m_Tf2DOpacity.resize(p_Tf2D->GetDensityResolution(), 0.0f);
+		p_PresetPanel = std::make_unique<TFPresetPanel>(p_OpacityTf.get(), p_ColorTf.get(), p_Tf2D.get());
+
+		p_TexData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT data texture");
+		p_TexGradientData = VolumeTexture::CreateGradient(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT gradient texture");
+		m_Occupancy = OccupancyMap(MinMaxBrickGrid(*ctFile));
+		m_Occupancy.Classify(p_OpacityTf->GetOpacities());
+		p_TexOccupancy = VolumeTexture::CreateOccupancy(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), m_Occupancy, "CT occupancy texture");
 
 		p_ULight = UniformBuffer::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), &m_Light1, sizeof(Light));
+		p_UTfMode = UniformBuffer::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), &m_TfMode, sizeof(int));
 
 
 		m_BGroup.AddTexture(*p_TexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_OpacityTf->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_ColorTf->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddBuffer(*p_ULight, WGPUShaderStage_Fragment);
+		m_BGroup.AddTexture(*p_TexGradientData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_TexOccupancy, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_Tf2D->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddBuffer(*p_UTfMode, WGPUShaderStage_Fragment);
 		m_BGroup.FinalizeBindGroup(base::GraphicsContext::GetDevice());
 		IntializePipeline(pipeline);
 	}
 
 	void BasicVolLightApp::OnUpdate(base::Timestep ts)
 	{
+		const int tfMode = m_UseTf2D ? 1 : 0;
+		const bool modeChanged = tfMode != m_TfMode;
+		if (modeChanged)
+		{
+			m_TfMode = tfMode;
+			p_UTfMode->UpdateBuffer(base::GraphicsContext::GetQueue(), 0, &m_TfMode, sizeof(int));
+		}
+
+		bool occupancyChanged = false;
+		if (m_TfMode == 1)
+		{
+			// Brick is visible if any of its densities is visible at some magnitude
+			if (modeChanged || p_Tf2D->ShouldUpdate())
+			{
+				TFWidget2DRasterizer::ProjectOpacity(p_Tf2D->GetLut(), p_Tf2D->GetDensityResolution(), m_Tf2DOpacity);
+				occupancyChanged = m_Occupancy.Update(m_Tf2DOpacity, { 0, m_Tf2DOpacity.size() - 1 });
+			}
+		}
+		else if (modeChanged)
+		{
+			const auto& opacities = p_OpacityTf->GetOpacities();
+			occupancyChanged = m_Occupancy.Update(opacities, { 0, opacities.size() - 1 });
+		}
+		else if (p_OpacityTf->ShouldUpdate())
+		{
+			// Only bricks overlapping the edited part of the TF are re-evaluated
+			occupancyChanged = m_Occupancy.Update(p_OpacityTf->GetOpacities(), p_OpacityTf->GetDirtyTexels());
+		}
+
+		if (occupancyChanged)
+		{
+			VolumeTexture::UpdateOccupancy(base::GraphicsContext::GetQueue(), *p_TexOccupancy, m_Occupancy);
+		}
 		p_OpacityTf->UpdateTexture();
 		p_ColorTf->UpdateTexture();
+		p_Tf2D->UpdateTexture();
 	}
 
 	void BasicVolLightApp::OnRender(const WGPURenderPassEncoder pass)
@@ -75,6 +122,12 @@ namespace med
 		MED_BEGIN_TAB_ITEM("Transfer functions")
 		p_OpacityTf->Render();
 		p_ColorTf->Render();
+		p_PresetPanel->Render();
+		MED_END_TAB_ITEM
+
+		MED_BEGIN_TAB_ITEM("2D transfer function")
+		ImGui::Checkbox("Use 2D transfer function", &m_UseTf2D);
+		p_Tf2D->Render();
 		MED_END_TAB_ITEM
 
 		MED_END_TAB_BAR
@@ -16,17 +16,27 @@ namespace med
 		DemoBasic();
 		//DemoCTReuse();
 		//DemoMRIReuse();
-		
+
+		p_PresetPanel = std::make_unique<TFPresetPanel>(p_OpacityTf.get(), p_ColorTf.get());
+
+		m_Occupancy.Classify(p_OpacityTf->GetOpacities());
+		p_TexOccupancy = VolumeTexture::CreateOccupancy(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), m_Occupancy, "CT occupancy texture");
 			
 		m_BGroup.AddTexture(*p_TexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_OpacityTf->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_ColorTf->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_TexOccupancy, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.FinalizeBindGroup(base::GraphicsContext::GetDevice());
 		IntializePipeline(pipeline);
 	}
 
 	void BasicVolumeApp::OnUpdate(base::Timestep ts)
 	{
+		// Only bricks overlapping the edited part of the TF are re-evaluated
+		if (p_OpacityTf->ShouldUpdate() && m_Occupancy.Update(p_OpacityTf->GetOpacities(), p_OpacityTf->GetDirtyTexels()))
+		{
+			VolumeTexture::UpdateOccupancy(base::GraphicsContext::GetQueue(), *p_TexOccupancy, m_Occupancy);
+		}
 		p_OpacityTf->UpdateTexture();
 		p_ColorTf->UpdateTexture();
 	}
@@ -50,6 +60,7 @@ namespace med
 		MED_BEGIN_TAB_ITEM("Transfer functions")
 		p_OpacityTf->Render();
 		p_ColorTf->Render();
+		p_PresetPanel->Render();
 		MED_END_TAB_ITEM
 
 		MED_END_TAB_BAR
@@ -88,8 +99,8 @@ namespace med
 		p_OpacityTf->ActivateHistogram(*ctFile);
 
 		p_ColorTf = std::make_unique<ColorTF>(256);
-		p_TexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), ctFile->GetVoidPtr(), WGPUTextureDimension_3D, ctFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT data texture");
+		p_TexData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT data texture");
+		m_Occupancy = OccupancyMap(MinMaxBrickGrid(*ctFile));
 	}
 
 	void BasicVolumeApp::DemoCTReuse()
@@ -105,8 +116,8 @@ namespace med
 		
 		p_OpacityTf->ActivateHistogram(*ctFile);
 		p_ColorTf = std::make_unique<ColorTF>(4096);
-		p_TexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), ctFile->GetVoidPtr(), WGPUTextureDimension_3D, ctFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT data texture");
+		p_TexData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT data texture");
+		m_Occupancy = OccupancyMap(MinMaxBrickGrid(*ctFile));
 	}
 
 	void BasicVolumeApp::DemoMRIReuse()
@@ -122,8 +133,8 @@ namespace med
 
 		p_OpacityTf->ActivateHistogram(*mriFile);
 		p_ColorTf = std::make_unique<ColorTF>(256);
-		p_TexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), mriFile->GetVoidPtr(), WGPUTextureDimension_3D, mriFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT data texture");
+		p_TexData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *mriFile, "CT data texture");
+		m_Occupancy = OccupancyMap(MinMaxBrickGrid(*mriFile));
 	}
 
 }
\ No newline at end of file
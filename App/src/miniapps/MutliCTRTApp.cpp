@@ -14,7 +14,8 @@ namespace med
 		LOG_WARN("OnStsart MultiCTRTApp");
 		
 		// Loading data
-		auto ctFile = DicomReader::ReadVolumeFile("assets\\716^716_716_CT_2013-04-02_230000_716-1-01_716-1_n81__00000\\");
+		auto ctFile = DicomReader::ReadVolumeFile("assets\\716^716_716_CT_2013-04-02_230000_716-1-01_716-1_n81__00000\\",
+			{ .Normalize = true, .Gradient = true, .NormalizeGradient = true, .UseCache = true });
 		auto rtDoseFile = DicomReader::ReadVolumeFile("assets\\716^716_716_RTDOSE_2013-04-02_230000_716-1-01_Eclipse.Doses.0,.Generated.from.plan.'1.pelvis',.1.pelvis.#,.IN_n1__00000\\");
 		
 
@@ -29,8 +30,6 @@ namespace med
 			LOG_WARN("File have different orientation. Visualisation may not be accurate");
 		}
 
-		ctFile->PreComputeGradient(true);
-		ctFile->NormalizeData();
 		rtDoseFile->NormalizeData();
 
 
@@ -45,13 +44,18 @@ namespace med
 		p_ColorTfCT = std::make_unique<ColorTF>(1024);
 		p_ColorTfRT = std::make_unique<ColorTF>(1024);
 
-		p_TexCTData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), ctFile->GetVoidPtr(), WGPUTextureDimension_3D, ctFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT data texture");
+		p_TexCTData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT data texture");
 
-		p_TexRTData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), rtDoseFile->GetVoidPtr(), WGPUTextureDimension_3D, rtDoseFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "RTDose data texture");
+		p_TexRTData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *rtDoseFile, "RTDose data texture");
 
-		//p_TexMaskData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), volumeMask->GetVoidPtr(), WGPUTextureDimension_3D, volumeMask->GetSize(),
+		p_TexCTGradientData = VolumeTexture::CreateGradient(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT gradient texture");
+
+		// Opacity comes from the CT TF only, RT dose just tints the color
+		m_Occupancy = OccupancyMap(MinMaxBrickGrid(*ctFile));
+		m_Occupancy.Classify(p_OpacityTfCT->GetOpacities());
+		p_TexOccupancy = VolumeTexture::CreateOccupancy(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), m_Occupancy, "CT occupancy texture");
+
+		//p_TexMaskData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), volumeMask->CreateTextureData().data(), WGPUTextureDimension_3D, volumeMask->GetSize(),
 		//	WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "Contour 3D mask");
 
 		p_ULight = UniformBuffer::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), &m_Light1, sizeof(Light));
@@ -63,6 +67,8 @@ namespace med
 		m_BGroup.AddTexture(*p_OpacityTfRT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_ColorTfRT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddBuffer(*p_ULight, WGPUShaderStage_Fragment);
+		m_BGroup.AddTexture(*p_TexCTGradientData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_TexOccupancy, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		// m_BGroup.AddTexture(*p_TexMaskData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.FinalizeBindGroup(base::GraphicsContext::GetDevice());
 		IntializePipeline(pipeline);
@@ -70,6 +76,11 @@ namespace med
 
 	void MultiCTRTApp::OnUpdate(base::Timestep ts)
 	{
+		// Only bricks overlapping the edited part of the TF are re-evaluated
+		if (p_OpacityTfCT->ShouldUpdate() && m_Occupancy.Update(p_OpacityTfCT->GetOpacities(), p_OpacityTfCT->GetDirtyTexels()))
+		{
+			VolumeTexture::UpdateOccupancy(base::GraphicsContext::GetQueue(), *p_TexOccupancy, m_Occupancy);
+		}
 		p_OpacityTfCT->UpdateTexture();
 		p_OpacityTfRT->UpdateTexture();
 		p_ColorTfCT->UpdateTexture();
@@ -9,10 +9,12 @@ namespace med
 	void ThreeFilesApp::OnStart(PipelineBuilder& pipeline)
 	{
 		LOG_WARN("OnStsart ThreeFilesApp");
+		// Ray is marched until it is fully opaque, as before the threshold became adjustable
+		m_OpacityThreshold = 1.0f;
 		auto contourFile = DicomReader::ReadStructFile("assets\\716^716_716_RTst_2013-04-02_230000_716-1-01_OCM.BladderShell_n1__00000\\");
 		auto ctFile = DicomReader::ReadVolumeFile("assets\\716^716_716_CT_2013-04-02_230000_716-1-01_716-1_n81__00000\\");
 		auto rtDoseFile = DicomReader::ReadVolumeFile("assets\\716^716_716_RTDOSE_2013-04-02_230000_716-1-01_Eclipse.Doses.0,.Generated.from.plan.'1.pelvis',.1.pelvis.#,.IN_n1__00000\\");
-		auto volumeMask = contourFile->Create3DMask(*ctFile, { 3, 0, 0, 0 }, ContourPostProcess::RECONSTRUCT_BRESENHAM | 
+		auto volumeMask = contourFile->Create3DMask(*ctFile, { 3 }, ContourPostProcess::RECONSTRUCT_BRESENHAM | 
 			ContourPostProcess::PROCESS_NON_DUPLICATES | ContourPostProcess::CLOSING | ContourPostProcess::FILL);
 
 		p_OpacityTfCT = std::make_unique<OpacityTF>(256);
@@ -20,20 +22,17 @@ namespace med
 		p_ColorTfCT = std::make_unique<ColorTF>(256);
 		p_ColorTfRT = std::make_unique<ColorTF>(256);
 
-		p_TexCTData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), ctFile->GetVoidPtr(), WGPUTextureDimension_3D, ctFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT data texture");
+		p_TexCTData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT data texture");
 
-		p_TexRTData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), rtDoseFile->GetVoidPtr(), WGPUTextureDimension_3D, rtDoseFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "RTDose data texture");
+		p_TexRTData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *rtDoseFile, "RTDose data texture");
 
-		p_TexMaskData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), volumeMask->GetVoidPtr(), WGPUTextureDimension_3D, volumeMask->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "Contour 3D mask");
+		p_TexMaskData = VolumeTexture::CreateMask(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *volumeMask, 0, "Contour 3D mask");
 
 		p_ULight = UniformBuffer::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), &m_Light1, sizeof(Light));
 
 		m_BGroup.AddTexture(*p_TexCTData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_TexRTData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
-		m_BGroup.AddTexture(*p_TexMaskData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_TexMaskData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Uint);
 		m_BGroup.AddTexture(*p_OpacityTfCT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_ColorTfCT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_OpacityTfRT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
@@ -12,16 +12,18 @@ namespace med
 	void VolumeMaskApp::OnStart(PipelineBuilder& pipeline)
 	{
 		LOG_INFO("OnStart BasicVolumeMiniApp");
+		// Ray is marched until it is fully opaque, as before the threshold became adjustable
+		m_OpacityThreshold = 1.0f;
 
 		auto contourFile = DicomReader::ReadStructFile("assets\\716^716_716_RTst_2013-04-02_230000_716-1-01_OCM.BladderShell_n1__00000\\");
 
 		contourFile->ListAvailableContours();
 
 		auto rtFile = DicomReader::ReadVolumeFile("assets\\716^716_716_RTDOSE_2013-04-02_230000_716-1-01_Eclipse.Doses.0,.Generated.from.plan.'1.pelvis',.1.pelvis.#,.IN_n1__00000\\");
-		auto ctFile = DicomReader::ReadVolumeFile("assets\\716^716_716_CT_2013-04-02_230000_716-1-01_716-1_n81__00000\\");
-		ctFile->PreComputeGradient(true);
+		auto ctFile = DicomReader::ReadVolumeFile("assets\\716^716_716_CT_2013-04-02_230000_716-1-01_716-1_n81__00000\\",
+			{ .Gradient = true, .NormalizeGradient = true, .UseCache = true });
 
-		auto volumeMask = contourFile->Create3DMask(*ctFile, { 2, 4, 0, 0 }, ContourPostProcess::RECONSTRUCT_BRESENHAM |
+		auto volumeMask = contourFile->Create3DMask(*ctFile, { 2, 4 }, ContourPostProcess::RECONSTRUCT_BRESENHAM |
 			ContourPostProcess::PROCESS_NON_DUPLICATES | ContourPostProcess::CLOSING | ContourPostProcess::FILL);
 
 
@@ -43,23 +45,22 @@ namespace med
 		p_OpacityTfRT->ActivateHistogram(*rtFile);
 
 
-		p_TexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), volumeMask->GetVoidPtr(), WGPUTextureDimension_3D, volumeMask->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "Mask texture");
+		p_TexData = VolumeTexture::CreateMask(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *volumeMask, 0, "Mask texture");
 
-		p_RTTexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), rtFile->GetVoidPtr(), WGPUTextureDimension_3D, rtFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "RT texture");
+		p_RTTexData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *rtFile, "RT texture");
 
-		p_CTTexData = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), ctFile->GetVoidPtr(), WGPUTextureDimension_3D, ctFile->GetSize(),
-			WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(glm::vec4), "CT texture");
+		p_CTTexData = VolumeTexture::CreateDensity(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT texture");
+		p_CTGradientTexData = VolumeTexture::CreateGradient(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), *ctFile, "CT gradient texture");
 
 
-		m_BGroup.AddTexture(*p_TexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_TexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Uint);
 		m_BGroup.AddTexture(*p_RTTexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_CTTexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_OpacityTfCT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_ColorTfCT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_OpacityTfRT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.AddTexture(*p_ColorTfRT->GetTexture(), WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
+		m_BGroup.AddTexture(*p_CTGradientTexData, WGPUShaderStage_Fragment, WGPUTextureSampleType_Float);
 		m_BGroup.FinalizeBindGroup(base::GraphicsContext::GetDevice());
 		IntializePipeline(pipeline);
 	}
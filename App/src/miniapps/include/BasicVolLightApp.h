@@ -6,6 +6,8 @@
 #include "../../renderer/RenderPipeline.h"
 #include "../../tf/ColorTf.h"
 #include "../../tf/OpacityTf.h"
+#include "../../tf/TfPresetPanel.h"
+#include "../../tf/TransferFunction2D.h"
 #include "../../renderer/Light.h"
 
 namespace med
@@ -23,10 +25,21 @@ namespace med
 
 	private:
 		std::shared_ptr<Texture> p_TexData = nullptr;
+		std::shared_ptr<Texture> p_TexGradientData = nullptr;
 		BindGroup m_BGroup;
 		std::unique_ptr<OpacityTF> p_OpacityTf = nullptr;
 		std::unique_ptr<ColorTF> p_ColorTf = nullptr;
+		std::unique_ptr<TransferFunction2D> p_Tf2D = nullptr;
+		std::unique_ptr<TFPresetPanel> p_PresetPanel = nullptr;
 		std::shared_ptr<UniformBuffer> p_ULight = nullptr;
+		OccupancyMap m_Occupancy;
+		std::shared_ptr<Texture> p_TexOccupancy = nullptr;
+		std::shared_ptr<UniformBuffer> p_UTfMode = nullptr;
+		// Largest opacity of every density over the magnitudes of the 2D TF, classifies the occupancy in 2D mode
+		std::vector<float> m_Tf2DOpacity{};
+		// Checkbox of the UI (const OnImGuiRender), mode used by the shader is switched in OnUpdate
+		mutable bool m_UseTf2D = false;
+		int m_TfMode = 0;
 
 
 		Light m_Light1
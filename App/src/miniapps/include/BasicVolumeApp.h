@@ -6,6 +6,7 @@
 #include "../../renderer/RenderPipeline.h"
 #include "../../tf/ColorTf.h"
 #include "../../tf/OpacityTf.h"
+#include "../../tf/TfPresetPanel.h"
 
 namespace med
 {
@@ -30,5 +31,8 @@ namespace med
 		BindGroup m_BGroup;
 		std::unique_ptr<OpacityTF> p_OpacityTf = nullptr;
 		std::unique_ptr<ColorTF> p_ColorTf = nullptr;
+		std::unique_ptr<TFPresetPanel> p_PresetPanel = nullptr;
+		OccupancyMap m_Occupancy;
+		std::shared_ptr<Texture> p_TexOccupancy = nullptr;
 	};
 }
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include "Base/Timestep.h"
 #include "../../renderer/Texture.h"
+#include "../../renderer/VolumeTexture.h"
 #include "../../renderer/BindGroup.h"
 #include "../../renderer/PipelineBuilder.h"
 #include "../../renderer/RenderPipeline.h"
@@ -13,6 +14,7 @@
 #include "../../tf/OpacityTf.h"
 #include "../../renderer/Light.h"
 #include "../../file/VolumeFile.h"
+#include "../../file/OccupancyMap.h"
 
 #define MED_BEGIN_TAB_BAR(name) \
 	if (ImGui::BeginTabBar(name)) \
@@ -55,10 +57,13 @@ namespace med
 
 		float GetStepSize() const { return m_StepSize; }
 		int GetStepsCount() const { return m_StepsCount; }
+		float GetOpacityThreshold() const { return m_OpacityThreshold; }
 		std::tuple<float, float, float> GetBBoxSize() const { return m_BBoxSize; }
 	protected:
 		float m_StepSize = 0.0f;
 		int m_StepsCount = 0;
+		// Ray marching stops once the accumulated opacity reaches it, 1.0 marches until the ray is fully opaque
+		float m_OpacityThreshold = 0.95f;
 		std::tuple<float, float, float> m_BBoxSize = { 0.0f, 0.0f, 0.0f };
 	};
 }
\ No newline at end of file
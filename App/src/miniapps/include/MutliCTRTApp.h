@@ -15,6 +15,7 @@ namespace med
 	private:
 		std::shared_ptr<Texture> p_TexCTData = nullptr;
 		std::shared_ptr<Texture> p_TexRTData = nullptr;
+		std::shared_ptr<Texture> p_TexCTGradientData = nullptr;
 		std::shared_ptr<Texture> p_TexMaskData = nullptr;
 		BindGroup m_BGroup;
 		std::unique_ptr<OpacityTF> p_OpacityTfCT = nullptr;
@@ -22,6 +23,8 @@ namespace med
 		std::unique_ptr<ColorTF> p_ColorTfCT = nullptr;
 		std::unique_ptr<ColorTF> p_ColorTfRT = nullptr;
 		std::shared_ptr<UniformBuffer> p_ULight = nullptr;
+		OccupancyMap m_Occupancy;
+		std::shared_ptr<Texture> p_TexOccupancy = nullptr;
 
 		Light m_Light1
 		{
@@ -23,6 +23,7 @@ namespace med
 	private:
 		std::shared_ptr<Texture> p_TexData = nullptr;
 		std::shared_ptr<Texture> p_CTTexData = nullptr;
+		std::shared_ptr<Texture> p_CTGradientTexData = nullptr;
 		std::shared_ptr<Texture> p_RTTexData = nullptr;
 		std::unique_ptr<OpacityTF> p_OpacityTfCT = nullptr;
 		std::unique_ptr<OpacityTF> p_OpacityTfRT = nullptr;
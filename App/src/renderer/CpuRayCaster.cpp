@@ -0,0 +1,562 @@
+#include "CpuRayCaster.h"
+#include "Base/Base.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+
+namespace med
+{
+	namespace
+	{
+		/*
+		* Linear filtering with clamp to edge, texel i is centered at (i + 0.5) / size as with the linear sampler.
+		*/
+		template<typename Fetch>
+		auto Trilinear(glm::vec3 position, glm::ivec3 size, Fetch&& fetch)
+		{
+			const glm::vec3 coord = position * glm::vec3(size) - glm::vec3(0.5f);
+			const glm::vec3 base = glm::floor(coord);
+			const glm::vec3 t = coord - base;
+			const glm::ivec3 i0 = glm::clamp(glm::ivec3(base), glm::ivec3(0), size - glm::ivec3(1));
+			const glm::ivec3 i1 = glm::clamp(glm::ivec3(base) + glm::ivec3(1), glm::ivec3(0), size - glm::ivec3(1));
+
+			const auto at = [&](int x, int y, int z)
+			{
+				return fetch((static_cast<size_t>(z) * size.y + y) * size.x + x);
+			};
+
+			const auto c00 = glm::mix(at(i0.x, i0.y, i0.z), at(i1.x, i0.y, i0.z), t.x);
+			const auto c10 = glm::mix(at(i0.x, i1.y, i0.z), at(i1.x, i1.y, i0.z), t.x);
+			const auto c01 = glm::mix(at(i0.x, i0.y, i1.z), at(i1.x, i0.y, i1.z), t.x);
+			const auto c11 = glm::mix(at(i0.x, i1.y, i1.z), at(i1.x, i1.y, i1.z), t.x);
+
+			return glm::mix(glm::mix(c00, c10, t.y), glm::mix(c01, c11, t.y), t.z);
+		}
+
+		template<typename T>
+		T SampleTexels(std::span<const T> texels, float coordinate)
+		{
+			const float coord = std::clamp(coordinate * texels.size() - 0.5f, 0.0f, texels.size() - 1.0f);
+			const size_t i0 = static_cast<size_t>(coord);
+			const size_t i1 = std::min(i0 + 1, texels.size() - 1);
+			return glm::mix(texels[i0], texels[i1], coord - static_cast<float>(i0));
+		}
+
+		// Blinn-Phong weights of the shader
+		constexpr float kDiffuse = 2.5f;
+		constexpr float kAmbient = 0.5f;
+
+		glm::vec4 FrontToBackBlend(glm::vec4 src, glm::vec4 dst)
+		{
+			// Not pre-multiplied alpha
+			glm::vec4 src_ = src * src.a;
+			src_.a = src.a;
+
+			return (1.0f - dst.a) * src_ + dst;
+		}
+
+		float Jitter(glm::vec2 co)
+		{
+			const float value = std::sin(glm::dot(co, glm::vec2(12.9898f, 78.233f))) * 43758.5453f;
+			return value - std::floor(value);
+		}
+
+		/*
+		* Distances along the ray where it enters (x) and leaves (y) the clip box, the ray misses the box if x > y.
+		*/
+		glm::vec2 ClipRay(glm::vec3 start, glm::vec3 direction, float length, const CpuRenderSettings& settings)
+		{
+			const glm::vec3 bMin(settings.ClipX.x, settings.ClipY.x, settings.ClipZ.x);
+			const glm::vec3 bMax(1.0f - settings.ClipX.y, 1.0f - settings.ClipY.y, 1.0f - settings.ClipZ.y);
+
+			for (int i = 0; i < 3; ++i)
+			{
+				direction[i] = std::abs(direction[i]) < 1e-8f ? 1e-8f : direction[i];
+			}
+			const glm::vec3 t0 = (bMin - start) / direction;
+			const glm::vec3 t1 = (bMax - start) / direction;
+			const glm::vec3 tNear = glm::min(t0, t1);
+			const glm::vec3 tFar = glm::max(t0, t1);
+
+			return { std::max({ tNear.x, tNear.y, tNear.z, 0.0f }), std::min({ tFar.x, tFar.y, tFar.z, length }) };
+		}
+
+		/*
+		* Packet helpers, one value per lane. Loops run over all lanes without branches so they vectorize,
+		* fetches through per lane indices become gathers.
+		*/
+		using Lanes = std::array<float, CpuRayCaster::kPacketWidth>;
+		using LaneIndices = std::array<std::uint32_t, CpuRayCaster::kPacketWidth>;
+
+		// Same formula as glm::mix, keeps the packet path in line with the scalar one
+		inline float Lerp(float x, float y, float t)
+		{
+			return x * (1.0f - t) + y * t;
+		}
+
+		/*
+		* Corner indices and weights of the trilinear footprint of every lane, clamp to edge.
+		*/
+		struct TrilinearLanes
+		{
+			// Corner c (bit 0 x, bit 1 y, bit 2 z) of lane l is Index[c][l]
+			std::array<LaneIndices, 8> Index{};
+			Lanes Tx{}, Ty{}, Tz{};
+
+			TrilinearLanes(const Lanes& px, const Lanes& py, const Lanes& pz, glm::ivec3 size)
+			{
+				for (int l = 0; l < CpuRayCaster::kPacketWidth; ++l)
+				{
+					const float cx = px[l] * size.x - 0.5f;
+					const float cy = py[l] * size.y - 0.5f;
+					const float cz = pz[l] * size.z - 0.5f;
+					const float bx = std::floor(cx);
+					const float by = std::floor(cy);
+					const float bz = std::floor(cz);
+					Tx[l] = cx - bx;
+					Ty[l] = cy - by;
+					Tz[l] = cz - bz;
+
+					const int x0 = std::clamp(static_cast<int>(bx), 0, size.x - 1);
+					const int y0 = std::clamp(static_cast<int>(by), 0, size.y - 1);
+					const int z0 = std::clamp(static_cast<int>(bz), 0, size.z - 1);
+					// Offsets of the upper corners, zero at the upper edge (clamp to edge)
+					const int ox = std::min(static_cast<int>(bx) + 1, size.x - 1) > x0 ? 1 : 0;
+					const int oy = std::min(static_cast<int>(by) + 1, size.y - 1) > y0 ? size.x : 0;
+					const int oz = std::min(static_cast<int>(bz) + 1, size.z - 1) > z0 ? size.x * size.y : 0;
+
+					const int base = (z0 * size.y + y0) * size.x + x0;
+					for (int c = 0; c < 8; ++c)
+					{
+						Index[c][l] = static_cast<std::uint32_t>(base + (c & 1 ? ox : 0) + (c & 2 ? oy : 0) + (c & 4 ? oz : 0));
+					}
+				}
+			}
+
+			/*
+			* Interpolates the values fetched for every corner, fetch(index) is the gather of one channel.
+			*/
+			template<typename Fetch>
+			Lanes Interpolate(Fetch&& fetch) const
+			{
+				std::array<Lanes, 8> corner;
+				for (int c = 0; c < 8; ++c)
+				{
+					for (int l = 0; l < CpuRayCaster::kPacketWidth; ++l)
+					{
+						corner[c][l] = fetch(Index[c][l]);
+					}
+				}
+
+				Lanes result;
+				for (int l = 0; l < CpuRayCaster::kPacketWidth; ++l)
+				{
+					const float c00 = Lerp(corner[0][l], corner[1][l], Tx[l]);
+					const float c10 = Lerp(corner[2][l], corner[3][l], Tx[l]);
+					const float c01 = Lerp(corner[4][l], corner[5][l], Tx[l]);
+					const float c11 = Lerp(corner[6][l], corner[7][l], Tx[l]);
+					result[l] = Lerp(Lerp(c00, c10, Ty[l]), Lerp(c01, c11, Ty[l]), Tz[l]);
+				}
+				return result;
+			}
+		};
+
+		/*
+		* Linear TF lookup of every lane, fetch(texel, channel) is the gather.
+		*/
+		template<int Channels, typename Fetch>
+		std::array<Lanes, Channels> SampleTexelLanes(const Lanes& coordinate, size_t resolution, Fetch&& fetch)
+		{
+			LaneIndices i0, i1;
+			Lanes t;
+			for (int l = 0; l < CpuRayCaster::kPacketWidth; ++l)
+			{
+				const float coord = std::clamp(coordinate[l] * resolution - 0.5f, 0.0f, resolution - 1.0f);
+				i0[l] = static_cast<std::uint32_t>(coord);
+				i1[l] = std::min(i0[l] + 1, static_cast<std::uint32_t>(resolution - 1));
+				t[l] = coord - static_cast<float>(i0[l]);
+			}
+
+			std::array<Lanes, Channels> result;
+			for (int c = 0; c < Channels; ++c)
+			{
+				for (int l = 0; l < CpuRayCaster::kPacketWidth; ++l)
+				{
+					result[c][l] = Lerp(fetch(i0[l], c), fetch(i1[l], c), t[l]);
+				}
+			}
+			return result;
+		}
+	}
+
+	CpuRayCaster::CpuRayCaster(const VolumeFile& file, std::span<const float> opacity, std::span<const glm::vec4> colors, const Light& light) :
+		m_File(file), m_Opacity(opacity), m_Colors(colors), m_Light(light)
+	{
+		assert(file.GetDensityBuffer().GetChannels() == 1 && "CPU ray caster renders single channel data");
+		assert(!opacity.empty() && !colors.empty() && "TF has no texels");
+	}
+
+	std::vector<glm::vec4> CpuRayCaster::Render(const glm::mat4& inverseView, const glm::mat4& inverseProjection,
+		const CpuRenderSettings& settings) const
+	{
+		std::vector<glm::vec4> image(static_cast<size_t>(settings.Width) * settings.Height, glm::vec4(0.0f));
+		if (image.empty() || m_Opacity.empty() || m_Colors.empty())
+		{
+			LOG_WARN("CPU ray caster: nothing to render");
+			return image;
+		}
+
+		const glm::mat4 inverseViewProjection = inverseView * inverseProjection;
+		const std::uint32_t tileSize = std::max<std::uint32_t>(settings.TileSize, 1);
+		const std::uint32_t tilesX = (settings.Width + tileSize - 1) / tileSize;
+		const std::uint32_t tilesY = (settings.Height + tileSize - 1) / tileSize;
+
+		m_File.GetDensityBuffer().Visit([&](auto data)
+		{
+			using T = std::remove_cvref_t<decltype(data[0])>;
+			const std::span<const T> voxels(data.data(), data.size());
+			// Packet gathers index with 32 bits
+			const bool packets = settings.Packets && voxels.size() <= static_cast<size_t>(std::numeric_limits<std::int32_t>::max());
+
+			// Tiles are handed out one by one, expensive tiles (dense parts of the volume) do not hold back the others
+			base::ThreadPool::Get().ParallelFor(0, static_cast<size_t>(tilesX) * tilesY, [&](size_t tile)
+			{
+				const std::uint32_t x0 = static_cast<std::uint32_t>(tile % tilesX) * tileSize;
+				const std::uint32_t y0 = static_cast<std::uint32_t>(tile / tilesX) * tileSize;
+
+				const std::uint32_t xEnd = std::min(x0 + tileSize, settings.Width);
+				for (std::uint32_t y = y0; y < std::min(y0 + tileSize, settings.Height); ++y)
+				{
+					for (std::uint32_t x = x0; x < xEnd; x += kPacketWidth)
+					{
+						// Lanes are neighbouring pixels of the row, bit l of 'lanes' is set if the ray of lane l hits the cube
+						std::array<Ray, kPacketWidth> rays;
+						std::uint32_t lanes = 0;
+						for (std::uint32_t l = 0; l < std::min<std::uint32_t>(kPacketWidth, xEnd - x); ++l)
+						{
+							// Fragment position is the pixel center, y of NDC goes up
+							const glm::vec2 pixel(x + l + 0.5f, y + 0.5f);
+							const glm::vec2 ndc(pixel.x / settings.Width * 2.0f - 1.0f, 1.0f - pixel.y / settings.Height * 2.0f);
+							lanes |= SetupRay(ndc, inverseViewProjection, settings, rays[l]) ? 1u << l : 0u;
+						}
+
+						glm::vec4* result = image.data() + static_cast<size_t>(y) * settings.Width + x;
+						if (packets && std::popcount(lanes) > 1)
+						{
+							MarchPacket(voxels, rays, lanes, glm::vec2(x + 0.5f, y + 0.5f), settings, result);
+							continue;
+						}
+
+						for (int l = 0; l < kPacketWidth; ++l)
+						{
+							if (lanes & (1u << l))
+							{
+								result[l] = March(voxels, rays[l], glm::vec2(x + l + 0.5f, y + 0.5f), settings);
+							}
+						}
+					}
+				}
+			});
+		});
+
+		return image;
+	}
+
+	std::vector<std::uint8_t> CpuRayCaster::Compose(std::span<const glm::vec4> image, glm::vec3 background)
+	{
+		std::vector<std::uint8_t> rgb(image.size() * 3);
+		for (size_t i = 0; i < image.size(); ++i)
+		{
+			// Volume pass blends with SrcAlpha, OneMinusSrcAlpha
+			const glm::vec4& pixel = image[i];
+			for (int c = 0; c < 3; ++c)
+			{
+				const float value = pixel[c] * pixel.a + background[c] * (1.0f - pixel.a);
+				rgb[i * 3 + c] = static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+			}
+		}
+		return rgb;
+	}
+
+	bool CpuRayCaster::SetupRay(glm::vec2 ndc, const glm::mat4& inverseViewProjection, const CpuRenderSettings& settings, Ray& ray)
+	{
+		// Any two points on the pixel's line of sight, works for both projections
+		const glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 0.0f, 1.0f);
+		const glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 1.0f, 1.0f);
+		const glm::vec3 origin = glm::vec3(nearPoint.x, nearPoint.y, nearPoint.z) / nearPoint.w;
+		glm::vec3 direction = glm::normalize(glm::vec3(farPoint.x, farPoint.y, farPoint.z) / farPoint.w - origin);
+
+		// Front and back face of the proxy cube
+		const glm::vec3 boxMax = settings.BoxSize * 0.5f;
+		for (int i = 0; i < 3; ++i)
+		{
+			direction[i] = std::abs(direction[i]) < 1e-8f ? 1e-8f : direction[i];
+		}
+		const glm::vec3 t0 = (-boxMax - origin) / direction;
+		const glm::vec3 t1 = (boxMax - origin) / direction;
+		const glm::vec3 tNear = glm::min(t0, t1);
+		const glm::vec3 tFar = glm::max(t0, t1);
+		const float tEnter = std::max({ tNear.x, tNear.y, tNear.z });
+		const float tExit = std::min({ tFar.x, tFar.y, tFar.z });
+
+		if (tExit <= tEnter)
+		{
+			return false;
+		}
+
+		// Texture coordinates of the cube vertices, w goes against z
+		const auto toTexture = [&settings](glm::vec3 world)
+		{
+			return glm::vec3(world.x / settings.BoxSize.x + 0.5f, world.y / settings.BoxSize.y + 0.5f, 0.5f - world.z / settings.BoxSize.z);
+		};
+
+		ray.WorldStart = origin + direction * tEnter;
+		ray.Start = toTexture(ray.WorldStart);
+		ray.End = toTexture(origin + direction * tExit);
+		ray.Length = glm::length(ray.End - ray.Start);
+		if (ray.Length <= 0.0f)
+		{
+			return false;
+		}
+		ray.Direction = (ray.End - ray.Start) / ray.Length;
+
+		return true;
+	}
+
+	CpuRayCaster::MarchRange CpuRayCaster::BeginMarch(const Ray& ray, glm::vec2 pixel, const CpuRenderSettings& settings)
+	{
+		MarchRange range;
+		range.StepSize = settings.StepSize;
+		// Like the shader, world step is derived from the uniform step size even with variable step size on
+		range.WorldStep = ray.Direction * settings.BoxSize * range.StepSize;
+		range.WorldStep.z *= -1.0f;
+
+		if (settings.VariableStepSize)
+		{
+			range.StepSize = ray.Length / static_cast<float>(settings.StepsCount);
+		}
+
+		range.FirstSample = settings.Jitter ? range.StepSize * Jitter(pixel) : 0.0f;
+		range.Step = ray.Direction * range.StepSize;
+
+		// Samples stay on the grid firstSample + k * stepSize, only the part of the ray within the clip box is marched
+		const glm::vec2 clip = ClipRay(ray.Start, ray.Direction, ray.Length, settings);
+		range.End = clip.y;
+		range.First = std::clamp(static_cast<int>(std::ceil((clip.x - range.FirstSample) / range.StepSize)), 0, settings.StepsCount);
+		range.Position = ray.Start + ray.Direction * range.FirstSample + range.Step * static_cast<float>(range.First);
+		range.WorldPosition = ray.WorldStart + range.WorldStep * static_cast<float>(range.First);
+
+		return range;
+	}
+
+	template<typename T>
+	glm::vec4 CpuRayCaster::March(std::span<const T> voxels, const Ray& ray, glm::vec2 pixel, const CpuRenderSettings& settings) const
+	{
+		const auto [xS, yS, zS] = m_File.GetSize();
+		const glm::ivec3 size(xS, yS, zS);
+		const float scale = m_File.GetDensityScale();
+		const auto& gradient = m_File.GetGradient();
+		const bool hasGradient = m_File.HasGradient() && gradient.size() == voxels.size();
+		const bool bricked = m_File.GetVoxelLayout() == VoxelLayout::Bricked;
+
+		const MarchRange range = BeginMarch(ray, pixel, settings);
+		glm::vec3 currentPosition = range.Position;
+		glm::vec3 worldPosition = range.WorldPosition;
+
+		glm::vec4 dst(0.0f);
+		for (int i = range.First; i < settings.StepsCount; ++i)
+		{
+			if (range.FirstSample + static_cast<float>(i) * range.StepSize > range.End || dst.a >= settings.OpacityThreshold)
+			{
+				break;
+			}
+
+			// Bricked layout is read through its own sampler, linear data are fetched directly
+			const float density = bricked ? m_File.SampleDensity(currentPosition)
+				: Trilinear(currentPosition, size, [&](size_t index) { return static_cast<float>(voxels[index]) * scale; });
+			const float opacity = SampleOpacity(density);
+
+			// Zero opacity sample does not contribute
+			if (opacity > 0.0f)
+			{
+				glm::vec3 color = SampleColor(density);
+				if (hasGradient)
+				{
+					const glm::vec3 g = Trilinear(currentPosition, size, [&](size_t index) { return gradient[index]; });
+					const float l = glm::length(g);
+					color *= BlinnPhong(l > 0.0f ? g / l : glm::vec3(0.0f), worldPosition);
+				}
+
+				dst = FrontToBackBlend(glm::vec4(color.r, color.g, color.b, opacity), dst);
+			}
+
+			currentPosition += range.Step;
+			worldPosition += range.WorldStep;
+		}
+
+		return dst;
+	}
+
+	template<typename T>
+	void CpuRayCaster::MarchPacket(std::span<const T> voxels, const std::array<Ray, kPacketWidth>& rays, std::uint32_t lanes, glm::vec2 pixel,
+		const CpuRenderSettings& settings, glm::vec4* result) const
+	{
+		static_assert(sizeof(glm::vec3) == 3 * sizeof(float) && sizeof(glm::vec4) == 4 * sizeof(float));
+		constexpr int N = kPacketWidth;
+
+		const auto [xS, yS, zS] = m_File.GetSize();
+		const glm::ivec3 size(xS, yS, zS);
+		const float scale = m_File.GetDensityScale();
+		const auto& gradient = m_File.GetGradient();
+		const bool hasGradient = m_File.HasGradient() && gradient.size() == voxels.size();
+		const bool bricked = m_File.GetVoxelLayout() == VoxelLayout::Bricked;
+		const float* gradientData = reinterpret_cast<const float*>(gradient.data());
+		const float* colorData = reinterpret_cast<const float*>(m_Colors.data());
+
+		// Structure of arrays, lanes without a ray start terminated
+		Lanes px{}, py{}, pz{}, sx{}, sy{}, sz{};
+		Lanes wx{}, wy{}, wz{}, wsx{}, wsy{}, wsz{};
+		Lanes firstSample{}, stepSize{}, end{};
+		std::array<int, N> sample;
+		sample.fill(settings.StepsCount);
+		for (int l = 0; l < N; ++l)
+		{
+			if (lanes & (1u << l))
+			{
+				const MarchRange range = BeginMarch(rays[l], pixel + glm::vec2(static_cast<float>(l), 0.0f), settings);
+				px[l] = range.Position.x; py[l] = range.Position.y; pz[l] = range.Position.z;
+				sx[l] = range.Step.x; sy[l] = range.Step.y; sz[l] = range.Step.z;
+				wx[l] = range.WorldPosition.x; wy[l] = range.WorldPosition.y; wz[l] = range.WorldPosition.z;
+				wsx[l] = range.WorldStep.x; wsy[l] = range.WorldStep.y; wsz[l] = range.WorldStep.z;
+				firstSample[l] = range.FirstSample;
+				stepSize[l] = range.StepSize;
+				end[l] = range.End;
+				sample[l] = range.First;
+			}
+		}
+
+		Lanes r{}, g{}, b{}, a{};
+		for (;;)
+		{
+			// Every termination condition is monotonic, a lane once masked out stays masked out
+			Lanes active;
+			int activeCount = 0;
+			for (int l = 0; l < N; ++l)
+			{
+				const bool isActive = sample[l] < settings.StepsCount && firstSample[l] + static_cast<float>(sample[l]) * stepSize[l] <= end[l]
+					&& a[l] < settings.OpacityThreshold;
+				active[l] = isActive ? 1.0f : 0.0f;
+				activeCount += isActive;
+			}
+			if (activeCount == 0)
+			{
+				break;
+			}
+
+			const TrilinearLanes footprint(px, py, pz, size);
+			Lanes density;
+			if (bricked)
+			{
+				// Bricked copy has no per lane gather, every active lane samples it on its own
+				for (int l = 0; l < N; ++l)
+				{
+					density[l] = active[l] > 0.0f ? m_File.SampleDensity(glm::vec3(px[l], py[l], pz[l])) : 0.0f;
+				}
+			}
+			else
+			{
+				density = footprint.Interpolate([&](std::uint32_t i) { return static_cast<float>(voxels[i]) * scale; });
+			}
+			const Lanes opacity = SampleTexelLanes<1>(density, m_Opacity.size(), [&](std::uint32_t i, int) { return m_Opacity[i]; })[0];
+
+			// Zero opacity samples do not contribute, shading is skipped while the whole packet is in empty space
+			Lanes srcA;
+			bool contributes = false;
+			for (int l = 0; l < N; ++l)
+			{
+				srcA[l] = opacity[l] * active[l];
+				contributes |= srcA[l] > 0.0f;
+			}
+
+			if (contributes)
+			{
+				auto color = SampleTexelLanes<3>(density, m_Colors.size(), [&](std::uint32_t i, int c) { return colorData[i * 4 + c]; });
+				if (hasGradient)
+				{
+					const Lanes gx = footprint.Interpolate([&](std::uint32_t i) { return gradientData[static_cast<size_t>(i) * 3]; });
+					const Lanes gy = footprint.Interpolate([&](std::uint32_t i) { return gradientData[static_cast<size_t>(i) * 3 + 1]; });
+					const Lanes gz = footprint.Interpolate([&](std::uint32_t i) { return gradientData[static_cast<size_t>(i) * 3 + 2]; });
+
+					for (int l = 0; l < N; ++l)
+					{
+						const float length = std::sqrt(gx[l] * gx[l] + gy[l] * gy[l] + gz[l] * gz[l]);
+						const float nx = length > 0.0f ? gx[l] / length : 0.0f;
+						const float ny = length > 0.0f ? gy[l] / length : 0.0f;
+						const float nz = length > 0.0f ? gz[l] / length : 0.0f;
+
+						const float lx = m_Light.Position.x - wx[l];
+						const float ly = m_Light.Position.y - wy[l];
+						const float lz = m_Light.Position.z - wz[l];
+						const float lightLength = std::sqrt(lx * lx + ly * ly + lz * lz);
+						const float shade = std::max((nx * lx + ny * ly + nz * lz) / lightLength, 0.0f);
+
+						color[0][l] *= m_Light.Diffuse.r * shade * kDiffuse + m_Light.Ambient.r * kAmbient;
+						color[1][l] *= m_Light.Diffuse.g * shade * kDiffuse + m_Light.Ambient.g * kAmbient;
+						color[2][l] *= m_Light.Diffuse.b * shade * kDiffuse + m_Light.Ambient.b * kAmbient;
+					}
+				}
+
+				// Masked lanes blend zero opacity, which leaves them unchanged
+				for (int l = 0; l < N; ++l)
+				{
+					const float transmittance = 1.0f - a[l];
+					r[l] = transmittance * (color[0][l] * srcA[l]) + r[l];
+					g[l] = transmittance * (color[1][l] * srcA[l]) + g[l];
+					b[l] = transmittance * (color[2][l] * srcA[l]) + b[l];
+					a[l] = transmittance * srcA[l] + a[l];
+				}
+			}
+
+			for (int l = 0; l < N; ++l)
+			{
+				px[l] += sx[l]; py[l] += sy[l]; pz[l] += sz[l];
+				wx[l] += wsx[l]; wy[l] += wsy[l]; wz[l] += wsz[l];
+				++sample[l];
+			}
+		}
+
+		for (int l = 0; l < N; ++l)
+		{
+			if (lanes & (1u << l))
+			{
+				result[l] = glm::vec4(r[l], g[l], b[l], a[l]);
+			}
+		}
+	}
+
+	float CpuRayCaster::SampleOpacity(float density) const
+	{
+		return SampleTexels(m_Opacity, density);
+	}
+
+	glm::vec3 CpuRayCaster::SampleColor(float density) const
+	{
+		const glm::vec4 color = SampleTexels(m_Colors, density);
+		return glm::vec3(color.r, color.g, color.b);
+	}
+
+	glm::vec3 CpuRayCaster::BlinnPhong(glm::vec3 normal, glm::vec3 worldPosition) const
+	{
+		const glm::vec3 lightPosition(m_Light.Position.x, m_Light.Position.y, m_Light.Position.z);
+		const glm::vec3 L = glm::normalize(lightPosition - worldPosition);
+
+		const glm::vec3 diffuse(m_Light.Diffuse.r, m_Light.Diffuse.g, m_Light.Diffuse.b);
+		const glm::vec3 ambient(m_Light.Ambient.r, m_Light.Ambient.g, m_Light.Ambient.b);
+		return diffuse * std::max(glm::dot(normal, L), 0.0f) * kDiffuse + ambient * kAmbient;
+	}
+}
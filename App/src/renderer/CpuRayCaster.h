@@ -0,0 +1,128 @@
+#pragma once
+
+#include "Light.h"
+#include "../file/VolumeFile.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace med
+{
+	/**
+	 * @brief Parameters of CpuRayCaster::Render, mirror the default Application uniforms.
+	 */
+	struct CpuRenderSettings
+	{
+		std::uint32_t Width = 512;
+		std::uint32_t Height = 512;
+		int StepsCount = 200;
+		float StepSize = 0.01f;
+		float OpacityThreshold = 0.95f;
+		glm::vec2 ClipX{ 0.0f };
+		glm::vec2 ClipY{ 0.0f };
+		glm::vec2 ClipZ{ 0.0f };
+		// toggles[0] and toggles[1] of the shaders
+		bool VariableStepSize = false;
+		bool Jitter = false;
+		// Proxy cube centered at the origin, same as the Application cube (texture w axis goes against world z)
+		glm::vec3 BoxSize{ 1.0f, 1.0f, 0.5f };
+		// Image is split into TileSize x TileSize tiles, each tile is one task of the thread pool
+		std::uint32_t TileSize = 16;
+		// March CpuRayCaster::kPacketWidth neighbouring rays of a row together, false marches ray by ray (reference)
+		bool Packets = true;
+	};
+
+	/**
+	 * @brief CPU counterpart of fs_main in BasicVolLightApp.wgsl, renders without a GPU (regression tests, offline thumbnails).
+	 * Trilinear density and gradient sampling (clamp to edge), linear 1D TF lookups, Blinn-Phong and front to back blending,
+	 * tiles are rendered in parallel on base::ThreadPool.
+	 * Packets of horizontally adjacent rays are marched in lockstep (structure of arrays, one loop iteration per lane
+	 * so the compiler emits SIMD code), finished lanes are masked out until the whole packet terminates.
+	 * Density follows the voxel layout of the file: the bricked copy is sampled through VolumeFile::SampleDensity,
+	 * linear data are gathered directly. Gradient is always linear.
+	 * File and TF data are referenced, they have to outlive the caster.
+	 */
+	class CpuRayCaster
+	{
+	public:
+		static constexpr int kPacketWidth = 8;
+
+		/**
+		 * @param opacity Opacity TF texels over [0, 1] (OpacityTF::GetOpacities)
+		 * @param colors Color TF texels over [0, 1] (ColorTF::GetColors)
+		 */
+		CpuRayCaster(const VolumeFile& file, std::span<const float> opacity, std::span<const glm::vec4> colors, const Light& light);
+
+		/**
+		 * @brief Renders the volume, rows go from top to bottom, pixels are the blended (premultiplied) results of the rays.
+		 * @param inverseView Camera::GetInverseViewMatrix
+		 * @param inverseProjection Camera::GetInverseProjectionMatrix
+		 */
+		[[nodiscard]] std::vector<glm::vec4> Render(const glm::mat4& inverseView, const glm::mat4& inverseProjection,
+			const CpuRenderSettings& settings) const;
+
+		/**
+		 * @brief Blends the image over the background the way the volume pass does over the background pass, 8-bit RGB.
+		 */
+		[[nodiscard]] static std::vector<std::uint8_t> Compose(std::span<const glm::vec4> image, glm::vec3 background = glm::vec3(1.0f));
+
+	private:
+		struct Ray
+		{
+			glm::vec3 Start{ 0.0f };
+			glm::vec3 End{ 0.0f };
+			glm::vec3 Direction{ 0.0f };
+			float Length = 0.0f;
+			// Proxy cube entry in world coordinates
+			glm::vec3 WorldStart{ 0.0f };
+		};
+
+		/*
+		* Ray between the front and back face of the proxy cube (texture coordinates), false if the pixel misses the cube.
+		*/
+		static bool SetupRay(glm::vec2 ndc, const glm::mat4& inverseViewProjection, const CpuRenderSettings& settings, Ray& ray);
+
+		/*
+		* Samples of one ray within the clip box, shared by the scalar and the packet path.
+		*/
+		struct MarchRange
+		{
+			// First sample within the clip box and the sample steps, texture and world coordinates
+			glm::vec3 Position{ 0.0f };
+			glm::vec3 Step{ 0.0f };
+			glm::vec3 WorldPosition{ 0.0f };
+			glm::vec3 WorldStep{ 0.0f };
+			// Sample i lies at FirstSample + i * StepSize along the ray, samples beyond End are outside of the clip box
+			float FirstSample = 0.0f;
+			float StepSize = 0.0f;
+			float End = 0.0f;
+			int First = 0;
+		};
+
+		static MarchRange BeginMarch(const Ray& ray, glm::vec2 pixel, const CpuRenderSettings& settings);
+
+		template<typename T>
+		glm::vec4 March(std::span<const T> voxels, const Ray& ray, glm::vec2 pixel, const CpuRenderSettings& settings) const;
+
+		/*
+		* Marches the rays of the lanes set in 'lanes', pixel is the center of the first lane, results of the other lanes are untouched.
+		*/
+		template<typename T>
+		void MarchPacket(std::span<const T> voxels, const std::array<Ray, kPacketWidth>& rays, std::uint32_t lanes, glm::vec2 pixel,
+			const CpuRenderSettings& settings, glm::vec4* result) const;
+
+		float SampleOpacity(float density) const;
+		glm::vec3 SampleColor(float density) const;
+		glm::vec3 BlinnPhong(glm::vec3 normal, glm::vec3 worldPosition) const;
+
+	private:
+		const VolumeFile& m_File;
+		std::span<const float> m_Opacity;
+		std::span<const glm::vec4> m_Colors;
+		Light m_Light;
+	};
+}
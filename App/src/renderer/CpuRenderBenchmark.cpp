@@ -0,0 +1,53 @@
+#include "CpuRenderBenchmark.h"
+#include "Base/Base.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+namespace med
+{
+	CpuBenchmarkResult CpuRenderBenchmark::Run(const CpuRayCaster& caster, const glm::mat4& inverseView, const glm::mat4& inverseProjection,
+		CpuRenderSettings settings, int repetitions)
+	{
+		repetitions = std::max(repetitions, 1);
+		const double rays = static_cast<double>(settings.Width) * settings.Height * repetitions;
+
+		const auto measure = [&](bool packets, std::vector<glm::vec4>& image)
+		{
+			settings.Packets = packets;
+			image = caster.Render(inverseView, inverseProjection, settings);
+
+			const auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < repetitions; ++i)
+			{
+				image = caster.Render(inverseView, inverseProjection, settings);
+			}
+			const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			return rays / elapsed.count() * 1e-6;
+		};
+
+		CpuBenchmarkResult result;
+		std::vector<glm::vec4> scalar, packet;
+		result.ScalarMRays = measure(false, scalar);
+		result.PacketMRays = measure(true, packet);
+
+		for (size_t i = 0; i < scalar.size(); ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				result.MaxDifference = std::max(result.MaxDifference, std::abs(scalar[i][c] - packet[i][c]));
+			}
+		}
+
+		std::stringstream s;
+		s << "CPU ray casting " << settings.Width << "x" << settings.Height << ": scalar " << result.ScalarMRays << " Mrays/s, packets of "
+			<< CpuRayCaster::kPacketWidth << " " << result.PacketMRays << " Mrays/s (" << result.PacketMRays / result.ScalarMRays
+			<< "x), max difference " << result.MaxDifference;
+		LOG_INFO(s.str().c_str());
+
+		return result;
+	}
+}
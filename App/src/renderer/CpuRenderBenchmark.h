@@ -0,0 +1,31 @@
+#pragma once
+
+#include "CpuRayCaster.h"
+
+#include <glm/glm.hpp>
+
+namespace med
+{
+	struct CpuBenchmarkResult
+	{
+		double ScalarMRays = 0.0;
+		double PacketMRays = 0.0;
+		// Largest per channel difference between the scalar and the packet image
+		float MaxDifference = 0.0f;
+	};
+
+	/**
+	 * @brief Throughput of the scalar and the packet path of CpuRayCaster on the same view, in millions of primary rays per second.
+	 */
+	class CpuRenderBenchmark
+	{
+	protected:
+		CpuRenderBenchmark() = default;
+	public:
+		/*
+		* Renders the view 'repetitions' times with each path (after a warm-up render) and logs the result.
+		*/
+		static CpuBenchmarkResult Run(const CpuRayCaster& caster, const glm::mat4& inverseView, const glm::mat4& inverseProjection,
+			CpuRenderSettings settings, int repetitions = 3);
+	};
+}
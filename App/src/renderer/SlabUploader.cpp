@@ -0,0 +1,105 @@
+#include "SlabUploader.h"
+
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace med
+{
+	SlabUploader::SlabUploader(std::size_t sliceBytes, std::uint32_t depth, std::size_t slabBytes, std::uint32_t ringSize) :
+		m_SliceBytes(sliceBytes), m_Depth(depth), m_RingSize(std::max<std::uint32_t>(ringSize, 1))
+	{
+		const std::size_t slicesPerSlab = sliceBytes != 0 ? slabBytes / sliceBytes : depth;
+		m_SlabDepth = static_cast<std::uint32_t>(std::clamp<std::size_t>(slicesPerSlab, 1, std::max<std::uint32_t>(depth, 1)));
+	}
+
+	void SlabUploader::Run(const Fill& fill, const Write& write, const Progress& progress) const
+	{
+		const std::uint32_t slabCount = GetSlabCount();
+		const std::uint32_t ringSize = std::min(m_RingSize, std::max<std::uint32_t>(slabCount, 1));
+
+		std::vector<std::vector<std::byte>> ring(ringSize, std::vector<std::byte>(m_SlabDepth * m_SliceBytes));
+		std::vector<std::future<void>> pending(slabCount);
+
+		auto slabDepth = [&](std::uint32_t slab)
+		{
+			return std::min(m_SlabDepth, m_Depth - slab * m_SlabDepth);
+		};
+
+		auto launch = [&](std::uint32_t slab)
+		{
+			auto promise = std::make_shared<std::promise<void>>();
+			pending[slab] = promise->get_future();
+
+			const std::uint32_t zBegin = slab * m_SlabDepth;
+			const std::uint32_t depth = slabDepth(slab);
+			const std::span<std::byte> dst(ring[slab % ringSize].data(), depth * m_SliceBytes);
+
+			base::ThreadPool::Get().Submit([promise, &fill, zBegin, depth, dst]()
+			{
+				try
+				{
+					fill(zBegin, depth, dst);
+					promise->set_value();
+				}
+				catch (...)
+				{
+					promise->set_exception(std::current_exception());
+				}
+			});
+		};
+
+		for (std::uint32_t slab = 0; slab < ringSize && slab < slabCount; ++slab)
+		{
+			launch(slab);
+		}
+
+		try
+		{
+			for (std::uint32_t slab = 0; slab < slabCount; ++slab)
+			{
+				pending[slab].get();
+
+				const std::uint32_t depth = slabDepth(slab);
+				write(slab * m_SlabDepth, depth, std::span<const std::byte>(ring[slab % ringSize].data(), depth * m_SliceBytes));
+
+				if (progress)
+				{
+					progress(static_cast<float>(slab + 1) / static_cast<float>(slabCount));
+				}
+
+				// Staging buffer is free again, the write has consumed it
+				if (slab + ringSize < slabCount)
+				{
+					launch(slab + ringSize);
+				}
+			}
+		}
+		catch (...)
+		{
+			// Slabs in flight still write into the ring
+			for (auto& future : pending)
+			{
+				if (future.valid())
+				{
+					future.wait();
+				}
+			}
+			throw;
+		}
+	}
+
+	std::uint32_t SlabUploader::GetSlabDepth() const
+	{
+		return m_SlabDepth;
+	}
+
+	std::uint32_t SlabUploader::GetSlabCount() const
+	{
+		return (m_Depth + m_SlabDepth - 1) / m_SlabDepth;
+	}
+}
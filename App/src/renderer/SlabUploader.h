@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+namespace med
+{
+	/**
+	 * @brief Streams a volume to its destination in z-slabs through a bounded ring of staging buffers.
+	 * Slabs are filled on the thread pool while the calling thread writes the previous ones, so preparing the data
+	 * (conversion, loading) overlaps with the upload and the whole volume never exists on the host at once.
+	 * Destination is abstracted by the write callback (queue write in Texture, mock in tests).
+	 */
+	class SlabUploader
+	{
+	public:
+		// Fills slices [zBegin, zBegin + depth), called from the thread pool
+		using Fill = std::function<void(std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst)>;
+		// Consumes the filled slab, always called from the thread that called Run, in increasing z order
+		using Write = std::function<void(std::uint32_t zBegin, std::uint32_t depth, std::span<const std::byte> src)>;
+		// Fraction of the volume that has been written, [0, 1]
+		using Progress = std::function<void(float)>;
+
+		static constexpr std::size_t kDefaultSlabBytes = 32ull << 20;
+		static constexpr std::uint32_t kDefaultRingSize = 3;
+
+		/**
+		 * @param sliceBytes size of one z-slice
+		 * @param depth number of slices
+		 * @param slabBytes upper bound of one slab, a slab has at least one slice
+		 * @param ringSize number of staging buffers (slabs in flight)
+		 */
+		SlabUploader(std::size_t sliceBytes, std::uint32_t depth, std::size_t slabBytes = kDefaultSlabBytes, std::uint32_t ringSize = kDefaultRingSize);
+
+		/**
+		 * @brief Blocks until the whole volume is written. First exception thrown by fill or write is rethrown
+		 * once no slab is in flight.
+		 */
+		void Run(const Fill& fill, const Write& write, const Progress& progress = {}) const;
+
+		[[nodiscard]] std::uint32_t GetSlabDepth() const;
+		[[nodiscard]] std::uint32_t GetSlabCount() const;
+
+	private:
+		std::size_t m_SliceBytes = 0;
+		std::uint32_t m_Depth = 0;
+		std::uint32_t m_SlabDepth = 1;
+		std::uint32_t m_RingSize = 1;
+	};
+}
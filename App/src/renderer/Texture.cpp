@@ -6,6 +6,10 @@
 
 namespace med
 {
+	namespace
+	{
+		Texture::QueueWriter s_QueueWriter = wgpuQueueWriteTexture;
+	}
 
 	Texture::Texture(WGPUTexture texture, WGPUTextureView textureView, WGPUTextureDescriptor texDesc, WGPUTextureViewDescriptor viewDesc,
 		WGPUTextureDataLayout layout, WGPUImageCopyTexture destination, std::string&& name) noexcept :
@@ -33,6 +37,14 @@ namespace med
 
 	std::shared_ptr<Texture> Texture::CreateFromData(const WGPUDevice& device, const WGPUQueue& queue, const void * dataPtr, WGPUTextureDimension dimension,
 	                                                 std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, WGPUTextureFormat format, WGPUTextureUsageFlags flags, std::uint32_t bytesPerElement, std::string&& name)
+	{
+		auto texture = Create(device, dimension, size, format, flags, bytesPerElement, std::move(name));
+		texture->WriteSlab(queue, 0, std::get<2>(size), dataPtr);
+		return texture;
+	}
+
+	std::shared_ptr<Texture> Texture::Create(const WGPUDevice& device, WGPUTextureDimension dimension, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size,
+		WGPUTextureFormat format, WGPUTextureUsageFlags flags, std::uint32_t bytesPerElement, std::string&& name)
 	{
 		WGPUTextureDescriptor texDesc{};
 
@@ -77,23 +89,90 @@ namespace med
 		destination.aspect = WGPUTextureAspect_All;
 		destination.texture = texture;
 
-		wgpuQueueWriteTexture(queue, &destination, dataPtr, (x * y * z * bytesPerElement), &srcTexLayout, &texDesc.size);
-
 		WGPUTextureView textureView = wgpuTextureCreateView(texture, &textureViewDesc);
 
 		return make_shared<Texture>(texture, textureView, texDesc, textureViewDesc, srcTexLayout, destination, std::move(name));
 	}
 
+	void Texture::WriteSlab(const WGPUQueue& queue, std::uint32_t zBegin, std::uint32_t depth, const void* dataPtr)
+	{
+		const std::size_t sliceBytes = static_cast<std::size_t>(m_SrcTexLayout.bytesPerRow) * m_TexDesc.size.height;
+		UpdateRegion(queue, { 0, 0, zBegin }, { m_TexDesc.size.width, m_TexDesc.size.height, depth },
+			{ static_cast<const std::byte*>(dataPtr), sliceBytes * depth });
+	}
+
+	void Texture::Upload(const WGPUQueue& queue, const SlabUploader::Fill& fill, const SlabUploader::Progress& progress, std::size_t slabBytes)
+	{
+		const std::size_t sliceBytes = static_cast<std::size_t>(m_SrcTexLayout.bytesPerRow) * m_TexDesc.size.height;
+		const SlabUploader uploader(sliceBytes, m_TexDesc.size.depthOrArrayLayers, slabBytes);
+
+		uploader.Run(fill, [&](std::uint32_t zBegin, std::uint32_t depth, std::span<const std::byte> src)
+		{
+			WriteSlab(queue, zBegin, depth, src.data());
+		}, progress);
+
+		std::string t = "Uploaded texture: " + m_Name + " in " + std::to_string(uploader.GetSlabCount()) + " slab(s)";
+		LOG_TRACE(t.c_str());
+	}
+
+	void Texture::UploadSlices(const WGPUQueue& queue, std::uint32_t zBegin, std::uint32_t depth, const SlabUploader::Fill& fill, std::size_t slabBytes)
+	{
+		assert(zBegin + depth <= m_TexDesc.size.depthOrArrayLayers && "Slices are outside of the texture");
+
+		const std::size_t sliceBytes = static_cast<std::size_t>(m_SrcTexLayout.bytesPerRow) * m_TexDesc.size.height;
+		const SlabUploader uploader(sliceBytes, depth, slabBytes);
+
+		// Uploader counts slices from 0, texture from zBegin
+		uploader.Run([&](std::uint32_t z, std::uint32_t slabDepth, std::span<std::byte> dst)
+		{
+			fill(zBegin + z, slabDepth, dst);
+		},
+		[&](std::uint32_t z, std::uint32_t slabDepth, std::span<const std::byte> src)
+		{
+			WriteSlab(queue, zBegin + z, slabDepth, src.data());
+		});
+	}
+
 	void Texture::UpdateTexture(const WGPUQueue& queue, const void* dataPtr)
 	{
+		const std::size_t bytes = static_cast<std::size_t>(m_SrcTexLayout.bytesPerRow) * m_TexDesc.size.height * m_TexDesc.size.depthOrArrayLayers;
+		UpdateRegion(queue, { 0, 0, 0 }, m_TexDesc.size, { static_cast<const std::byte*>(dataPtr), bytes });
+
 		std::string t = "Updated texture: " + m_Name;
-		auto [x, y, z] = m_TexDesc.size;
-		wgpuQueueWriteTexture(queue, &m_Destination, dataPtr, (x * y * z * (m_SrcTexLayout.bytesPerRow / x)), &m_SrcTexLayout, &m_TexDesc.size);
-		wgpuTextureViewRelease(m_TexView);
-		m_TexView = wgpuTextureCreateView(m_Tex, &m_ViewDesc);
 		LOG_TRACE(t.c_str());
 	}
 
+	void Texture::UpdateRegion(const WGPUQueue& queue, WGPUOrigin3D origin, WGPUExtent3D extent, std::span<const std::byte> data)
+	{
+		assert(m_SrcTexLayout.bytesPerRow != 0 && "Texture was not created for uploads");
+		assert(origin.x + extent.width <= m_TexDesc.size.width && origin.y + extent.height <= m_TexDesc.size.height
+			&& origin.z + extent.depthOrArrayLayers <= m_TexDesc.size.depthOrArrayLayers && "Region is outside of the texture");
+
+		WGPUImageCopyTexture destination = m_Destination;
+		destination.origin = origin;
+
+		// Data of the region are tightly packed, rows are as wide as the region
+		WGPUTextureDataLayout layout = m_SrcTexLayout;
+		layout.bytesPerRow = GetBytesPerTexel() * extent.width;
+		layout.rowsPerImage = extent.height;
+
+		const std::size_t bytes = static_cast<std::size_t>(layout.bytesPerRow) * extent.height * extent.depthOrArrayLayers;
+		assert(data.size() >= bytes && "Not enough data for the region");
+
+		s_QueueWriter(queue, &destination, data.data(), bytes, &layout, &extent);
+	}
+
+	void Texture::UpdateTexels(const WGPUQueue& queue, std::uint32_t first, std::uint32_t count, const void* dataPtr)
+	{
+		assert(m_TexDesc.dimension == WGPUTextureDimension_1D && "Texel range update is meant for 1D textures");
+		UpdateRegion(queue, { first, 0, 0 }, { count, 1, 1 }, { static_cast<const std::byte*>(dataPtr), static_cast<std::size_t>(count) * GetBytesPerTexel() });
+	}
+
+	void Texture::SetQueueWriter(QueueWriter writer)
+	{
+		s_QueueWriter = writer != nullptr ? writer : wgpuQueueWriteTexture;
+	}
+
 	std::shared_ptr<Texture> Texture::CreateRenderAttachment(uint32_t width, uint32_t height, WGPUTextureUsageFlags flags, std::string&& name)
 	{
 
@@ -147,6 +226,11 @@ namespace med
 		return m_Name;
 	}
 
+	std::uint32_t Texture::GetBytesPerTexel() const
+	{
+		return m_SrcTexLayout.bytesPerRow / m_TexDesc.size.width;
+	}
+
 	WGPUTextureViewDimension Texture::ResolveView(WGPUTextureDimension dim)
 	{
 		// intentionally ignoring others
@@ -1,7 +1,10 @@
 #pragma once
 #include "webgpu/webgpu.h"
 #include "Base/GraphicsContext.h"
+#include "SlabUploader.h"
+#include <cstddef>
 #include <memory>
+#include <span>
 #include <string>
 
 namespace med
@@ -22,19 +25,68 @@ namespace med
 		*/
 		static std::shared_ptr<Texture> CreateFromData(const WGPUDevice& device, const WGPUQueue& queue, const void* dataPtr, WGPUTextureDimension dimension,
 			std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size, WGPUTextureFormat format, WGPUTextureUsageFlags flags, std::uint32_t bytesPerElement, std::string&& name = "Texture");
+
+		/*
+		* Creates texture without data, content is written later (Upload, WriteSlab). Needs CopyDst usage.
+		*/
+		static std::shared_ptr<Texture> Create(const WGPUDevice& device, WGPUTextureDimension dimension, std::tuple<std::uint16_t, std::uint16_t, std::uint16_t> size,
+			WGPUTextureFormat format, WGPUTextureUsageFlags flags, std::uint32_t bytesPerElement, std::string&& name = "Texture");
+
 		/*
 		 * Create texture as render attachment.
 		 * Default flags: RenderAttachment
 		 * TODO: context holding necessary information (width, height), assign them default values
 		 */
 		static std::shared_ptr<Texture> CreateRenderAttachment(uint32_t width, uint32_t height, WGPUTextureUsageFlags flags,  std::string&& name);
+		/*
+		* Function every write of the texture data goes through, wgpuQueueWriteTexture by default.
+		*/
+		using QueueWriter = decltype(&wgpuQueueWriteTexture);
 	public:
+		/*
+		* Rewrites the whole texture, data are tightly packed texels.
+		*/
 		void UpdateTexture(const WGPUQueue& queue, const void* dataPtr);
 
+		/*
+		* Writes the box [origin, origin + extent) of the texture, data are tightly packed texels of the box (x fastest).
+		* Texture and its view stay the same, only the bytes of the box are sent to the queue.
+		*/
+		void UpdateRegion(const WGPUQueue& queue, WGPUOrigin3D origin, WGPUExtent3D extent, std::span<const std::byte> data);
+
+		/*
+		* Writes texels [first, first + count) of a 1D texture (e.g. changed part of a TF), dataPtr points to the first written texel.
+		*/
+		void UpdateTexels(const WGPUQueue& queue, std::uint32_t first, std::uint32_t count, const void* dataPtr);
+
+		/*
+		* Writes slices [zBegin, zBegin + depth), data are tightly packed slices.
+		*/
+		void WriteSlab(const WGPUQueue& queue, std::uint32_t zBegin, std::uint32_t depth, const void* dataPtr);
+
+		/*
+		* Streams the whole texture in z-slabs (see SlabUploader), each write stays bounded by slabBytes.
+		* Slabs are filled on the thread pool, queue is used only from the calling thread.
+		*/
+		void Upload(const WGPUQueue& queue, const SlabUploader::Fill& fill, const SlabUploader::Progress& progress = {},
+			std::size_t slabBytes = SlabUploader::kDefaultSlabBytes);
+
+		/*
+		* Same as Upload for slices [zBegin, zBegin + depth) only (edited part of a volume), fill gets absolute slice indices.
+		*/
+		void UploadSlices(const WGPUQueue& queue, std::uint32_t zBegin, std::uint32_t depth, const SlabUploader::Fill& fill,
+			std::size_t slabBytes = SlabUploader::kDefaultSlabBytes);
+
+		/*
+		* Replaces the queue writer of all textures (e.g. mock queue recording the written bytes), nullptr restores the default.
+		*/
+		static void SetQueueWriter(QueueWriter writer);
+
 	public:
 		WGPUTextureViewDescriptor GetViewDescriptor() const;
 		WGPUTextureView GetTextureView() const;
 		std::string GetName() const;
+		std::uint32_t GetBytesPerTexel() const;
 	private:
 		static WGPUTextureViewDimension ResolveView(WGPUTextureDimension dim);
 	
@@ -0,0 +1,121 @@
+#include "VolumeTexture.h"
+
+#include "Base/Base.h"
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <span>
+
+namespace med
+{
+	WGPUTextureFormat VolumeTexture::ResolveFormat(DensityTexelFormat format)
+	{
+		// R16Unorm would need the norm16 feature, half float is core and filterable
+		switch (format)
+		{
+		case DensityTexelFormat::R8Unorm:
+			return WGPUTextureFormat_R8Unorm;
+		case DensityTexelFormat::R16Float:
+			return WGPUTextureFormat_R16Float;
+		case DensityTexelFormat::R32Float:
+			return WGPUTextureFormat_R32Float;
+		}
+		return WGPUTextureFormat_Undefined;
+	}
+
+	std::shared_ptr<Texture> VolumeTexture::CreateDensity(const WGPUDevice& device, const WGPUQueue& queue, const VolumeFile& file,
+		std::string&& name, WGPUTextureUsageFlags flags)
+	{
+		const DensityTexelFormat format = file.GetDensityTexelFormat();
+
+		auto texture = Texture::Create(device, WGPUTextureDimension_3D, file.GetSize(), ResolveFormat(format), flags,
+			TexelPacking::GetBytesPerTexel(format), std::move(name));
+		texture->Upload(queue, std::bind_front(&VolumeFile::WriteDensityTexels, &file, format));
+
+		return texture;
+	}
+
+	std::shared_ptr<Texture> VolumeTexture::CreateGradient(const WGPUDevice& device, const WGPUQueue& queue, const VolumeFile& file,
+		std::string&& name, WGPUTextureUsageFlags flags)
+	{
+		if (!file.HasGradient())
+		{
+			LOG_WARN("Gradient texture of a file without gradient");
+		}
+
+		auto texture = Texture::Create(device, WGPUTextureDimension_3D, file.GetSize(), WGPUTextureFormat_RGBA8Snorm, flags,
+			TexelPacking::kGradientTexelBytes, std::move(name));
+		texture->Upload(queue, std::bind_front(&VolumeFile::WriteGradientTexels, &file));
+
+		return texture;
+	}
+
+	std::shared_ptr<Texture> VolumeTexture::CreateOccupancy(const WGPUDevice& device, const WGPUQueue& queue, const OccupancyMap& occupancy,
+		std::string&& name)
+	{
+		assert(occupancy.GetOccupancy().size() == occupancy.GetGrid().GetBrickCount() && "Occupancy does not match the grid");
+
+		return Texture::CreateFromData(device, queue, occupancy.GetOccupancy().data(), WGPUTextureDimension_3D, occupancy.GetGrid().GetGridSize(), WGPUTextureFormat_R8Unorm,
+			WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, sizeof(std::uint8_t), std::move(name));
+	}
+
+	std::shared_ptr<Texture> VolumeTexture::CreateMask(const WGPUDevice& device, const WGPUQueue& queue, const MaskVolume& mask,
+		std::uint32_t firstRoi, std::string&& name)
+	{
+		const std::uint32_t roiCount = firstRoi < mask.GetRoiCount() ? mask.GetRoiCount() - firstRoi : 0;
+		const std::uint32_t bytesPerTexel = roiCount <= 8 ? 1 : 4;
+		if (roiCount > 32)
+		{
+			LOG_WARN("Mask has more ROIs than the label texel can hold, the rest is left out");
+		}
+
+		auto texture = Texture::Create(device, WGPUTextureDimension_3D, mask.GetSize(), bytesPerTexel == 1 ? WGPUTextureFormat_R8Uint : WGPUTextureFormat_R32Uint,
+			WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst, bytesPerTexel, std::move(name));
+		texture->Upload(queue, std::bind_front(&MaskVolume::WriteLabelTexels, &mask, firstRoi, bytesPerTexel));
+
+		return texture;
+	}
+
+	void VolumeTexture::UpdateDensity(const WGPUQueue& queue, Texture& texture, const VolumeFile& file, std::uint32_t zBegin, std::uint32_t depth)
+	{
+		const DensityTexelFormat format = file.GetDensityTexelFormat();
+		assert(texture.GetBytesPerTexel() == TexelPacking::GetBytesPerTexel(format) && "Texture does not match the density format");
+
+		texture.UploadSlices(queue, zBegin, depth, std::bind_front(&VolumeFile::WriteDensityTexels, &file, format));
+	}
+
+	void VolumeTexture::UpdateOccupancy(const WGPUQueue& queue, Texture& texture, const OccupancyMap& occupancy)
+	{
+		const auto [first, last] = occupancy.GetDirtyBricks();
+		if (first > last)
+		{
+			return;
+		}
+
+		const auto [xSize, ySize, zSize] = occupancy.GetGrid().GetGridSize();
+		const std::span<const std::byte> bytes = std::as_bytes(std::span(occupancy.GetOccupancy()));
+		const std::size_t sliceSize = static_cast<std::size_t>(xSize) * ySize;
+
+		const auto zFirst = static_cast<std::uint32_t>(first / sliceSize);
+		const auto zLast = static_cast<std::uint32_t>(last / sliceSize);
+		assert(zLast < zSize && "Dirty bricks are outside of the grid");
+		if (zFirst == zLast)
+		{
+			const auto yFirst = static_cast<std::uint32_t>(first % sliceSize / xSize);
+			const auto yLast = static_cast<std::uint32_t>(last % sliceSize / xSize);
+			texture.UpdateRegion(queue, { 0, yFirst, zFirst }, { xSize, yLast - yFirst + 1, 1 },
+				bytes.subspan(zFirst * sliceSize + static_cast<std::size_t>(yFirst) * xSize, static_cast<std::size_t>(yLast - yFirst + 1) * xSize));
+			return;
+		}
+
+		texture.UpdateRegion(queue, { 0, 0, zFirst }, { xSize, ySize, zLast - zFirst + 1 },
+			bytes.subspan(zFirst * sliceSize, (zLast - zFirst + 1) * sliceSize));
+	}
+
+	void VolumeTexture::UpdateMask(const WGPUQueue& queue, Texture& texture, const MaskVolume& mask, std::uint32_t firstRoi,
+		std::uint32_t zBegin, std::uint32_t depth)
+	{
+		texture.UploadSlices(queue, zBegin, depth, std::bind_front(&MaskVolume::WriteLabelTexels, &mask, firstRoi, texture.GetBytesPerTexel()));
+	}
+}
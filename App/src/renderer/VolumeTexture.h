@@ -0,0 +1,67 @@
+#pragma once
+#include "webgpu/webgpu.h"
+#include "Texture.h"
+#include "../file/VolumeFile.h"
+#include "../file/OccupancyMap.h"
+#include "../file/MaskVolume.h"
+
+#include <memory>
+#include <string>
+
+namespace med
+{
+	/**
+	 * @brief Creates textures sampled by the ray marchers, reduced precision density and gradient are separate single purpose textures,
+	 * brick occupancy drives empty space skipping.
+	 * Density format follows VolumeFile::GetDensityTexelFormat (r channel), gradient is RGBA8Snorm
+	 * (see TexelPacking::PackGradient, decoded by DecodeGradient in the shaders).
+	 */
+	class VolumeTexture
+	{
+	public:
+		static WGPUTextureFormat ResolveFormat(DensityTexelFormat format);
+
+		/*
+		* Density only 3D texture, streamed in slabs. File has to outlive the call only.
+		*/
+		static std::shared_ptr<Texture> CreateDensity(const WGPUDevice& device, const WGPUQueue& queue, const VolumeFile& file,
+			std::string&& name = "Density", WGPUTextureUsageFlags flags = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst);
+
+		/*
+		* Packed gradient 3D texture, zeros if the file has no gradient.
+		*/
+		static std::shared_ptr<Texture> CreateGradient(const WGPUDevice& device, const WGPUQueue& queue, const VolumeFile& file,
+			std::string&& name = "Gradient", WGPUTextureUsageFlags flags = WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst);
+
+		/*
+		* Brick occupancy 3D texture (R8Unorm, one texel per brick, see OccupancyMap).
+		* Updated occupancy is uploaded with UpdateOccupancy.
+		*/
+		static std::shared_ptr<Texture> CreateOccupancy(const WGPUDevice& device, const WGPUQueue& queue, const OccupancyMap& occupancy,
+			std::string&& name = "Occupancy");
+
+		/*
+		* ROI label 3D texture, bit r of a texel is ROI firstRoi + r (see MaskVolume::WriteLabelTexels), read with textureLoad.
+		* R8Uint for up to 8 ROIs, R32Uint for up to 32, more ROIs need another texture with a different firstRoi.
+		*/
+		static std::shared_ptr<Texture> CreateMask(const WGPUDevice& device, const WGPUQueue& queue, const MaskVolume& mask,
+			std::uint32_t firstRoi = 0, std::string&& name = "Mask");
+
+		/*
+		* Re-uploads density slices [zBegin, zBegin + depth) of a texture made by CreateDensity after the data changed (e.g. dose update).
+		*/
+		static void UpdateDensity(const WGPUQueue& queue, Texture& texture, const VolumeFile& file, std::uint32_t zBegin, std::uint32_t depth);
+
+		/*
+		* Uploads the bricks changed by the last OccupancyMap::Classify/Update, nothing if none has changed.
+		* Changed bricks within one grid slice are written as whole rows, otherwise whole slices are written.
+		*/
+		static void UpdateOccupancy(const WGPUQueue& queue, Texture& texture, const OccupancyMap& occupancy);
+
+		/*
+		* Re-uploads label slices [zBegin, zBegin + depth) of a texture made by CreateMask after the mask was edited (e.g. painting).
+		*/
+		static void UpdateMask(const WGPUQueue& queue, Texture& texture, const MaskVolume& mask, std::uint32_t firstRoi,
+			std::uint32_t zBegin, std::uint32_t depth);
+	};
+}
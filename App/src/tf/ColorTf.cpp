@@ -8,6 +8,7 @@
 #include "../file/FileSystem.h"
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <sstream>
@@ -29,7 +30,8 @@ namespace med
 		auto color1 = glm::vec4(0.0, 0.0, 0.0, 1.0);
 		auto color2 = glm::vec4(1.0, 1.0, 1.0, 1.0);
 
-		m_Colors = LinearInterpolation::Generate<glm::vec4, int>(0, m_TextureResolution - 1, color1, color2, 1);
+		m_Colors.resize(m_TextureResolution);
+		LinearInterpolation::Fill<glm::vec4>(m_Colors, color1, color2);
 
 		m_ControlCol = {};
 		m_ControlCol.push_back(color1);
@@ -38,7 +40,7 @@ namespace med
 		m_ControlPoints = {};
 		m_ControlPoints.emplace_back(0.0, 0.5);
 		m_ControlPoints.emplace_back(m_TextureResolution - 1.0, 0.5);
-		m_ShouldUpdate = true;
+		MarkDirty(0, m_TextureResolution - 1);
 	}
 
 		
@@ -173,7 +175,10 @@ namespace med
 		if (m_ShouldUpdate)
 		{
 			assert(p_Texture != nullptr && "Texture is not initialized");
-			p_Texture->UpdateTexture(base::GraphicsContext::GetQueue(), m_Colors.data());
+			// Only the texels changed since the last upload are written
+			const auto [first, last] = m_DirtyTexels;
+			p_Texture->UpdateTexels(base::GraphicsContext::GetQueue(), static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last - first + 1),
+				m_Colors.data() + first);
 			m_ShouldUpdate = false;
 		}
 	}
@@ -302,12 +307,9 @@ namespace med
 		m_Colors.resize(m_TextureResolution);
 		m_DataRange = dataRange;
 
-		for (int i = 0; i < m_ControlPoints.size(); ++i)
-		{
-			UpdateYAxis(i);
-		}
+		UpdateAllIntervals();
 
-		m_ShouldUpdate = true;
+		MarkDirty(0, m_TextureResolution - 1);
 		LOG_INFO("Color TF loaded");
 	}
 
@@ -322,13 +324,10 @@ namespace med
 				int x0 = static_cast<int>(cx1);
 				int x1 = static_cast<int>(cx2);
 
-				std::vector<glm::vec4> result = LinearInterpolation::Generate<glm::vec4, int>(x0, x1, cy1, cy2, 1);
-				assert(result.size() - 1 == std::abs(x1 - x0) && "Size of generated vector does not match");
+				assert(x0 <= x1 && "Control points are not ordered");
 
-				for (size_t i = 0; i <= std::abs(x1 - x0); ++i)
-				{
-					m_Colors[i + x0] = result[i];
-				}
+				LinearInterpolation::Fill<glm::vec4>(std::span(m_Colors).subspan(x0, x1 - x0 + 1), cy1, cy2);
+				MarkDirty(x0, x1);
 			};
 
 		// Update control interval between control point below and current
@@ -344,11 +343,73 @@ namespace med
 			auto successorIndex = static_cast<int>(m_ControlPoints[cpId + 1].x);
 			updateIntervalValues(m_ControlPoints[cpId].x, m_ControlPoints[cpId + 1].x, m_ControlCol[cpId], m_Colors[successorIndex]);
 		}
-		m_ShouldUpdate = true;
+	}
+
+	ColorPreset ColorTF::GetPreset() const
+	{
+		return { GetDataRange(), m_ControlPoints, m_ControlCol, m_Colors };
+	}
+
+	void ColorTF::ApplyPreset(const ColorPreset& preset)
+	{
+		if (!LinearInterpolation::AreControlPointsValid(preset.ControlPoints, preset.Lut.size()) || preset.ControlColors.size() != preset.ControlPoints.size())
+		{
+			LOG_ERROR("Invalid color preset");
+			return;
+		}
+
+		const int resolution = static_cast<int>(preset.Lut.size());
+
+		if (resolution == m_TextureResolution)
+		{
+			// Stored texels are exactly what the control points rasterize to
+			m_ControlPoints = preset.ControlPoints;
+			std::copy(preset.Lut.begin(), preset.Lut.end(), m_Colors.begin());
+		}
+		else
+		{
+			auto cps = ResampleCPVector(preset.ControlPoints, resolution);
+			if (!LinearInterpolation::AreControlPointsValid(cps, m_Colors.size()))
+			{
+				LOG_ERROR("Color preset does not fit this TF");
+				return;
+			}
+			m_ControlPoints = std::move(cps);
+		}
+
+		m_ControlCol = preset.ControlColors;
+		if (resolution != m_TextureResolution)
+		{
+			UpdateAllIntervals();
+		}
+
+		m_ClickedCpId = -1;
+		MarkDirty(0, m_TextureResolution - 1);
+	}
+
+	void ColorTF::UpdateAllIntervals()
+	{
+		for (size_t i = 0; i + 1 < m_ControlPoints.size(); ++i)
+		{
+			const auto x0 = static_cast<size_t>(m_ControlPoints[i].x);
+			const auto x1 = static_cast<size_t>(m_ControlPoints[i + 1].x);
+			if (x0 > x1 || x1 >= m_Colors.size() || i + 1 >= m_ControlCol.size())
+			{
+				assert(false && "Control points are not ordered or out of bounds");
+				continue;
+			}
+
+			LinearInterpolation::Fill<glm::vec4>(std::span(m_Colors).subspan(x0, x1 - x0 + 1), m_ControlCol[i], m_ControlCol[i + 1]);
+		}
 	}
 
 	std::string ColorTF::GetType() const
 	{
 		return "color";
 	}
+
+	const std::vector<glm::vec4>& ColorTF::GetColors() const
+	{
+		return m_Colors;
+	}
 } // namespace med
\ No newline at end of file
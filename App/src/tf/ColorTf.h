@@ -1,6 +1,7 @@
 #pragma once
 
 #include "TransferFunction.h"
+#include "TfPreset.h"
 #include "../renderer/Texture.h"
 
 #include <vector>
@@ -24,8 +25,28 @@ namespace med
 		bool Save(const std::string& name) override;
 		void Load(const std::string& name, TFLoadOption option = TFLoadOption::NONE) override;
 		void ResetTF() override;
+
+		/*
+		* @brief Color texels as they are uploaded to the GPU, sampled over [0, 1].
+		*/
+		const std::vector<glm::vec4>& GetColors() const;
+
+		/*
+		* @brief Current state with the rasterized texels (see TFPresetLibrary).
+		*/
+		ColorPreset GetPreset() const;
+
+		/*
+		* @brief Restores the state, stored texels are copied if they match this TF, otherwise the TF is rebuilt from the control points.
+		*/
+		void ApplyPreset(const ColorPreset& preset);
 	private:
 		void UpdateYAxis(int cpId) override;
+
+		/*
+		* @brief Rasterizes every interval between the control points once (Load)
+		*/
+		void UpdateAllIntervals();
 	private:
 		int m_ClickedCpId = -1;
 		std::vector<glm::vec4> m_Colors{};
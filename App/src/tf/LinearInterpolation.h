@@ -1,5 +1,9 @@
-#include <vector>
+#pragma once
+
+#include <span>
 #include <concepts>
+#include <cmath>
+#include <cstddef>
 #include "glm/glm.hpp"
 
 namespace med
@@ -7,30 +11,56 @@ namespace med
 	class LinearInterpolation
 	{
 	public:
-		template<typename T, typename U>
-		static std::vector<T> Generate(U x0, U x1, T fx0, T fx1, U step)
+		/*
+		* @brief Writes the linear ramp from fx0 (first texel) to fx1 (last texel) directly into dst, nothing is allocated.
+		* Every texel is computed from its index only, so the loop has no carried dependency and is vectorized by the compiler.
+		* Colors keep the alpha at 1.
+		*/
+		template<typename T>
+		static void Fill(std::span<T> dst, T fx0, T fx1)
 		{
-			static_assert(std::is_arithmetic<U>::value);
-			std::vector<T> result{};
+			if (dst.empty())
+			{
+				return;
+			}
 
-			auto slope = (fx1 - fx0) * (1.0f / static_cast<float>(x1 - x0));
+			const int last = static_cast<int>(dst.size()) - 1;
+			const auto slope = last > 0 ? (fx1 - fx0) * (1.0f / static_cast<float>(last)) : T(0.0f);
 
-			for (auto i = x0; i < x1 + 1; i += step)
+			for (int i = 0; i <= last; ++i)
 			{
 				if constexpr (std::is_same<T, glm::vec4>::value)
 				{
-					float r = fx0.r + slope.r * (i - x0);
-					float g = fx0.g + slope.g * (i - x0);
-					float b = fx0.b + slope.b * (i - x0);
-					result.emplace_back(r, g, b, 1.0f);
+					dst[i] = glm::vec4(glm::vec3(fx0) + glm::vec3(slope) * static_cast<float>(i), 1.0f);
 				}
 				else
 				{
-					result.push_back(fx0 + slope * (i - x0));
+					dst[i] = fx0 + slope * static_cast<float>(i);
 				}
 			}
+		}
+
+		/*
+		* @brief True if there are at least two control points, their coordinates are finite and x is sorted within [0, resolution - 1],
+		* i.e. every interval between the points can be filled into the LUT of the resolution.
+		*/
+		static bool AreControlPointsValid(std::span<const glm::dvec2> cps, std::size_t resolution)
+		{
+			if (cps.size() < 2 || resolution == 0)
+			{
+				return false;
+			}
 
-			return result;
+			const double maxX = static_cast<double>(resolution - 1);
+			for (std::size_t i = 0; i < cps.size(); ++i)
+			{
+				// NaN fails every comparison below
+				if (!std::isfinite(cps[i].y) || !(cps[i].x >= 0.0 && cps[i].x <= maxX) || (i > 0 && !(cps[i - 1].x <= cps[i].x)))
+				{
+					return false;
+				}
+			}
+			return true;
 		}
 	};
-}
\ No newline at end of file
+}
@@ -6,7 +6,9 @@
 #include "implot/implot.h"
 #include "implot_internal.h"
 #include "../file/FileSystem.h"
+#include "../file/HistogramEngine.h"
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <sstream>
@@ -32,16 +34,14 @@ namespace med
 		m_ControlPoints.emplace_back(0.0, 0.0);
 		m_ControlPoints.emplace_back(m_TextureResolution - 1.0, 1.0);
 
-		std::vector<float> result = LinearInterpolation::Generate<float>(0, m_TextureResolution - 1, 0.0f, 1.0f, 1);
-		assert(result.size() == m_TextureResolution && "Size of generated TF does not match");
+		LinearInterpolation::Fill<float>(m_YPoints, 0.0f, 1.0f);
 
 		// Fill for plotting
 		for (size_t i = 0; i < m_TextureResolution; ++i)
 		{
 			m_XPoints[i] = i;
-			m_YPoints[i] = result[i];
 		}
-		m_ShouldUpdate = true;
+		MarkDirty(0, m_TextureResolution - 1);
 	}
 
 
@@ -136,37 +136,49 @@ namespace med
 		if (m_ShouldUpdate)
 		{
 			assert(p_Texture != nullptr && "Texture is not initialized");
-			p_Texture->UpdateTexture(base::GraphicsContext::GetQueue(), m_YPoints.data());
+			// Only the texels changed since the last upload are written
+			const auto [first, last] = m_DirtyTexels;
+			p_Texture->UpdateTexels(base::GraphicsContext::GetQueue(), static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(last - first + 1),
+				m_YPoints.data() + first);
 			m_ShouldUpdate = false;
 		}
 	}
 
+	const std::vector<float>& OpacityTF::GetOpacities() const
+	{
+		return m_YPoints;
+	}
+
 	void OpacityTF::ActivateHistogram(const VolumeFile& file)
 	{
 		// this function will create histogram of data, (divide either by max value or 2^used bits) then multiplied by desired resolution
-		m_Histogram.resize(m_TextureResolution, 0.0f);
-		const auto& data = file.GetVecReference();
+		m_Histogram.assign(m_TextureResolution, 0.0f);
 		auto [xSize, ySize, slices] = file.GetSize();
-		const size_t size = xSize * ySize * slices;
+		const size_t size = static_cast<size_t>(xSize) * ySize * slices;
 		float maxVal = 0.0f;
-		// If data are not normalized, normalize and convert to texture range, this is pre-computed factor
-		const float factor = m_TextureResolution / file.GetDataRange();
-		
-		for (std::uint32_t i = 0; i < size; ++i)
+
+		// Known histogram over the same range (e.g. from cache) is only merged into the texture resolution
+		const auto& known = file.GetDensityHistogram();
+		if (known.Range == file.GetDataRange() && !known.Counts.empty() && known.Counts.size() % m_TextureResolution == 0)
 		{
-			// glm::vec4().a -> density (rgb are reserved for gradient)
-			int value = 0;
-			if (file.IsNormalized())
+			const size_t binsPerTexel = known.Counts.size() / m_TextureResolution;
+			for (size_t bin = 0; bin < known.Counts.size(); ++bin)
 			{
-				// Sometimes the data may be capped, divided by value that is less than the max value in the data, this would go out of bounds
-				value = std::min(static_cast<int>(data[i].a * m_TextureResolution), m_TextureResolution - 1);
+				m_Histogram[bin / binsPerTexel] += static_cast<float>(known.Counts[bin]);
 			}
-			else
+		}
+		else
+		{
+			// Normalized file maps [0, 1] to the texture range, otherwise the data range is used (pre-computed factor)
+			// Sometimes the data may be capped, divided by value that is less than the max value in the data, these fall into the last bin
+			HistogramBinning binning = HistogramBinning::FromRange(m_TextureResolution, static_cast<double>(file.GetDataRange()));
+			if (file.IsNormalized())
 			{
-				value = std::min(static_cast<int>(data[i].a * factor), m_TextureResolution - 1);
+				binning.Scale = static_cast<double>(file.GetDensityScale()) * m_TextureResolution;
 			}
-			
-			++m_Histogram[value];
+
+			const auto bins = HistogramEngine::Compute(file.GetDensityBuffer(), binning);
+			std::transform(bins.begin(), bins.end(), m_Histogram.begin(), [](std::uint32_t count) { return static_cast<float>(count); });
 		}
 		maxVal = std::log10(size);
 		for (float& i : m_Histogram)
@@ -294,6 +306,12 @@ namespace med
 			cps = RemapCPVector(cps, dataRange, resolution);
 		}
 
+		if (resolution <= 0 || !LinearInterpolation::AreControlPointsValid(cps, static_cast<size_t>(resolution)))
+		{
+			LOG_ERROR("Control points are not sorted or out of the TF range, TF was not loaded");
+			return;
+		}
+
 		// Update the state
 		ResolveResolution(resolution);
 		// Allocate or destroy mem. if needed
@@ -304,16 +322,13 @@ namespace med
 		m_ControlPoints = std::move(cps);
 		
 		// Re-calculate the values betweeb CPs
-		for (int i = 0; i < m_ControlPoints.size(); ++i)
-		{
-			UpdateYAxis(i);
-		}
+		UpdateAllIntervals();
 
-		m_ShouldUpdate = true;
+		MarkDirty(0, m_TextureResolution - 1);
 		LOG_INFO("Opacity TF loaded");
 	}
 
-	void OpacityTF::CalibrateOnMask(std::shared_ptr<const VolumeFile> mask, std::shared_ptr<const VolumeFile> file, std::array<int, 4> activeContours)
+	void OpacityTF::CalibrateOnMask(std::shared_ptr<const MaskVolume> mask, std::shared_ptr<const VolumeFile> file, const std::vector<std::uint32_t>& rois)
 	{
 		// Checking
 		if (file == nullptr || mask == nullptr)
@@ -322,17 +337,53 @@ namespace med
 			return;
 		}
 
-		auto [x, y, z] = mask->GetSize();
+		// Selected contours are encoded, calibration then visits only the voxels inside of them
+		std::vector<SparseMask> masks{};
+		for (auto roi : rois)
+		{
+			if (roi < mask->GetRoiCount())
+			{
+				masks.push_back(SparseMask::FromMask(*mask, roi));
+			}
+			else
+			{
+				LOG_WARN("TF calibration: ROI out of bounds, skipping");
+			}
+		}
+
+		CalibrateOnMask(masks, file);
+	}
+
+	void OpacityTF::CalibrateOnMask(std::span<const SparseMask> masks, std::shared_ptr<const VolumeFile> file)
+	{
+		// Checking
+		if (file == nullptr)
+		{
+			LOG_ERROR("TF Calibration: NULLPTR, TF won't be calibrated");
+			return;
+		}
+
+		// Check whether user flagged at least one contour
+		if (masks.empty())
+		{
+			LOG_ERROR("No contour has been selected for calibration, TF won't be calibrated!");
+			return;
+		}
+
 		auto [xx, yy, zz] = file->GetSize();
 
 		// Matching size check
-		if (x != xx || y != yy || z != zz)
+		for (const auto& mask : masks)
 		{
-			LOG_ERROR("TF calibration, mask and data sizes do not match, TF won't be calibrated");
-			return;
+			auto [x, y, z] = mask.GetSize();
+			if (x != xx || y != yy || z != zz)
+			{
+				LOG_ERROR("TF calibration, mask and data sizes do not match, TF won't be calibrated");
+				return;
+			}
 		}
 
-		size_t size = x * y * z;
+		size_t size = static_cast<size_t>(xx) * yy * zz;
 
 		// Empty file check
 		if (size == 0)
@@ -344,16 +395,15 @@ namespace med
 
 		size_t maxValue = file->GetMaxNumber();
 
-		const auto& maskData = mask->GetVecReference();
-		const auto& fileData = file->GetVecReference();
+		const auto& fileData = file->GetDensityBuffer();
 
-		assert(maskData.size() == fileData.size() && "Underlying data are not the same size");
+		assert(size == fileData.GetVoxelCount() && "Underlying data are not the same size");
 
 		// Max value check
 		if (maxValue == 0)
 		{
 			LOG_WARN("Max value is zero, looking for max value.");
-			maxValue = file->GetMaxNumber(fileData, 3); // alpha --> rgb may contain precomputed gradient
+			maxValue = static_cast<size_t>(fileData.GetMaxValue());
 			if (maxValue == 0)
 			{
 				LOG_ERROR("After check: max value is 0, TF won't be calibrated.");
@@ -361,36 +411,12 @@ namespace med
 			}
 		}
 
-		std::vector<int> cIndices{};
-		for (int i = 0; i < activeContours.size(); ++i)
-		{
-			if (activeContours[i] == 1)
-			{
-				cIndices.push_back(i);
-			}
-		}
-
-		// Check whether user flagged at least one contour
-		if (cIndices.size() == 0)
-		{
-			LOG_ERROR("No contour has been selected for calibration, TF won't be calibrated!"); \
-			return;
-		}
-
-		// calculate histogram inside the contour
+		// calculate histogram inside the contour, one bin per raw (not normalized) value
+		// Only voxels inside of the contours are visited, voxel inside of more contours counts once per contour
 		std::vector<double> bin(maxValue, 0.0);
-
-		for (size_t i = 0; i < size; ++i)
+		for (const auto& contourBins : HistogramEngine::ComputeMasked(fileData, masks, { maxValue, 1.0 }))
 		{
-			for (auto contourIndex : cIndices)
-			{
-				if (maskData[i][contourIndex] != 0)
-				{
-					// Active contour
-					int value = fileData[i].a;
-					++bin[value];
-				}
-			}
+			std::transform(contourBins.begin(), contourBins.end(), bin.begin(), bin.begin(), [](std::uint32_t count, double sum) { return sum + count; });
 		}
 
 		int maxElem = *std::max_element(bin.begin(), bin.end());
@@ -477,13 +503,9 @@ namespace med
 
 		m_ControlPoints = std::move(cps);
 
+		UpdateAllIntervals();
 
-		for (int i = 0; i < m_ControlPoints.size(); ++i)
-		{
-			UpdateYAxis(i);
-		}
-
-		m_ShouldUpdate = true;
+		MarkDirty(0, m_TextureResolution - 1);
 	}
 
 	void OpacityTF::UpdateYAxis(int cpId)
@@ -495,13 +517,10 @@ namespace med
 				int x0 = static_cast<int>(cx1);
 				int x1 = static_cast<int>(cx2);
 
-				std::vector<float> result = LinearInterpolation::Generate<float, int>(x0, x1, cy1, cy2, 1);
-				assert(result.size() - 1 == std::abs(x1 - x0) && "Size of generated vector does not match");
+				assert(x0 <= x1 && "Control points are not ordered");
 
-				for (size_t i = 0; i <= std::abs(x1 - x0); ++i)
-				{
-					m_YPoints[i + x0] = result[i];
-				}
+				LinearInterpolation::Fill<float>(std::span(m_YPoints).subspan(x0, x1 - x0 + 1), cy1, cy2);
+				MarkDirty(x0, x1);
 			};
 
 		// Update control interval between control point below and current
@@ -519,7 +538,65 @@ namespace med
 			updateIntervalValues(m_ControlPoints[cpId].x, m_ControlPoints[cpId + 1].x,
 				static_cast<float>(m_ControlPoints[cpId].y), m_YPoints[successorIndex]);
 		}
-		m_ShouldUpdate = true;
+	}
+
+	OpacityPreset OpacityTF::GetPreset() const
+	{
+		return { GetDataRange(), m_ControlPoints, m_YPoints };
+	}
+
+	void OpacityTF::ApplyPreset(const OpacityPreset& preset, TFLoadOption option)
+	{
+		if (!LinearInterpolation::AreControlPointsValid(preset.ControlPoints, preset.Lut.size()))
+		{
+			LOG_ERROR("Invalid opacity preset");
+			return;
+		}
+
+		const int resolution = static_cast<int>(preset.Lut.size());
+		const bool rescale = option == TFLoadOption::RESCALE_TO_NEW_RANGE && GetDataRange() != 0 && preset.DataRange != GetDataRange();
+
+		if (resolution == m_TextureResolution && !rescale)
+		{
+			// Stored texels are exactly what the control points rasterize to
+			m_ControlPoints = preset.ControlPoints;
+			std::copy(preset.Lut.begin(), preset.Lut.end(), m_YPoints.begin());
+		}
+		else
+		{
+			auto cps = rescale ? RemapCPVector(preset.ControlPoints, preset.DataRange, resolution) : preset.ControlPoints;
+			cps = ResampleCPVector(std::move(cps), resolution);
+			if (!LinearInterpolation::AreControlPointsValid(cps, m_YPoints.size()))
+			{
+				LOG_ERROR("Opacity preset does not fit this TF");
+				return;
+			}
+			m_ControlPoints = std::move(cps);
+			UpdateAllIntervals();
+		}
+
+		MarkDirty(0, m_TextureResolution - 1);
+	}
+
+	void OpacityTF::UpdateAllIntervals()
+	{
+		for (size_t i = 0; i + 1 < m_ControlPoints.size(); ++i)
+		{
+			const auto x0 = static_cast<size_t>(m_ControlPoints[i].x);
+			const auto x1 = static_cast<size_t>(m_ControlPoints[i + 1].x);
+			if (x0 > x1 || x1 >= m_YPoints.size())
+			{
+				assert(false && "Control points are not ordered or out of bounds");
+				continue;
+			}
+
+			LinearInterpolation::Fill<float>(std::span(m_YPoints).subspan(x0, x1 - x0 + 1),
+				static_cast<float>(m_ControlPoints[i].y), static_cast<float>(m_ControlPoints[i + 1].y));
+		}
+		if (!m_ControlPoints.empty())
+		{
+			MarkDirty(static_cast<size_t>(m_ControlPoints.front().x), std::min(static_cast<size_t>(m_ControlPoints.back().x), m_YPoints.size() - 1));
+		}
 	}
 
 	std::string OpacityTF::GetType() const
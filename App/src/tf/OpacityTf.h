@@ -1,13 +1,18 @@
 #pragma once
 
 #include "TransferFunction.h"
+#include "TfPreset.h"
 #include "../renderer/Texture.h"
 #include "../file/VolumeFile.h"
+#include "../file/MaskVolume.h"
+#include "../file/SparseMask.h"
 
 #include <glm/glm.hpp>
 #include <vector>
 #include <memory>
+#include <span>
 #include <string>
+#include <utility>
 
 namespace med
 {
@@ -51,15 +56,40 @@ namespace med
 		* @brief Calibrates transfer function based on the provided mask. The mask is usually a filled contour.
 		* @param mask: The mask which determines the areas where calibration is performed
 		* @param data: File used to generate the histogram inside the areas
-		* @param activeContours: As mask may have up to 4 contours, this param tells us which should be taken into account
+		* @param rois: ROIs of the mask that should be taken into account, voxel inside of more ROIs is counted once per ROI
 		*/
-		void CalibrateOnMask(std::shared_ptr<const VolumeFile> mask, std::shared_ptr<const VolumeFile> file, std::array<int, 4> activeContours);
+		void CalibrateOnMask(std::shared_ptr<const MaskVolume> mask, std::shared_ptr<const VolumeFile> file, const std::vector<std::uint32_t>& rois);
+
+		/*
+		* @brief Same as above for already encoded contours, histogram is built from the voxels inside of the masks only.
+		*/
+		void CalibrateOnMask(std::span<const SparseMask> masks, std::shared_ptr<const VolumeFile> file);
+
+		/*
+		* @brief Opacity texels as they are uploaded to the GPU, sampled over [0, 1].
+		*/
+		const std::vector<float>& GetOpacities() const;
+
+		/*
+		* @brief Current state with the rasterized texels (see TFPresetLibrary).
+		*/
+		OpacityPreset GetPreset() const;
+
+		/*
+		* @brief Restores the state, stored texels are copied if they match this TF, otherwise the TF is rebuilt from the control points.
+		*/
+		void ApplyPreset(const OpacityPreset& preset, TFLoadOption option = TFLoadOption::NONE);
 	private:
 	/*
 	* @brief Recalculate the interval between control points
 	*/
 	void UpdateYAxis(int cpId) override;
 
+	/*
+	* @brief Rasterizes every interval between the control points once (Load, calibration)
+	*/
+	void UpdateAllIntervals();
+
 	private:
 		std::vector<float> m_XPoints{};
 		std::vector<float> m_YPoints{};
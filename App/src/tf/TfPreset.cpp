@@ -0,0 +1,299 @@
+#include "TfPreset.h"
+#include "LinearInterpolation.h"
+#include "Base/Base.h"
+#include "../file/BinaryStream.h"
+#include "../file/MappedFile.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+
+namespace med
+{
+	namespace
+	{
+		constexpr std::array<char, 4> kMagic = { 'T', 'F', 'P', 'L' };
+		// Written in native order, file created on machine with other endianness is rejected
+		constexpr std::uint32_t kByteOrder = 0x01020304;
+
+		// Parts stored within a preset
+		constexpr std::uint32_t kOpacityPart = 1 << 0;
+		constexpr std::uint32_t kColorPart = 1 << 1;
+		constexpr std::uint32_t kTf2DPart = 1 << 2;
+
+		static_assert(sizeof(glm::dvec2) == 2 * sizeof(double) && sizeof(glm::vec4) == 4 * sizeof(float), "Vectors are expected to be tightly packed");
+
+		/*
+		* Widget as it is stored, independent of the layout of TFWidget2D.
+		*/
+		struct StoredWidget
+		{
+			std::uint32_t Shape = 0;
+			float Center[2]{};
+			float Extent[2]{};
+			float Color[3]{};
+			float Opacity = 0.0f;
+		};
+
+		template<typename T>
+		void WriteVector(BinaryWriter& writer, const std::vector<T>& values)
+		{
+			writer.Write(static_cast<std::uint64_t>(values.size()));
+			writer.WriteSpan(std::span<const T>(values));
+		}
+
+		template<typename T>
+		std::vector<T> ReadVector(BinaryReader& reader)
+		{
+			return reader.ReadVector<T>(reader.Read<std::uint64_t>());
+		}
+
+		void WriteOpacity(BinaryWriter& writer, const OpacityPreset& preset)
+		{
+			writer.Write(static_cast<std::int32_t>(preset.DataRange));
+			WriteVector(writer, preset.ControlPoints);
+			WriteVector(writer, preset.Lut);
+		}
+
+		OpacityPreset ReadOpacity(BinaryReader& reader)
+		{
+			OpacityPreset preset;
+			preset.DataRange = reader.Read<std::int32_t>();
+			preset.ControlPoints = ReadVector<glm::dvec2>(reader);
+			preset.Lut = ReadVector<float>(reader);
+			return preset;
+		}
+
+		void WriteColor(BinaryWriter& writer, const ColorPreset& preset)
+		{
+			writer.Write(static_cast<std::int32_t>(preset.DataRange));
+			WriteVector(writer, preset.ControlPoints);
+			WriteVector(writer, preset.ControlColors);
+			WriteVector(writer, preset.Lut);
+		}
+
+		ColorPreset ReadColor(BinaryReader& reader)
+		{
+			ColorPreset preset;
+			preset.DataRange = reader.Read<std::int32_t>();
+			preset.ControlPoints = ReadVector<glm::dvec2>(reader);
+			preset.ControlColors = ReadVector<glm::vec4>(reader);
+			preset.Lut = ReadVector<glm::vec4>(reader);
+			return preset;
+		}
+
+		void WriteTf2D(BinaryWriter& writer, const TF2DPreset& preset)
+		{
+			std::vector<StoredWidget> widgets(preset.Widgets.size());
+			std::ranges::transform(preset.Widgets, widgets.begin(), [](const TFWidget2D& w)
+			{
+				return StoredWidget{ static_cast<std::uint32_t>(w.Shape), { w.Center.x, w.Center.y }, { w.Extent.x, w.Extent.y },
+					{ w.Color.r, w.Color.g, w.Color.b }, w.Opacity };
+			});
+
+			writer.Write(static_cast<std::int32_t>(preset.DensityResolution));
+			writer.Write(static_cast<std::int32_t>(preset.GradientResolution));
+			WriteVector(writer, widgets);
+			WriteVector(writer, preset.Lut);
+		}
+
+		TF2DPreset ReadTf2D(BinaryReader& reader)
+		{
+			TF2DPreset preset;
+			preset.DensityResolution = reader.Read<std::int32_t>();
+			preset.GradientResolution = reader.Read<std::int32_t>();
+
+			const auto widgets = ReadVector<StoredWidget>(reader);
+			preset.Widgets.resize(widgets.size());
+			std::ranges::transform(widgets, preset.Widgets.begin(), [](const StoredWidget& w)
+			{
+				TFWidget2D widget;
+				widget.Shape = w.Shape == static_cast<std::uint32_t>(TFWidget2DShape::Triangle) ? TFWidget2DShape::Triangle : TFWidget2DShape::Box;
+				widget.Center = glm::vec2(w.Center[0], w.Center[1]);
+				widget.Extent = glm::vec2(w.Extent[0], w.Extent[1]);
+				widget.Color = glm::vec3(w.Color[0], w.Color[1], w.Color[2]);
+				widget.Opacity = w.Opacity;
+				return widget;
+			});
+
+			preset.Lut = ReadVector<glm::vec4>(reader);
+			return preset;
+		}
+
+		bool IsFinite(float value)
+		{
+			return std::isfinite(value);
+		}
+
+		bool IsFinite(const glm::vec4& value)
+		{
+			return std::isfinite(value.x) && std::isfinite(value.y) && std::isfinite(value.z) && std::isfinite(value.w);
+		}
+
+		bool IsValidWidget(const TFWidget2D& w)
+		{
+			return std::isfinite(w.Center.x) && std::isfinite(w.Center.y) && std::isfinite(w.Extent.x) && std::isfinite(w.Extent.y) &&
+				w.Extent.x >= 0.0f && w.Extent.y >= 0.0f && IsFinite(glm::vec4(w.Color, w.Opacity));
+		}
+
+		/*
+		* Everything the TFs rely on when the preset is applied, control points index the LUT, so they have to be sorted and within it.
+		* Damaged file is rejected here rather than written out of bounds when the intervals are rasterized.
+		*/
+		bool IsConsistent(const TFPreset& preset)
+		{
+			if (preset.Opacity && (preset.Opacity->DataRange < 0 || !LinearInterpolation::AreControlPointsValid(preset.Opacity->ControlPoints, preset.Opacity->Lut.size())
+				|| !std::ranges::all_of(preset.Opacity->Lut, [](float v) { return IsFinite(v); })))
+			{
+				return false;
+			}
+			if (preset.Color && (preset.Color->DataRange < 0 || !LinearInterpolation::AreControlPointsValid(preset.Color->ControlPoints, preset.Color->Lut.size())
+				|| preset.Color->ControlColors.size() != preset.Color->ControlPoints.size()
+				|| !std::ranges::all_of(preset.Color->ControlColors, [](const glm::vec4& v) { return IsFinite(v); })
+				|| !std::ranges::all_of(preset.Color->Lut, [](const glm::vec4& v) { return IsFinite(v); })))
+			{
+				return false;
+			}
+			if (preset.Tf2D && (preset.Tf2D->DensityResolution <= 0 || preset.Tf2D->GradientResolution <= 0
+				|| preset.Tf2D->Lut.size() != static_cast<size_t>(preset.Tf2D->DensityResolution) * preset.Tf2D->GradientResolution
+				|| !std::ranges::all_of(preset.Tf2D->Widgets, IsValidWidget)
+				|| !std::ranges::all_of(preset.Tf2D->Lut, [](const glm::vec4& v) { return IsFinite(v); })))
+			{
+				return false;
+			}
+			return true;
+		}
+	}
+
+	bool TFPresetLibrary::Save(const std::filesystem::path& path, std::span<const TFPreset> presets)
+	{
+		BinaryWriter writer(path);
+
+		writer.Write(kMagic);
+		writer.Write(kVersion);
+		writer.Write(kByteOrder);
+		writer.Write(static_cast<std::uint32_t>(presets.size()));
+
+		for (const auto& preset : presets)
+		{
+			assert(IsConsistent(preset) && "Preset is not consistent");
+
+			const std::uint32_t parts = (preset.Opacity ? kOpacityPart : 0) | (preset.Color ? kColorPart : 0) | (preset.Tf2D ? kTf2DPart : 0);
+			writer.Write(preset.Name);
+			writer.Write(parts);
+
+			if (preset.Opacity)
+			{
+				WriteOpacity(writer, *preset.Opacity);
+			}
+			if (preset.Color)
+			{
+				WriteColor(writer, *preset.Color);
+			}
+			if (preset.Tf2D)
+			{
+				WriteTf2D(writer, *preset.Tf2D);
+			}
+		}
+
+		if (!writer.IsGood())
+		{
+			LOG_ERROR("Unable to write TF presets");
+			return false;
+		}
+		return true;
+	}
+
+	bool TFPresetLibrary::Load(const std::filesystem::path& path)
+	{
+		auto mapping = MappedFile::Open(path);
+		if (mapping == nullptr)
+		{
+			LOG_ERROR("Unable to open TF presets");
+			return false;
+		}
+
+		BinaryReader reader(mapping->GetBytes());
+
+		if (reader.Read<std::array<char, 4>>() != kMagic || reader.Read<std::uint32_t>() != kVersion || reader.Read<std::uint32_t>() != kByteOrder)
+		{
+			LOG_ERROR("Invalid TF presets format");
+			return false;
+		}
+
+		const auto count = reader.Read<std::uint32_t>();
+		std::vector<TFPreset> presets{};
+		for (std::uint32_t i = 0; i < count && !reader.HasFailed(); ++i)
+		{
+			TFPreset preset;
+			preset.Name = reader.ReadString();
+			const auto parts = reader.Read<std::uint32_t>();
+
+			if (parts & kOpacityPart)
+			{
+				preset.Opacity = ReadOpacity(reader);
+			}
+			if (parts & kColorPart)
+			{
+				preset.Color = ReadColor(reader);
+			}
+			if (parts & kTf2DPart)
+			{
+				preset.Tf2D = ReadTf2D(reader);
+			}
+
+			if (!reader.HasFailed() && !IsConsistent(preset))
+			{
+				LOG_ERROR("TF presets are damaged");
+				return false;
+			}
+			presets.push_back(std::move(preset));
+		}
+
+		if (reader.HasFailed())
+		{
+			LOG_ERROR("TF presets are truncated");
+			return false;
+		}
+
+		m_Presets = std::move(presets);
+		std::string t = "Loaded " + std::to_string(m_Presets.size()) + " TF preset(s)";
+		LOG_INFO(t.c_str());
+		return true;
+	}
+
+	void TFPresetLibrary::Add(TFPreset preset)
+	{
+		assert(IsConsistent(preset) && "Preset is not consistent");
+
+		if (const int index = Find(preset.Name); index != -1)
+		{
+			m_Presets[index] = std::move(preset);
+			return;
+		}
+		m_Presets.push_back(std::move(preset));
+	}
+
+	void TFPresetLibrary::Remove(size_t index)
+	{
+		assert(index < m_Presets.size() && "Preset index out of bounds");
+		m_Presets.erase(m_Presets.begin() + static_cast<std::ptrdiff_t>(index));
+	}
+
+	int TFPresetLibrary::Find(const std::string& name) const
+	{
+		auto it = std::ranges::find(m_Presets, name, &TFPreset::Name);
+		return it != m_Presets.end() ? static_cast<int>(std::distance(m_Presets.begin(), it)) : -1;
+	}
+
+	const std::vector<TFPreset>& TFPresetLibrary::GetPresets() const
+	{
+		return m_Presets;
+	}
+
+	size_t TFPresetLibrary::GetCount() const
+	{
+		return m_Presets.size();
+	}
+}
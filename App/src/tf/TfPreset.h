@@ -0,0 +1,104 @@
+#pragma once
+
+#include "TfWidget2D.h"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace med
+{
+	/*
+	* @brief State of the opacity TF, Lut are the rasterized texels (its size is the TF resolution).
+	*/
+	struct OpacityPreset
+	{
+		int DataRange = 0;
+		std::vector<glm::dvec2> ControlPoints{};
+		std::vector<float> Lut{};
+	};
+
+	/*
+	* @brief State of the color TF, one color per control point.
+	*/
+	struct ColorPreset
+	{
+		int DataRange = 0;
+		std::vector<glm::dvec2> ControlPoints{};
+		std::vector<glm::vec4> ControlColors{};
+		std::vector<glm::vec4> Lut{};
+	};
+
+	/*
+	* @brief State of the 2D TF, Lut is densityResolution * gradientResolution texels.
+	*/
+	struct TF2DPreset
+	{
+		int DensityResolution = 0;
+		int GradientResolution = 0;
+		std::vector<TFWidget2D> Widgets{};
+		std::vector<glm::vec4> Lut{};
+	};
+
+	/*
+	* @brief Named set of transfer functions switched together (e.g. clinical preset), parts that are not set are left untouched on apply.
+	*/
+	struct TFPreset
+	{
+		std::string Name{};
+		std::optional<OpacityPreset> Opacity{};
+		std::optional<ColorPreset> Color{};
+		std::optional<TF2DPreset> Tf2D{};
+	};
+
+	/*
+	* @brief Presets loaded at once from a binary file, switching between them copies the stored LUTs (no parsing, no re-interpolation).
+	* File (native byte order, other order is rejected):
+	*   header (magic, version, byte order, preset count)
+	*   per preset: name, mask of the stored parts, then every stored part with its control points/widgets and its LUT
+	* File is mapped and every array is read with a single memcpy. Presets are applied to the TFs by TFPresetPanel,
+	* the library itself does not depend on the renderer.
+	*/
+	class TFPresetLibrary
+	{
+	public:
+		// Bumped whenever the layout changes, older files are rejected
+		static constexpr std::uint32_t kVersion = 1;
+
+		/*
+		* @brief Writes the presets into one file.
+		* @return false if the file could not be written
+		*/
+		static bool Save(const std::filesystem::path& path, std::span<const TFPreset> presets);
+
+		/*
+		* @brief Replaces the presets of the library by the presets of the file, library is unchanged on failure.
+		* @return false if the file is missing, damaged or of different version
+		*/
+		bool Load(const std::filesystem::path& path);
+
+		/*
+		* @brief Adds preset (e.g. captured from the current TFs), preset of the same name is replaced.
+		*/
+		void Add(TFPreset preset);
+
+		/*
+		* @brief Index of the preset with the name, -1 if there is none.
+		*/
+		int Find(const std::string& name) const;
+
+		/*
+		* @brief Removes the preset, indices of the following presets decrease by one.
+		*/
+		void Remove(size_t index);
+
+		const std::vector<TFPreset>& GetPresets() const;
+		size_t GetCount() const;
+	private:
+		std::vector<TFPreset> m_Presets{};
+	};
+}
@@ -0,0 +1,125 @@
+#include "TfPresetPanel.h"
+#include "OpacityTf.h"
+#include "ColorTf.h"
+#include "TransferFunction2D.h"
+#include "Base/Base.h"
+#include "imgui.h"
+#include "../file/FileSystem.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <vector>
+
+namespace med
+{
+	TFPresetPanel::TFPresetPanel(OpacityTF* opacity, ColorTF* color, TransferFunction2D* tf2d) :
+		p_OpacityTf(opacity), p_ColorTf(color), p_Tf2D(tf2d)
+	{
+	}
+
+	void TFPresetPanel::Render()
+	{
+		ImGui::SeparatorText("Presets");
+
+		std::vector<const char*> names{};
+		std::ranges::transform(m_Library.GetPresets(), std::back_inserter(names), [](const TFPreset& preset) { return preset.Name.c_str(); });
+		ImGui::ListBox("##Presets", &m_SelectedPreset, names.data(), static_cast<int>(names.size()));
+
+		const bool hasSelection = m_SelectedPreset >= 0 && static_cast<std::size_t>(m_SelectedPreset) < m_Library.GetCount();
+		ImGui::Checkbox("Rescale to data range", &m_Rescale);
+		if (ImGui::Button("Apply preset") && hasSelection)
+		{
+			Apply(m_SelectedPreset, m_Rescale ? TFLoadOption::RESCALE_TO_NEW_RANGE : TFLoadOption::NONE);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Remove preset") && hasSelection)
+		{
+			m_Library.Remove(m_SelectedPreset);
+			m_SelectedPreset = -1;
+		}
+
+		ImGui::InputText("Preset name", m_NameBuffer, IM_ARRAYSIZE(m_NameBuffer));
+		if (ImGui::Button("Add current TFs"))
+		{
+			std::string name = m_NameBuffer;
+			if (name.empty())
+			{
+				name = "preset" + std::to_string(m_Library.GetCount());
+			}
+			Capture(name);
+			m_SelectedPreset = m_Library.Find(name);
+		}
+
+		ImGui::InputText("Presets file", m_FileBuffer, IM_ARRAYSIZE(m_FileBuffer));
+		std::string file = m_FileBuffer;
+		if (file.empty())
+		{
+			file = "presets.tfp";
+		}
+		if (ImGui::Button("Save presets"))
+		{
+			Save(FileSystem::GetDefaultPath() / "assets" / file);
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Load presets") && Load(FileSystem::GetDefaultPath() / "assets" / file))
+		{
+			m_SelectedPreset = -1;
+		}
+	}
+
+	void TFPresetPanel::Capture(const std::string& name)
+	{
+		TFPreset preset{ .Name = name };
+		if (p_OpacityTf != nullptr)
+		{
+			preset.Opacity = p_OpacityTf->GetPreset();
+		}
+		if (p_ColorTf != nullptr)
+		{
+			preset.Color = p_ColorTf->GetPreset();
+		}
+		if (p_Tf2D != nullptr)
+		{
+			preset.Tf2D = p_Tf2D->GetPreset();
+		}
+		m_Library.Add(std::move(preset));
+	}
+
+	void TFPresetPanel::Apply(std::size_t index, TFLoadOption option)
+	{
+		assert(index < m_Library.GetCount() && "Preset index out of bounds");
+		const TFPreset& preset = m_Library.GetPresets()[index];
+
+		if (p_OpacityTf != nullptr && preset.Opacity)
+		{
+			p_OpacityTf->ApplyPreset(*preset.Opacity, option);
+		}
+		if (p_ColorTf != nullptr && preset.Color)
+		{
+			p_ColorTf->ApplyPreset(*preset.Color);
+		}
+		if (p_Tf2D != nullptr && preset.Tf2D)
+		{
+			p_Tf2D->ApplyPreset(*preset.Tf2D);
+		}
+
+		std::string str = "Applied TF preset " + preset.Name;
+		LOG_INFO(str.c_str());
+	}
+
+	bool TFPresetPanel::Save(const std::filesystem::path& path) const
+	{
+		return TFPresetLibrary::Save(path, m_Library.GetPresets());
+	}
+
+	bool TFPresetPanel::Load(const std::filesystem::path& path)
+	{
+		return m_Library.Load(path);
+	}
+
+	const TFPresetLibrary& TFPresetPanel::GetLibrary() const
+	{
+		return m_Library;
+	}
+}
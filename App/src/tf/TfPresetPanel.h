@@ -0,0 +1,59 @@
+#pragma once
+
+#include "TfPreset.h"
+#include "TransferFunction.h"
+
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+namespace med
+{
+	class OpacityTF;
+	class ColorTF;
+	class TransferFunction2D;
+
+	/*
+	* @brief Preset list of the TF editor, captures the edited TFs into the library, applies the selected preset to them
+	* and saves/loads the whole library (see TFPresetLibrary).
+	*/
+	class TFPresetPanel
+	{
+	public:
+		/*
+		* @brief Panel editing the given TFs, any of them may be nullptr, TFs have to outlive the panel.
+		*/
+		TFPresetPanel(OpacityTF* opacity, ColorTF* color, TransferFunction2D* tf2d = nullptr);
+
+		/*
+		* @brief Render the preset list with its controls
+		*/
+		void Render();
+
+		/*
+		* @brief Stores the current state of the TFs as preset of the name, preset of the same name is replaced.
+		*/
+		void Capture(const std::string& name);
+
+		/*
+		* @brief Applies the preset to the TFs, parts the preset does not store are left untouched. Stored LUT is copied
+		* if it matches the TF, otherwise the TF is rebuilt from the control points/widgets.
+		*/
+		void Apply(std::size_t index, TFLoadOption option = TFLoadOption::NONE);
+
+		bool Save(const std::filesystem::path& path) const;
+		bool Load(const std::filesystem::path& path);
+
+		const TFPresetLibrary& GetLibrary() const;
+	private:
+		TFPresetLibrary m_Library{};
+		OpacityTF* p_OpacityTf = nullptr;
+		ColorTF* p_ColorTf = nullptr;
+		TransferFunction2D* p_Tf2D = nullptr;
+
+		int m_SelectedPreset = -1;
+		bool m_Rescale = false;
+		char m_NameBuffer[30] = { 0 };
+		char m_FileBuffer[30] = { 0 };
+	};
+}
@@ -0,0 +1,103 @@
+#include "TfWidget2D.h"
+#include "Base/ThreadPool.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+namespace med
+{
+	float TFWidget2DRasterizer::Evaluate(const TFWidget2D& widget, float x, float y)
+	{
+		const float dx = std::abs(x - widget.Center.x);
+		if (widget.Shape == TFWidget2DShape::Box)
+		{
+			return dx <= widget.Extent.x && std::abs(y - widget.Center.y) <= widget.Extent.y ? widget.Opacity : 0.0f;
+		}
+
+		// Triangle widens from the apex to the base
+		const float t = (y - (widget.Center.y - widget.Extent.y)) / (2.0f * widget.Extent.y);
+		const float halfWidth = widget.Extent.x * t;
+		if (t < 0.0f || t > 1.0f || halfWidth <= 0.0f || dx > halfWidth)
+		{
+			return 0.0f;
+		}
+		return widget.Opacity * (1.0f - dx / halfWidth);
+	}
+
+	std::pair<int, int> TFWidget2DRasterizer::GetTexelRange(float from, float to, int resolution)
+	{
+		const int first = std::max(static_cast<int>(std::ceil(from * resolution - 0.5f)), 0);
+		const int last = std::min(static_cast<int>(std::floor(to * resolution - 0.5f)), resolution - 1);
+		return { first, last };
+	}
+
+	void TFWidget2DRasterizer::Rasterize(std::span<const TFWidget2D> widgets, int densityResolution, int gradientResolution, std::span<glm::vec4> lut)
+	{
+		Rasterize(widgets, densityResolution, gradientResolution, lut, { 0, gradientResolution - 1 });
+	}
+
+	void TFWidget2DRasterizer::Rasterize(std::span<const TFWidget2D> widgets, int densityResolution, int gradientResolution, std::span<glm::vec4> lut,
+		std::pair<int, int> rows)
+	{
+		assert(lut.size() == static_cast<size_t>(densityResolution) * gradientResolution && "LUT size does not match the resolution");
+		assert(rows.first >= 0 && rows.second < gradientResolution && "Rows are outside of the LUT");
+
+		if (rows.first > rows.second)
+		{
+			return;
+		}
+
+		base::ThreadPool::Get().ParallelFor(rows.first, rows.second + 1, [&](size_t row)
+		{
+			const std::span<glm::vec4> texels = lut.subspan(row * densityResolution, densityResolution);
+
+			// rgb accumulates alpha weighted color, a the transparency, weights are kept aside
+			std::fill(texels.begin(), texels.end(), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+			std::vector<float> weights(densityResolution, 0.0f);
+
+			const float y = (static_cast<float>(row) + 0.5f) / gradientResolution;
+			for (const TFWidget2D& widget : widgets)
+			{
+				if (std::abs(y - widget.Center.y) > widget.Extent.y || widget.Opacity <= 0.0f)
+				{
+					continue;
+				}
+
+				const auto [first, last] = GetTexelRange(widget.Center.x - widget.Extent.x, widget.Center.x + widget.Extent.x, densityResolution);
+				for (int i = first; i <= last; ++i)
+				{
+					const float alpha = Evaluate(widget, (static_cast<float>(i) + 0.5f) / densityResolution, y);
+					if (alpha > 0.0f)
+					{
+						texels[i] = glm::vec4(glm::vec3(texels[i]) + alpha * widget.Color, texels[i].a * (1.0f - alpha));
+						weights[i] += alpha;
+					}
+				}
+			}
+
+			for (int i = 0; i < densityResolution; ++i)
+			{
+				const glm::vec3 color = weights[i] > 0.0f ? glm::vec3(texels[i]) / weights[i] : glm::vec3(0.0f);
+				texels[i] = glm::vec4(color, 1.0f - texels[i].a);
+			}
+		});
+	}
+
+	void TFWidget2DRasterizer::ProjectOpacity(std::span<const glm::vec4> lut, int densityResolution, std::span<float> opacity)
+	{
+		assert(densityResolution > 0 && lut.size() % densityResolution == 0 && "LUT size does not match the resolution");
+		assert(opacity.size() == static_cast<size_t>(densityResolution) && "Opacity size does not match the resolution");
+
+		std::fill(opacity.begin(), opacity.end(), 0.0f);
+		for (size_t row = 0; row < lut.size() / densityResolution; ++row)
+		{
+			const std::span<const glm::vec4> texels = lut.subspan(row * densityResolution, densityResolution);
+			for (int i = 0; i < densityResolution; ++i)
+			{
+				opacity[i] = std::max(opacity[i], texels[i].a);
+			}
+		}
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <span>
+#include <utility>
+
+namespace med
+{
+	enum class TFWidget2DShape
+	{
+		Box = 0,
+		Triangle = 1
+	};
+
+	/*
+	* @brief Editable primitive of the 2D TF, coordinates are normalized (x - density, y - gradient magnitude, both in [0, 1]).
+	* Box is constant inside of Center +- Extent, Triangle has its apex at (Center.x, Center.y - Extent.y) and its base
+	* of half width Extent.x at Center.y + Extent.y, its opacity falls off linearly from the middle line to the edges.
+	*/
+	struct TFWidget2D
+	{
+		TFWidget2DShape Shape = TFWidget2DShape::Box;
+		glm::vec2 Center{ 0.5f };
+		glm::vec2 Extent{ 0.1f };
+		glm::vec3 Color{ 1.0f };
+		float Opacity = 0.5f;
+	};
+
+	/**
+	 * @brief CPU rasterization of the 2D TF widgets into the RGBA LUT, GPU-free so it can be tested and used headless.
+	 * LUT texel (density, magnitude) is [magnitude * densityResolution + density], texels are sampled at their centers.
+	 */
+	class TFWidget2DRasterizer
+	{
+	protected:
+		TFWidget2DRasterizer() = default;
+	public:
+		/*
+		* @brief Opacity of the widget at normalized point (x, y), 0 outside.
+		*/
+		static float Evaluate(const TFWidget2D& widget, float x, float y);
+
+		/*
+		* @brief Texels of [0, resolution) whose centers lie in [from, to], first > last if none.
+		*/
+		static std::pair<int, int> GetTexelRange(float from, float to, int resolution);
+
+		/*
+		* @brief Rasterizes the widgets into the LUT, rows are filled in parallel and every widget touches only texels of its bounding box.
+		* Overlapping widgets are composited: alpha = 1 - prod(1 - a), color is the alpha weighted average.
+		* @param lut: densityResolution * gradientResolution texels, overwritten
+		*/
+		static void Rasterize(std::span<const TFWidget2D> widgets, int densityResolution, int gradientResolution, std::span<glm::vec4> lut);
+
+		/*
+		* @brief Same as above for the LUT rows [rows.first, rows.second] only, the other rows are left untouched.
+		*/
+		static void Rasterize(std::span<const TFWidget2D> widgets, int densityResolution, int gradientResolution, std::span<glm::vec4> lut,
+			std::pair<int, int> rows);
+
+		/*
+		* @brief Largest opacity of every density column over all magnitudes. A brick is visible under the 2D TF only if some of its
+		* densities are visible at some magnitude, so this 1D projection classifies the occupancy conservatively (OccupancyMap).
+		* @param opacity: densityResolution values, overwritten
+		*/
+		static void ProjectOpacity(std::span<const glm::vec4> lut, int densityResolution, std::span<float> opacity);
+	};
+}
@@ -2,7 +2,9 @@
 #include "Base/GraphicsContext.h"
 #include "Base/Base.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <iterator>
 
 namespace med
@@ -52,6 +54,22 @@ namespace med
 		m_DataRange = range;
 	}
 
+	bool TransferFunction::ShouldUpdate() const
+	{
+		return m_ShouldUpdate;
+	}
+
+	std::pair<size_t, size_t> TransferFunction::GetDirtyTexels() const
+	{
+		return m_DirtyTexels;
+	}
+
+	void TransferFunction::MarkDirty(size_t first, size_t last)
+	{
+		m_DirtyTexels = m_ShouldUpdate ? std::pair{ std::min(m_DirtyTexels.first, first), std::max(m_DirtyTexels.second, last) } : std::pair{ first, last };
+		m_ShouldUpdate = true;
+	}
+
 	glm::dvec2 TransferFunction::RemapCP(glm::dvec2 cp, int dataRange, int tfResolution)
 	{
 		tfResolution -= 1; // indexed from 0
@@ -120,6 +138,21 @@ namespace med
 		return result;
 	}
 
+	std::vector<glm::dvec2> TransferFunction::ResampleCPVector(std::vector<glm::dvec2> cps, int tfResolution) const
+	{
+		if (tfResolution == m_TextureResolution || tfResolution < 2)
+		{
+			return cps;
+		}
+
+		const double scale = static_cast<double>(m_TextureResolution - 1) / (tfResolution - 1);
+		for (auto& cp : cps)
+		{
+			cp.x = std::round(cp.x * scale);
+		}
+		return cps;
+	}
+
 	int TransferFunction::AddControlPoint(double mouseX, double mouseY, bool updateOnAdd)
 	{
 		constexpr int CONTROL_POINT_EXISTS = -1;
@@ -6,6 +6,7 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <utility>
 
 namespace med
 {
@@ -53,6 +54,16 @@ namespace med
 		*/
 		void SetDataRange(int range);
 
+		/*
+		* @brief True if the TF has changed since the last UpdateTexture.
+		*/
+		bool ShouldUpdate() const;
+
+		/*
+		* @brief Inclusive range of texels changed since the last UpdateTexture, valid only if ShouldUpdate().
+		*/
+		std::pair<size_t, size_t> GetDirtyTexels() const;
+
 		/*
 		* @brief Remaps CP that was defined on one dataset to this TF data range. 
 		* Member function assumes you have set the data range for this TF.
@@ -70,6 +81,11 @@ namespace med
 		*/
 		std::vector<glm::dvec2> RemapCPVector(std::vector<glm::dvec2> cps, int dataRange, int tfResolution);
 
+		/*
+		* @brief Moves control points defined on a TF of different resolution to this TF resolution, data range is kept.
+		*/
+		std::vector<glm::dvec2> ResampleCPVector(std::vector<glm::dvec2> cps, int tfResolution) const;
+
 		/*
 		* @brief Adds point to the TF
 		* @param mouseX: Click position within the plot
@@ -77,12 +93,18 @@ namespace med
 		* @param updateOnAdd: Whether trigger recalculation of Y axis (1D TF)
 		*/
 		int AddControlPoint(double mouseX, double mouseY, bool updateOnAdd = true);
+	protected:
+		/*
+		* @brief Extends the dirty range by the texels [first, last] and flags the TF for update
+		*/
+		void MarkDirty(size_t first, size_t last);
 	protected:
 		std::shared_ptr<Texture> p_Texture = nullptr;
 		std::vector<glm::dvec2> m_ControlPoints{};
 		int m_TextureResolution = 0;
 		int m_DataRange = 0;
 		bool m_ShouldUpdate = false;
+		std::pair<size_t, size_t> m_DirtyTexels{ 0, 0 };
 		char m_NameBuffer[30] = { 0 };
 	};
 }
\ No newline at end of file
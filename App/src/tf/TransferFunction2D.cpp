@@ -0,0 +1,337 @@
+#include "TransferFunction2D.h"
+#include "Base/Base.h"
+#include "Base/GraphicsContext.h"
+#include "implot/implot.h"
+#include "TfPreset.h"
+#include "../file/HistogramEngine.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace med
+{
+	TransferFunction2D::TransferFunction2D(int densityResolution, int gradientResolution) :
+		m_DensityResolution(densityResolution), m_GradientResolution(gradientResolution)
+	{
+		const int maxResolution = static_cast<int>(base::GraphicsContext::GetLimits().maxTextureDimension2D);
+		if (m_DensityResolution > maxResolution || m_GradientResolution > maxResolution)
+		{
+			LOG_WARN("2D TF resolution is greater than max texture 2D size, clamping to max texture size");
+			m_DensityResolution = std::min(m_DensityResolution, maxResolution);
+			m_GradientResolution = std::min(m_GradientResolution, maxResolution);
+		}
+		assert(m_DensityResolution > 0 && m_GradientResolution > 0 && "Invalid 2D TF resolution");
+
+		m_Lut.resize(static_cast<size_t>(m_DensityResolution) * m_GradientResolution, glm::vec4(0.0f));
+
+		ResetTF();
+
+		p_Texture = Texture::CreateFromData(base::GraphicsContext::GetDevice(), base::GraphicsContext::GetQueue(), m_Lut.data(), WGPUTextureDimension_2D,
+			{ m_DensityResolution, m_GradientResolution, 1 }, WGPUTextureFormat_RGBA32Float, WGPUTextureUsage_TextureBinding | WGPUTextureUsage_CopyDst,
+			sizeof(glm::vec4), "2D TF");
+	}
+
+	void TransferFunction2D::Render()
+	{
+		if (ImPlot::BeginPlot("##tf2dplot"))
+		{
+			ImPlot::SetupAxes("Density", "Gradient magnitude");
+			ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, 1.0);
+			ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, 1.0);
+			ImPlot::SetupAxisLimitsConstraints(ImAxis_X1, 0.0, 1.0);
+			ImPlot::SetupAxisLimitsConstraints(ImAxis_Y1, 0.0, 1.0);
+
+			// Plot histogram, rows are stored top to bottom
+			if (!m_Histogram.empty())
+			{
+				ImPlot::PushColormap(ImPlotColormap_Viridis);
+				ImPlot::PlotHeatmap("##Histogram", m_Histogram.data(), m_GradientResolution, m_DensityResolution, 0.0, 1.0, nullptr);
+				ImPlot::PopColormap();
+			}
+
+			// Plot widgets, every widget has a center and a corner (extent) point
+			bool isDragging = false;
+			bool isHovered = false;
+			for (int id = 0; id < static_cast<int>(m_Widgets.size()); ++id)
+			{
+				TFWidget2D& widget = m_Widgets[id];
+				const auto rowsBefore = GetWidgetRows(widget);
+				const float l = widget.Center.x - widget.Extent.x;
+				const float r = widget.Center.x + widget.Extent.x;
+				const float b = widget.Center.y - widget.Extent.y;
+				const float t = widget.Center.y + widget.Extent.y;
+
+				const std::string label = "##widget" + std::to_string(id);
+				if (widget.Shape == TFWidget2DShape::Box)
+				{
+					const float xs[] = { l, r, r, l, l };
+					const float ys[] = { b, b, t, t, b };
+					ImPlot::PlotLine(label.c_str(), xs, ys, 5);
+				}
+				else
+				{
+					const float xs[] = { widget.Center.x, r, l, widget.Center.x };
+					const float ys[] = { b, t, t, b };
+					ImPlot::PlotLine(label.c_str(), xs, ys, 4);
+				}
+
+				const ImVec4 color = id == m_SelectedWidget ? ImVec4(1, 0.5f, 0, 1) : ImVec4(0, 0.9f, 0, 1);
+				bool clicked = false;
+				bool hovered = false;
+
+				double cx = widget.Center.x;
+				double cy = widget.Center.y;
+				const bool centerDragged = ImPlot::DragPoint(2 * id, &cx, &cy, color, 4, ImPlotDragToolFlags_Delayed, &clicked, &hovered, nullptr);
+				isHovered |= hovered;
+
+				double ex = r;
+				double ey = t;
+				const bool cornerDragged = ImPlot::DragPoint(2 * id + 1, &ex, &ey, color, 3, ImPlotDragToolFlags_Delayed, &clicked, &hovered, nullptr);
+				isHovered |= hovered;
+
+				if (clicked)
+				{
+					m_SelectedWidget = id;
+				}
+
+				if (centerDragged)
+				{
+					widget.Center = glm::clamp(glm::vec2(cx, cy), glm::vec2(0.0f), glm::vec2(1.0f));
+				}
+				else if (cornerDragged)
+				{
+					widget.Extent = glm::max(glm::abs(glm::vec2(ex, ey) - widget.Center), glm::vec2(1e-3f));
+				}
+
+				// Rasterization is cheap enough to follow the drag every frame, rows the widget left and entered are rebuilt
+				if (centerDragged || cornerDragged)
+				{
+					UpdateLut(JoinRows(rowsBefore, GetWidgetRows(widget)));
+				}
+				isDragging |= centerDragged || cornerDragged;
+			}
+
+			auto dragDelta = ImGui::GetMouseDragDelta(ImGuiMouseButton_Left, 0.1f);
+			const bool hasClicked = ImPlot::IsPlotHovered() && ImGui::IsMouseReleased(ImGuiMouseButton_Left)
+				&& dragDelta.x == 0.0 && dragDelta.y == 0.0 && !isHovered && !isDragging;
+
+			// Click on empty space adds a widget
+			if (hasClicked)
+			{
+				ImPlotPoint mousePos = ImPlot::GetPlotMousePos();
+				TFWidget2D widget{};
+				widget.Center = glm::vec2(mousePos.x, mousePos.y);
+				m_SelectedWidget = static_cast<int>(AddWidget(widget));
+				LOG_TRACE("Added 2D TF widget");
+			}
+
+			ImPlot::EndPlot();
+		}
+
+		if (m_SelectedWidget >= 0 && m_SelectedWidget < static_cast<int>(m_Widgets.size()))
+		{
+			TFWidget2D& widget = m_Widgets[m_SelectedWidget];
+			bool changed = false;
+
+			changed |= ImGui::ColorEdit3("Widget color", glm::value_ptr(widget.Color));
+			changed |= ImGui::SliderFloat("Widget opacity", &widget.Opacity, 0.0f, 1.0f);
+
+			int shape = static_cast<int>(widget.Shape);
+			if (ImGui::Combo("Widget shape", &shape, "Box\0Triangle\0"))
+			{
+				widget.Shape = static_cast<TFWidget2DShape>(shape);
+				changed = true;
+			}
+
+			if (changed)
+			{
+				UpdateLut(GetWidgetRows(widget));
+			}
+
+			if (ImGui::Button("Remove widget"))
+			{
+				RemoveWidget(m_SelectedWidget);
+			}
+		}
+
+		if (ImGui::Button("Reset"))
+		{
+			ResetTF();
+		}
+	}
+
+	void TransferFunction2D::UpdateTexture()
+	{
+		if (m_ShouldUpdate)
+		{
+			assert(p_Texture != nullptr && "Texture is not initialized");
+			// Only the rows changed since the last upload are written
+			const auto [first, last] = m_DirtyRows;
+			const std::span<const glm::vec4> rows = std::span<const glm::vec4>(m_Lut).subspan(static_cast<size_t>(first) * m_DensityResolution,
+				static_cast<size_t>(last - first + 1) * m_DensityResolution);
+			p_Texture->UpdateRegion(base::GraphicsContext::GetQueue(), { 0, static_cast<std::uint32_t>(first), 0 },
+				{ static_cast<std::uint32_t>(m_DensityResolution), static_cast<std::uint32_t>(last - first + 1), 1 }, std::as_bytes(rows));
+			m_ShouldUpdate = false;
+		}
+	}
+
+	void TransferFunction2D::ActivateHistogram(const VolumeFile& file)
+	{
+		if (!file.HasGradient())
+		{
+			LOG_WARN("2D TF histogram needs the pre-computed gradient");
+			return;
+		}
+
+		// Same density bins as OpacityTF, magnitude is relative to the largest one
+		HistogramBinning densityBinning = HistogramBinning::FromRange(m_DensityResolution, static_cast<double>(file.GetDataRange()));
+		if (file.IsNormalized())
+		{
+			densityBinning.Scale = static_cast<double>(file.GetDensityScale()) * m_DensityResolution;
+		}
+		const HistogramBinning magnitudeBinning = HistogramBinning::FromRange(m_GradientResolution, file.GetGradientMaxMagnitude());
+
+		const auto bins = HistogramEngine::ComputeDensityGradient(file.GetDensityBuffer(), file.GetGradient(), densityBinning, magnitudeBinning);
+
+		// Log scale, rows are flipped so the magnitude grows upwards in the plot
+		const float maxVal = std::log10(static_cast<float>(std::max<size_t>(file.GetGradient().size(), 2)));
+		m_Histogram.assign(bins.size(), 0.0f);
+		for (int y = 0; y < m_GradientResolution; ++y)
+		{
+			const size_t src = static_cast<size_t>(y) * m_DensityResolution;
+			const size_t dst = static_cast<size_t>(m_GradientResolution - 1 - y) * m_DensityResolution;
+			for (int x = 0; x < m_DensityResolution; ++x)
+			{
+				const std::uint32_t count = bins[src + x];
+				m_Histogram[dst + x] = count != 0 ? std::log10(static_cast<float>(count)) / maxVal : 0.0f;
+			}
+		}
+	}
+
+	std::string TransferFunction2D::GetType() const
+	{
+		return "[tf2d]";
+	}
+
+	void TransferFunction2D::ResetTF()
+	{
+		m_Widgets.clear();
+		m_SelectedWidget = -1;
+		UpdateLut({ 0, m_GradientResolution - 1 });
+	}
+
+	size_t TransferFunction2D::AddWidget(const TFWidget2D& widget)
+	{
+		m_Widgets.push_back(widget);
+		UpdateLut(GetWidgetRows(widget));
+		return m_Widgets.size() - 1;
+	}
+
+	void TransferFunction2D::SetWidget(size_t index, const TFWidget2D& widget)
+	{
+		assert(index < m_Widgets.size() && "Widget index out of bounds");
+		const auto rowsBefore = GetWidgetRows(m_Widgets[index]);
+		m_Widgets[index] = widget;
+		UpdateLut(JoinRows(rowsBefore, GetWidgetRows(widget)));
+	}
+
+	void TransferFunction2D::RemoveWidget(size_t index)
+	{
+		assert(index < m_Widgets.size() && "Widget index out of bounds");
+		const auto rows = GetWidgetRows(m_Widgets[index]);
+		m_Widgets.erase(m_Widgets.begin() + index);
+		m_SelectedWidget = -1;
+		UpdateLut(rows);
+	}
+
+	const std::vector<TFWidget2D>& TransferFunction2D::GetWidgets() const
+	{
+		return m_Widgets;
+	}
+
+	const std::vector<glm::vec4>& TransferFunction2D::GetLut() const
+	{
+		return m_Lut;
+	}
+
+	TF2DPreset TransferFunction2D::GetPreset() const
+	{
+		return { m_DensityResolution, m_GradientResolution, m_Widgets, m_Lut };
+	}
+
+	void TransferFunction2D::ApplyPreset(const TF2DPreset& preset)
+	{
+		m_Widgets = preset.Widgets;
+		m_SelectedWidget = -1;
+
+		if (preset.DensityResolution == m_DensityResolution && preset.GradientResolution == m_GradientResolution
+			&& preset.Lut.size() == m_Lut.size())
+		{
+			// Stored LUT is exactly what the widgets rasterize to
+			std::copy(preset.Lut.begin(), preset.Lut.end(), m_Lut.begin());
+			m_DirtyRows = { 0, m_GradientResolution - 1 };
+			m_ShouldUpdate = true;
+		}
+		else
+		{
+			// Widgets are normalized, so they fit any resolution
+			UpdateLut({ 0, m_GradientResolution - 1 });
+		}
+	}
+
+	std::shared_ptr<Texture> TransferFunction2D::GetTexture() const
+	{
+		assert(p_Texture != nullptr && "Texture is not initialized");
+		return p_Texture;
+	}
+
+	int TransferFunction2D::GetDensityResolution() const
+	{
+		return m_DensityResolution;
+	}
+
+	int TransferFunction2D::GetGradientResolution() const
+	{
+		return m_GradientResolution;
+	}
+
+	bool TransferFunction2D::ShouldUpdate() const
+	{
+		return m_ShouldUpdate;
+	}
+
+	void TransferFunction2D::UpdateLut(std::pair<int, int> rows)
+	{
+		if (rows.first > rows.second)
+		{
+			return;
+		}
+
+		TFWidget2DRasterizer::Rasterize(m_Widgets, m_DensityResolution, m_GradientResolution, m_Lut, rows);
+		m_DirtyRows = m_ShouldUpdate ? JoinRows(m_DirtyRows, rows) : rows;
+		m_ShouldUpdate = true;
+	}
+
+	std::pair<int, int> TransferFunction2D::GetWidgetRows(const TFWidget2D& widget) const
+	{
+		// One more row on both sides covers the rounding of the row centers
+		const auto [first, last] = TFWidget2DRasterizer::GetTexelRange(widget.Center.y - widget.Extent.y, widget.Center.y + widget.Extent.y, m_GradientResolution);
+		return { std::max(first - 1, 0), std::min(last + 1, m_GradientResolution - 1) };
+	}
+
+	std::pair<int, int> TransferFunction2D::JoinRows(std::pair<int, int> a, std::pair<int, int> b)
+	{
+		if (a.first > a.second)
+		{
+			return b;
+		}
+		if (b.first > b.second)
+		{
+			return a;
+		}
+		return { std::min(a.first, b.first), std::max(a.second, b.second) };
+	}
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "../renderer/Texture.h"
+#include "../file/VolumeFile.h"
+#include "TfWidget2D.h"
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace med
+{
+	struct TF2DPreset;
+
+	/*
+	* @brief Transfer function over density and gradient magnitude, boundaries between tissues are the arcs of high magnitude
+	* in the joint histogram and can be picked by the widgets. Result is a RGBA LUT (2D texture) rasterized on the CPU
+	* from the widgets whenever they change (TFWidget2DRasterizer), sampled at (density, gradient magnitude / max magnitude).
+	*/
+	class TransferFunction2D
+	{
+	public:
+		/*
+		* @brief Create 2D TF with empty LUT.
+		* @param densityResolution: Texels along the density axis
+		* @param gradientResolution: Texels along the gradient magnitude axis
+		*/
+		explicit TransferFunction2D(int densityResolution = 256, int gradientResolution = 128);
+
+		/*
+		* @brief Render the widget editor over the histogram
+		*/
+		void Render();
+
+		/*
+		* @brief Update data on the gpu
+		*/
+		void UpdateTexture();
+
+		/*
+		* When called, density x gradient magnitude histogram is plotted below the widgets, file must have the gradient.
+		*/
+		void ActivateHistogram(const VolumeFile& file);
+
+		std::string GetType() const;
+
+		void ResetTF();
+
+		/*
+		* @brief Adds widget, returns its index.
+		*/
+		size_t AddWidget(const TFWidget2D& widget);
+		void SetWidget(size_t index, const TFWidget2D& widget);
+		void RemoveWidget(size_t index);
+		const std::vector<TFWidget2D>& GetWidgets() const;
+
+		/*
+		* @brief LUT texels as they are uploaded to the GPU, texel (density, magnitude) is [magnitude * densityResolution + density].
+		*/
+		const std::vector<glm::vec4>& GetLut() const;
+
+		/*
+		* @brief Current state with the rasterized LUT (see TFPresetLibrary).
+		*/
+		TF2DPreset GetPreset() const;
+
+		/*
+		* @brief Restores the state, stored LUT is copied if it matches this TF, otherwise the LUT is rasterized from the widgets.
+		*/
+		void ApplyPreset(const TF2DPreset& preset);
+
+		std::shared_ptr<Texture> GetTexture() const;
+
+		int GetDensityResolution() const;
+		int GetGradientResolution() const;
+
+		/*
+		* @brief True if the TF has changed since the last UpdateTexture.
+		*/
+		bool ShouldUpdate() const;
+
+	private:
+		/*
+		* @brief Rebuilds the LUT rows from the widgets, extends the dirty rows and flags the TF for update
+		*/
+		void UpdateLut(std::pair<int, int> rows);
+
+		/*
+		* @brief LUT rows covered by the widget, first > last if none
+		*/
+		std::pair<int, int> GetWidgetRows(const TFWidget2D& widget) const;
+
+		static std::pair<int, int> JoinRows(std::pair<int, int> a, std::pair<int, int> b);
+
+	private:
+		std::shared_ptr<Texture> p_Texture = nullptr;
+		std::vector<TFWidget2D> m_Widgets{};
+		std::vector<glm::vec4> m_Lut{};
+		std::vector<float> m_Histogram{};
+		int m_DensityResolution = 0;
+		int m_GradientResolution = 0;
+		int m_SelectedWidget = -1;
+		bool m_ShouldUpdate = false;
+		// Inclusive range of LUT rows changed since the last UpdateTexture
+		std::pair<int, int> m_DirtyRows{ 0, 0 };
+	};
+}
@@ -0,0 +1,229 @@
+#include "Base/Base.h"
+#include "../file/dat/DatReader.h"
+#include "../file/ImageWriter.h"
+#include "../renderer/CpuRayCaster.h"
+#include "../renderer/CpuRenderBenchmark.h"
+#include "../tf/TfPreset.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+/*
+* Headless CPU renderer, renders a .dat volume with a TF preset into an image without a window or a GPU
+* (reference images, regression tests).
+*/
+
+namespace
+{
+	struct Options
+	{
+		std::filesystem::path Volume{};
+		std::filesystem::path Presets{};
+		std::filesystem::path Output{};
+		std::string Preset{};
+		med::CpuRenderSettings Settings{};
+		// Orbit of the Application camera, degrees
+		float Yaw = 0.0f;
+		float Pitch = 0.0f;
+		float Distance = 5.0f;
+		med::VoxelLayout Layout = med::VoxelLayout::Linear;
+		// Repetitions of the scalar vs packet benchmark, 0 renders only the image
+		int Benchmark = 0;
+	};
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage: CpuRender <volume.dat> <presets.tfp> <output.ppm|.png> [options]\n"
+			"  --preset <name>      preset of the file to render, first one by default\n"
+			"  --size <w> <h>       image size, 512 512 by default\n"
+			"  --steps <n>          maximum number of samples along a ray\n"
+			"  --step-size <s>      distance between samples in texture space\n"
+			"  --threshold <a>      early ray termination opacity\n"
+			"  --yaw <deg>          camera rotation around the y axis\n"
+			"  --pitch <deg>        camera rotation around the x axis\n"
+			"  --distance <d>       camera distance from the origin\n"
+			"  --scalar             march ray by ray instead of in packets\n"
+			"  --bricked            sample the density from the bricked layout\n"
+			"  --benchmark [n]      time n renders of the scalar and the packet path (3 by default) and print Mrays/s\n";
+	}
+
+	bool ParseOptions(int argc, char* argv[], Options& options)
+	{
+		if (argc < 4)
+		{
+			return false;
+		}
+		options.Volume = argv[1];
+		options.Presets = argv[2];
+		options.Output = argv[3];
+
+		for (int i = 4; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			// Number of values that have to follow the option
+			const auto has = [&](int count) { return i + count < argc; };
+
+			if (arg == "--preset" && has(1))
+			{
+				options.Preset = argv[++i];
+			}
+			else if (arg == "--size" && has(2))
+			{
+				options.Settings.Width = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+				options.Settings.Height = static_cast<std::uint32_t>(std::stoul(argv[++i]));
+			}
+			else if (arg == "--steps" && has(1))
+			{
+				options.Settings.StepsCount = std::stoi(argv[++i]);
+			}
+			else if (arg == "--step-size" && has(1))
+			{
+				options.Settings.StepSize = std::stof(argv[++i]);
+			}
+			else if (arg == "--threshold" && has(1))
+			{
+				options.Settings.OpacityThreshold = std::stof(argv[++i]);
+			}
+			else if (arg == "--yaw" && has(1))
+			{
+				options.Yaw = std::stof(argv[++i]);
+			}
+			else if (arg == "--pitch" && has(1))
+			{
+				options.Pitch = std::stof(argv[++i]);
+			}
+			else if (arg == "--distance" && has(1))
+			{
+				options.Distance = std::stof(argv[++i]);
+			}
+			else if (arg == "--scalar")
+			{
+				options.Settings.Packets = false;
+			}
+			else if (arg == "--bricked")
+			{
+				options.Layout = med::VoxelLayout::Bricked;
+			}
+			else if (arg == "--benchmark")
+			{
+				// Repetitions are optional
+				options.Benchmark = has(1) && !std::string_view(argv[i + 1]).starts_with("--") ? std::stoi(argv[++i]) : 3;
+				if (options.Benchmark < 1)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				std::cerr << "Unknown or incomplete option " << arg << "\n";
+				return false;
+			}
+		}
+		return options.Settings.Width > 0 && options.Settings.Height > 0;
+	}
+
+	/*
+	* Same transform as Camera::RecalculateViewMatrix, Camera itself depends on the window (key codes).
+	*/
+	glm::mat4 OrbitInverseView(float yaw, float pitch, float distance)
+	{
+		const glm::quat orientation = glm::quat(glm::vec3(glm::radians(pitch), glm::radians(yaw), 0.0f));
+		const glm::vec3 forward = glm::normalize(glm::rotate(orientation, glm::vec3(0.0f, 0.0f, -1.0f)));
+		return glm::translate(glm::mat4(1.0f), -forward * distance) * glm::toMat4(orientation);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	base::Log::Init();
+
+	Options options;
+	try
+	{
+		if (!ParseOptions(argc, argv, options))
+		{
+			PrintUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	catch (const std::exception&)
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	med::TFPresetLibrary library;
+	if (!library.Load(options.Presets))
+	{
+		return EXIT_FAILURE;
+	}
+
+	const int index = options.Preset.empty() ? (library.GetCount() > 0 ? 0 : -1) : library.Find(options.Preset);
+	if (index == -1)
+	{
+		LOG_ERROR("Preset not found");
+		return EXIT_FAILURE;
+	}
+
+	const med::TFPreset& preset = library.GetPresets()[index];
+	if (!preset.Opacity || !preset.Color)
+	{
+		LOG_ERROR("Preset has no opacity or color TF");
+		return EXIT_FAILURE;
+	}
+
+	std::optional<med::VolumeFile> file{};
+	try
+	{
+		file = med::DatImpl{}.ReadFile(std::filesystem::absolute(options.Volume), false);
+	}
+	catch (const std::exception&)
+	{
+		LOG_ERROR("Unable to read the volume");
+		return EXIT_FAILURE;
+	}
+	file->NormalizeData();
+	file->PreComputeGradient();
+	file->SetVoxelLayout(options.Layout);
+
+	// Light of BasicVolLightApp
+	const med::Light light
+	{
+		.Position = { 0.0, 5.0f, 0.0f, 1.0f },
+		.Ambient = glm::vec4{ 0.1f },
+		.Diffuse = glm::vec4{ 1.0f }
+	};
+
+	const auto& settings = options.Settings;
+	const glm::mat4 projection = glm::perspective(glm::radians(60.0f), static_cast<float>(settings.Width) / settings.Height, 0.01f, 100.0f);
+
+	const glm::mat4 inverseView = OrbitInverseView(options.Yaw, options.Pitch, options.Distance);
+
+	const med::CpuRayCaster caster(*file, preset.Opacity->Lut, preset.Color->Lut, light);
+	if (options.Benchmark > 0)
+	{
+		const auto result = med::CpuRenderBenchmark::Run(caster, inverseView, glm::inverse(projection), settings, options.Benchmark);
+		std::cout << "scalar " << result.ScalarMRays << " Mrays/s\n"
+			<< "packets " << result.PacketMRays << " Mrays/s (" << result.PacketMRays / result.ScalarMRays << "x)\n"
+			<< "max difference " << result.MaxDifference << "\n";
+	}
+	const auto image = caster.Render(inverseView, glm::inverse(projection), settings);
+
+	if (!med::ImageWriter::Write(options.Output, med::CpuRayCaster::Compose(image), settings.Width, settings.Height))
+	{
+		LOG_ERROR("Unable to write the image");
+		return EXIT_FAILURE;
+	}
+
+	std::string t = "Rendered " + options.Output.string();
+	LOG_INFO(t.c_str());
+	return EXIT_SUCCESS;
+}
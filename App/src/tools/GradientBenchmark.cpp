@@ -0,0 +1,188 @@
+#include "Base/Base.h"
+#include "Base/ThreadPool.h"
+#include "../file/dat/DatReader.h"
+#include "../file/GradientEngine.h"
+#include "../file/VolumeFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <vector>
+
+/*
+* Gradient engine timing of a .dat volume and correctness of the separable Sobel against the direct 27-tap kernel it replaced.
+*/
+
+namespace
+{
+	using namespace med;
+
+	struct Result
+	{
+		double CentralDifferenceMs = 0.0;
+		double SobelMs = 0.0;
+		// Direct 3x3x3 Sobel, 27 taps per voxel and gradient component
+		double ReferenceSobelMs = 0.0;
+		float MaxAbsDifference = 0.0f;
+		// Separable Sobel has to match the direct one up to float rounding
+		bool SobelMatches = false;
+	};
+
+	using Kernel = float[3][3][3];
+
+	// [z][y][x]
+	constexpr Kernel kSobelX = {
+		{ { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } },
+		{ { -2, 0, 2 }, { -4, 0, 4 }, { -2, 0, 2 } },
+		{ { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } }
+	};
+	constexpr Kernel kSobelY = {
+		{ { -1, -2, -1 }, { 0, 0, 0 }, { 1, 2, 1 } },
+		{ { -2, -4, -2 }, { 0, 0, 0 }, { 2, 4, 2 } },
+		{ { -1, -2, -1 }, { 0, 0, 0 }, { 1, 2, 1 } }
+	};
+	constexpr Kernel kSobelZ = {
+		{ { -1, -2, -1 }, { -2, -4, -2 }, { -1, -2, -1 } },
+		{ { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } },
+		{ { 1, 2, 1 }, { 2, 4, 2 }, { 1, 2, 1 } }
+	};
+
+	template<typename F>
+	double MeasureMs(F&& f)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/*
+	* Direct convolution with the 27-entry kernels, interior voxels only (as GradientEngine::Sobel).
+	*/
+	template<typename T>
+	void ReferenceSobel(std::span<const T> data, GradientEngine::Size size, float scale, std::span<glm::vec3> out)
+	{
+		const auto [xS, yS, zS] = size;
+		const std::size_t rowSize = xS;
+		const std::size_t sliceSize = rowSize * yS;
+
+		// Kernels pre-multiplied by the density scale
+		float wx[3][3][3], wy[3][3][3], wz[3][3][3];
+		for (int k = 0; k < 3; ++k)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					wx[k][j][i] = kSobelX[k][j][i] * scale;
+					wy[k][j][i] = kSobelY[k][j][i] * scale;
+					wz[k][j][i] = kSobelZ[k][j][i] * scale;
+				}
+			}
+		}
+
+		base::ThreadPool::Get().ParallelFor(1, zS - 1, [&](std::size_t z)
+		{
+			for (std::size_t y = 1; y + 1 < yS; ++y)
+			{
+				glm::vec3* dst = out.data() + z * sliceSize + y * rowSize;
+				for (std::size_t x = 1; x + 1 < rowSize; ++x)
+				{
+					float gx = 0.0f, gy = 0.0f, gz = 0.0f;
+					for (int k = 0; k < 3; ++k)
+					{
+						for (int j = 0; j < 3; ++j)
+						{
+							const T* row = data.data() + (z + k - 1) * sliceSize + (y + j - 1) * rowSize + x - 1;
+							for (int i = 0; i < 3; ++i)
+							{
+								const float v = static_cast<float>(row[i]);
+								gx += v * wx[k][j][i];
+								gy += v * wy[k][j][i];
+								gz += v * wz[k][j][i];
+							}
+						}
+					}
+					dst[x] = glm::vec3(gx, gy, gz);
+				}
+			}
+		});
+	}
+
+	/*
+	* Runs the kernels over the density of the file, its gradient is not touched.
+	*/
+	Result Run(const VolumeFile& file)
+	{
+		Result result;
+		const auto size = file.GetSize();
+		const auto [xS, yS, zS] = size;
+		const std::size_t voxelCount = static_cast<std::size_t>(xS) * yS * zS;
+		const VoxelBuffer& density = file.GetDensityBuffer();
+
+		std::vector<glm::vec3> gradient(voxelCount), reference(voxelCount);
+		result.CentralDifferenceMs = MeasureMs([&] { GradientEngine::CentralDifference(density, size, file.GetDensityScale(), gradient); });
+
+		// Borders are not written by either Sobel
+		std::ranges::fill(gradient, glm::vec3(0.0f));
+		result.SobelMs = MeasureMs([&] { GradientEngine::Sobel(density, size, file.GetDensityScale(), gradient); });
+		result.ReferenceSobelMs = MeasureMs([&]
+		{
+			density.Visit([&](auto data) { ReferenceSobel(data, size, file.GetDensityScale(), reference); });
+		});
+
+		// Sums are evaluated in another order, the difference is relative to the largest component
+		float maxComponent = 0.0f;
+		for (std::size_t i = 0; i < voxelCount; ++i)
+		{
+			const glm::vec3 d = glm::abs(gradient[i] - reference[i]);
+			const glm::vec3 r = glm::abs(reference[i]);
+			result.MaxAbsDifference = std::max({ result.MaxAbsDifference, d.x, d.y, d.z });
+			maxComponent = std::max({ maxComponent, r.x, r.y, r.z });
+		}
+		result.SobelMatches = result.MaxAbsDifference <= 1e-5f * std::max(maxComponent, 1.0f);
+
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	base::Log::Init();
+
+	if (argc != 2)
+	{
+		std::cerr << "Usage: GradientBenchmark <volume.dat>\n";
+		return EXIT_FAILURE;
+	}
+
+	std::optional<med::VolumeFile> file{};
+	try
+	{
+		file = med::DatImpl{}.ReadFile(std::filesystem::absolute(argv[1]), false);
+	}
+	catch (const std::exception&)
+	{
+		LOG_ERROR("Unable to read the volume");
+		return EXIT_FAILURE;
+	}
+	file->NormalizeData();
+
+	const auto [xS, yS, zS] = file->GetSize();
+	if (xS < 3 || yS < 3 || zS < 3 || file->GetDensityBuffer().GetChannels() != 1)
+	{
+		LOG_ERROR("Gradient benchmark needs single channel data of at least 3x3x3 voxels");
+		return EXIT_FAILURE;
+	}
+
+	const Result result = Run(*file);
+	std::cout << "volume " << xS << "x" << yS << "x" << zS << "\n"
+		<< "central difference " << result.CentralDifferenceMs << " ms\n"
+		<< "separable Sobel " << result.SobelMs << " ms / 27-tap Sobel " << result.ReferenceSobelMs << " ms\n"
+		<< "max abs difference " << result.MaxAbsDifference << (result.SobelMatches ? "" : " (MISMATCH)") << "\n";
+
+	return result.SobelMatches ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,182 @@
+#include "Base/Base.h"
+#include "../file/dat/DatReader.h"
+#include "../file/GradientEngine.h"
+#include "../file/VolumeFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+* Linear vs bricked layout (see VoxelLayout) on gradient computation and on sampling along random rays of a .dat volume.
+* Latency is measured with the clock, cache behaviour shows in it (hardware counters are not portable).
+*/
+
+namespace
+{
+	struct Result
+	{
+		double BrickingMs = 0.0;
+		double LinearGradientMs = 0.0;
+		double BrickedGradientMs = 0.0;
+		// Average latency of one trilinear sample along random rays
+		double LinearSampleNs = 0.0;
+		double BrickedSampleNs = 0.0;
+		// Both layouts have to give the same results
+		bool GradientsMatch = false;
+		bool SamplesMatch = false;
+	};
+
+	void PrintUsage()
+	{
+		std::cerr << "Usage: VoxelLayoutBenchmark <volume.dat> [options]\n"
+			"  --rays <n>           number of random rays sampled, 16384 by default\n";
+	}
+
+	template<typename F>
+	double MeasureMs(F&& f)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	/*
+	* Runs both layouts on single channel data, the file is left in the linear layout.
+	*/
+	Result Run(med::VolumeFile& file, std::size_t rayCount)
+	{
+		using namespace med;
+
+		Result result;
+		const auto [xS, yS, zS] = file.GetSize();
+		const std::size_t voxelCount = static_cast<std::size_t>(xS) * yS * zS;
+
+		file.SetVoxelLayout(VoxelLayout::Linear);
+		result.BrickingMs = MeasureMs([&] { file.SetVoxelLayout(VoxelLayout::Bricked); });
+
+		// Gradient, whole volume on the thread pool
+		std::vector<glm::vec3> linearGradient(voxelCount), brickedGradient(voxelCount);
+		result.LinearGradientMs = MeasureMs([&]
+		{
+			GradientEngine::CentralDifference(file.GetDensityBuffer(), file.GetSize(), file.GetDensityScale(), linearGradient);
+		});
+		result.BrickedGradientMs = MeasureMs([&]
+		{
+			GradientEngine::CentralDifference(file.GetBrickedDensity(), file.GetDensityScale(), brickedGradient);
+		});
+		result.GradientsMatch = linearGradient == brickedGradient;
+		linearGradient = {};
+		brickedGradient = {};
+
+		// Random rays through the unit cube, one sample per voxel along the ray, single thread to see the latency
+		const int steps = static_cast<int>(std::max({ xS, yS, zS }));
+		const float stepSize = 1.0f / static_cast<float>(steps);
+		std::mt19937 generator(7);
+		std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+		std::normal_distribution<float> normal(0.0f, 1.0f);
+		std::vector<glm::vec3> origins(rayCount), raySteps(rayCount);
+		for (std::size_t r = 0; r < rayCount; ++r)
+		{
+			origins[r] = glm::vec3(uniform(generator), uniform(generator), uniform(generator));
+			raySteps[r] = glm::normalize(glm::vec3(normal(generator), normal(generator), normal(generator))) * stepSize;
+		}
+
+		const auto march = [&]
+		{
+			double sum = 0.0;
+			for (std::size_t r = 0; r < rayCount; ++r)
+			{
+				glm::vec3 position = origins[r];
+				for (int i = 0; i < steps; ++i)
+				{
+					sum += file.SampleDensity(position);
+					position += raySteps[r];
+				}
+			}
+			return sum;
+		};
+
+		const double samples = static_cast<double>(rayCount) * steps;
+		double brickedSum = 0.0, linearSum = 0.0;
+		result.BrickedSampleNs = MeasureMs([&] { brickedSum = march(); }) * 1e6 / samples;
+		file.SetVoxelLayout(VoxelLayout::Linear);
+		result.LinearSampleNs = MeasureMs([&] { linearSum = march(); }) * 1e6 / samples;
+		// Clamped footprints interpolate equal corners, the layouts may differ in the last bits there
+		result.SamplesMatch = std::abs(brickedSum - linearSum) <= 1e-6 * std::max(std::abs(linearSum), 1.0);
+
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	base::Log::Init();
+
+	if (argc < 2)
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	std::size_t rayCount = 1 << 14;
+	try
+	{
+		for (int i = 2; i < argc; ++i)
+		{
+			const std::string_view arg = argv[i];
+			if (arg == "--rays" && i + 1 < argc)
+			{
+				rayCount = std::stoul(argv[++i]);
+			}
+			else
+			{
+				std::cerr << "Unknown or incomplete option " << arg << "\n";
+				PrintUsage();
+				return EXIT_FAILURE;
+			}
+		}
+	}
+	catch (const std::exception&)
+	{
+		PrintUsage();
+		return EXIT_FAILURE;
+	}
+
+	std::optional<med::VolumeFile> file{};
+	try
+	{
+		file = med::DatImpl{}.ReadFile(std::filesystem::absolute(argv[1]), false);
+	}
+	catch (const std::exception&)
+	{
+		LOG_ERROR("Unable to read the volume");
+		return EXIT_FAILURE;
+	}
+	file->NormalizeData();
+
+	const auto [xS, yS, zS] = file->GetSize();
+	if (static_cast<std::size_t>(xS) * yS * zS == 0 || file->GetDensityBuffer().GetChannels() != 1)
+	{
+		LOG_ERROR("Voxel layout benchmark needs single channel data");
+		return EXIT_FAILURE;
+	}
+
+	const Result result = Run(*file, rayCount);
+	std::cout << "volume " << xS << "x" << yS << "x" << zS << "\n"
+		<< "bricking " << result.BrickingMs << " ms\n"
+		<< "gradient linear " << result.LinearGradientMs << " ms / bricked " << result.BrickedGradientMs << " ms"
+		<< (result.GradientsMatch ? "" : " (MISMATCH)") << "\n"
+		<< "random ray sample linear " << result.LinearSampleNs << " ns / bricked " << result.BrickedSampleNs << " ns"
+		<< (result.SamplesMatch ? "" : " (MISMATCH)") << "\n";
+
+	return result.GradientsMatch && result.SamplesMatch ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,168 @@
+#include "TestUtils.h"
+#include "renderer/CpuRayCaster.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	using namespace med;
+
+	/*
+	* Nested spheres, densities 0.25 (shell) and 1 (core) after normalization. No gradient, so colors are not shaded
+	* and every sample adds at most its opacity to any channel.
+	*/
+	VolumeFile CreateSpheres()
+	{
+		constexpr int size = 32;
+		std::vector<std::uint16_t> voxels(size * size * size, 0);
+		for (int z = 0; z < size; ++z)
+		{
+			for (int y = 0; y < size; ++y)
+			{
+				for (int x = 0; x < size; ++x)
+				{
+					const float r = glm::length(glm::vec3(x, y, z) - glm::vec3(15.5f));
+					voxels[(z * size + y) * size + x] = r < 6.0f ? 4000 : r < 13.0f ? 1000 : 0;
+				}
+			}
+		}
+		VolumeFile file("spheres", { size, size, size }, VoxelBuffer(std::move(voxels)));
+		file.NormalizeData();
+		return file;
+	}
+
+	struct Tf
+	{
+		std::vector<float> Opacity = std::vector<float>(256, 0.0f);
+		std::vector<glm::vec4> Colors = std::vector<glm::vec4>(256, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+	};
+
+	/*
+	* Translucent shell and core, rays through the core reach 0.95 but not full opacity.
+	*/
+	Tf CreateTf()
+	{
+		Tf tf;
+		for (int i = 0; i < 256; ++i)
+		{
+			const float density = static_cast<float>(i) / 255.0f;
+			tf.Opacity[i] = density < 0.15f ? 0.0f : density < 0.6f ? 0.04f : 0.3f;
+			tf.Colors[i] = glm::vec4(density, 1.0f - density, 0.5f, 1.0f);
+		}
+		return tf;
+	}
+
+	std::vector<glm::vec4> Render(const CpuRayCaster& caster, float threshold, bool packets)
+	{
+		// Application camera looking at the cube from the front
+		const glm::mat4 inverseView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, 1.6f));
+		const glm::mat4 inverseProjection = glm::inverse(glm::perspective(glm::radians(60.0f), 1.0f, 0.01f, 100.0f));
+
+		CpuRenderSettings settings{};
+		settings.Width = 64;
+		settings.Height = 64;
+		settings.StepsCount = 400;
+		settings.StepSize = 1.0f / 64.0f;
+		settings.OpacityThreshold = threshold;
+		settings.Packets = packets;
+		return caster.Render(inverseView, inverseProjection, settings);
+	}
+
+	float MaxDifference(const std::vector<glm::vec4>& a, const std::vector<glm::vec4>& b)
+	{
+		float difference = 0.0f;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			const glm::vec4 d = glm::abs(a[i] - b[i]);
+			difference = std::max({ difference, d.x, d.y, d.z, d.w });
+		}
+		return difference;
+	}
+
+	void FullOpacityThreshold()
+	{
+		const VolumeFile file = CreateSpheres();
+		Tf tf = CreateTf();
+		// Opaque core, rays through it reach exactly 1
+		std::fill(tf.Opacity.begin() + 160, tf.Opacity.end(), 1.0f);
+		const CpuRayCaster caster(file, tf.Opacity, tf.Colors, Light{});
+
+		// Threshold 1 (BasicVolLightApp, ThreeFilesApp, VolumeMaskApp) gives the same image as marching every sample,
+		// fully opaque ray does not change any more
+		const auto terminated = Render(caster, 1.0f, false);
+		const auto full = Render(caster, 2.0f, false);
+		MED_CHECK(terminated == full);
+		MED_CHECK(std::ranges::any_of(full, [](const glm::vec4& p) { return p.a == 1.0f; }));
+	}
+
+	void ThresholdError()
+	{
+		const VolumeFile file = CreateSpheres();
+		const Tf tf = CreateTf();
+		const CpuRayCaster caster(file, tf.Opacity, tf.Colors, Light{});
+
+		const auto reference = Render(caster, 1.0f, false);
+		const auto terminated = Render(caster, 0.95f, false);
+
+		// Samples left out after the ray reached 0.95 could add at most the remaining 5% transparency
+		const float difference = MaxDifference(reference, terminated);
+		MED_CHECK(difference > 0.0f);
+		MED_CHECK(difference <= 0.05f + 1e-6f);
+
+		// Rays that stayed below the threshold are the same
+		size_t same = 0;
+		for (size_t i = 0; i < reference.size(); ++i)
+		{
+			if (reference[i].a < 0.95f)
+			{
+				same += reference[i] == terminated[i] ? 1 : 0;
+			}
+		}
+		const auto below = std::ranges::count_if(reference, [](const glm::vec4& p) { return p.a < 0.95f; });
+		MED_CHECK(below > 0 && same == static_cast<size_t>(below));
+	}
+
+	void PacketsMatchScalar()
+	{
+		const VolumeFile file = CreateSpheres();
+		const Tf tf = CreateTf();
+		const CpuRayCaster caster(file, tf.Opacity, tf.Colors, Light{});
+
+		// Lanes of a packet terminate independently, the result is the scalar one for any threshold
+		for (const float threshold : { 0.95f, 1.0f })
+		{
+			MED_CHECK(MaxDifference(Render(caster, threshold, true), Render(caster, threshold, false)) <= 1e-6f);
+		}
+	}
+
+	void BrickedLayout()
+	{
+		VolumeFile file = CreateSpheres();
+		const Tf tf = CreateTf();
+		const CpuRayCaster caster(file, tf.Opacity, tf.Colors, Light{});
+
+		const auto linearScalar = Render(caster, 0.95f, false);
+		const auto linearPackets = Render(caster, 0.95f, true);
+
+		// Layout is picked up on every Render, the bricked copy gives the same image
+		file.SetVoxelLayout(VoxelLayout::Bricked);
+		MED_CHECK(file.GetVoxelLayout() == VoxelLayout::Bricked);
+		MED_CHECK(MaxDifference(Render(caster, 0.95f, false), linearScalar) <= 1e-5f);
+		MED_CHECK(MaxDifference(Render(caster, 0.95f, true), linearPackets) <= 1e-5f);
+	}
+}
+
+int main()
+{
+	return med::test::RunTests({
+		{ "CpuRayCaster.FullOpacityThreshold", FullOpacityThreshold },
+		{ "CpuRayCaster.ThresholdError", ThresholdError },
+		{ "CpuRayCaster.PacketsMatchScalar", PacketsMatchScalar },
+		{ "CpuRayCaster.BrickedLayout", BrickedLayout },
+	});
+}
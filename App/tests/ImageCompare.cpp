@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+* Compares an image with its golden image (binary PPM, as written by ImageWriter::WritePPM).
+* Images match if no channel differs by more than 'tolerance' in more than 'maxBadPercent' % of the pixels, the CPU ray caster
+* is not bit exact across compilers (FMA contraction, vectorized math), rays grazing an edge may flip a few pixels.
+*/
+
+namespace
+{
+	struct Image
+	{
+		std::uint32_t Width = 0;
+		std::uint32_t Height = 0;
+		std::vector<std::uint8_t> Rgb{};
+	};
+
+	bool ReadPPM(const std::filesystem::path& path, Image& image)
+	{
+		std::ifstream file(path, std::ios::binary);
+		std::string magic;
+		int maxValue = 0;
+		file >> magic >> image.Width >> image.Height >> maxValue;
+		// Single whitespace separates the header from the pixels
+		file.get();
+
+		if (!file || magic != "P6" || maxValue != 255)
+		{
+			std::cerr << "Unable to read " << path.string() << "\n";
+			return false;
+		}
+
+		image.Rgb.resize(static_cast<std::size_t>(image.Width) * image.Height * 3);
+		file.read(reinterpret_cast<char*>(image.Rgb.data()), static_cast<std::streamsize>(image.Rgb.size()));
+		if (!file)
+		{
+			std::cerr << path.string() << " is truncated\n";
+			return false;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: ImageCompare <image.ppm> <golden.ppm> [tolerance = 2] [maxBadPercent = 0.5]\n";
+		return EXIT_FAILURE;
+	}
+
+	const int tolerance = argc > 3 ? std::stoi(argv[3]) : 2;
+	const double maxBadPercent = argc > 4 ? std::stod(argv[4]) : 0.5;
+
+	Image image, golden;
+	if (!ReadPPM(argv[1], image) || !ReadPPM(argv[2], golden))
+	{
+		return EXIT_FAILURE;
+	}
+
+	if (image.Width != golden.Width || image.Height != golden.Height)
+	{
+		std::cerr << "Size " << image.Width << "x" << image.Height << " differs from the golden " << golden.Width << "x" << golden.Height << "\n";
+		return EXIT_FAILURE;
+	}
+
+	std::size_t badPixels = 0;
+	int maxDifference = 0;
+	for (std::size_t i = 0; i < image.Rgb.size(); i += 3)
+	{
+		int difference = 0;
+		for (int c = 0; c < 3; ++c)
+		{
+			difference = std::max(difference, std::abs(image.Rgb[i + c] - golden.Rgb[i + c]));
+		}
+		maxDifference = std::max(maxDifference, difference);
+		badPixels += difference > tolerance ? 1 : 0;
+	}
+
+	const double badPercent = 100.0 * static_cast<double>(badPixels) / (static_cast<double>(image.Width) * image.Height);
+	std::cout << "Max channel difference " << maxDifference << ", " << badPixels << " pixel(s) (" << badPercent << " %) above " << tolerance << "\n";
+
+	return badPercent <= maxBadPercent ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,199 @@
+#include "TestUtils.h"
+#include "file/MinMaxBrickGrid.h"
+#include "file/OccupancyMap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace
+{
+	using namespace med;
+
+	VolumeFile CreateVolume(std::uint16_t xS, std::uint16_t yS, std::uint16_t zS, const std::function<std::uint16_t(int, int, int)>& value)
+	{
+		std::vector<std::uint16_t> voxels(static_cast<size_t>(xS) * yS * zS);
+		for (int z = 0; z < zS; ++z)
+		{
+			for (int y = 0; y < yS; ++y)
+			{
+				for (int x = 0; x < xS; ++x)
+				{
+					voxels[(static_cast<size_t>(z) * yS + y) * xS + x] = value(x, y, z);
+				}
+			}
+		}
+		return VolumeFile("test", { xS, yS, zS }, VoxelBuffer(std::move(voxels)));
+	}
+
+	/*
+	* Value grows along every axis, so the brick range is given by its first and last voxel (apron included).
+	*/
+	std::uint16_t Ramp(int x, int y, int z)
+	{
+		return static_cast<std::uint16_t>(x + 100 * y + 1000 * z);
+	}
+
+	void EdgeBricks()
+	{
+		// 8^3 bricks, none of the dimensions is a multiple of the brick size
+		const VolumeFile file = CreateVolume(10, 9, 17, Ramp);
+		const MinMaxBrickGrid grid(file);
+
+		MED_CHECK(grid.GetGridSize() == std::make_tuple<std::uint16_t, std::uint16_t, std::uint16_t>(2, 2, 3));
+		MED_CHECK(grid.GetBrickCount() == 12);
+
+		// Brick range spans [brick start - 1, brick end + 1) clamped to the volume
+		const auto first = [](int b) { return std::max(0, b * 8 - 1); };
+		const auto last = [](int b, int size) { return std::min(size - 1, (b + 1) * 8); };
+
+		for (int bz = 0; bz < 3; ++bz)
+		{
+			for (int by = 0; by < 2; ++by)
+			{
+				for (int bx = 0; bx < 2; ++bx)
+				{
+					const glm::vec2 range = grid.GetRange((static_cast<size_t>(bz) * 2 + by) * 2 + bx);
+					MED_CHECK(range.x == Ramp(first(bx), first(by), first(bz)));
+					MED_CHECK(range.y == Ramp(last(bx, 10), last(by, 9), last(bz, 17)));
+				}
+			}
+		}
+
+		// Last brick along z holds a single slice (z = 16) and the apron slice below it
+		const glm::vec2 corner = grid.GetRange(11);
+		MED_CHECK(corner.x == Ramp(7, 7, 15));
+		MED_CHECK(corner.y == Ramp(9, 8, 16));
+	}
+
+	void Apron()
+	{
+		// Two bricks along x, single non-zero voxel at the border of the second brick
+		const VolumeFile border = CreateVolume(16, 8, 8, [](int x, int y, int z) { return x == 8 && y == 3 && z == 3 ? 1000 : 0; });
+		const MinMaxBrickGrid borderGrid(border);
+		MED_CHECK(borderGrid.GetBrickCount() == 2);
+		// Samples between x = 7 and x = 8 blend the voxel in, so it bounds the first brick as well
+		MED_CHECK(borderGrid.GetRange(0) == glm::vec2(0.0f, 1000.0f));
+		MED_CHECK(borderGrid.GetRange(1) == glm::vec2(0.0f, 1000.0f));
+
+		// One voxel further is out of reach of the first brick
+		const VolumeFile inside = CreateVolume(16, 8, 8, [](int x, int y, int z) { return x == 9 && y == 3 && z == 3 ? 1000 : 0; });
+		const MinMaxBrickGrid insideGrid(inside);
+		MED_CHECK(insideGrid.GetRange(0) == glm::vec2(0.0f, 0.0f));
+		MED_CHECK(insideGrid.GetRange(1) == glm::vec2(0.0f, 1000.0f));
+
+		// Last voxel of the first brick is the apron of the second one
+		const VolumeFile last = CreateVolume(16, 8, 8, [](int x, int y, int z) { return x == 7 && y == 0 && z == 7 ? 1000 : 0; });
+		MED_CHECK(MinMaxBrickGrid(last).GetRange(1) == glm::vec2(0.0f, 1000.0f));
+	}
+
+	void NormalizedRanges()
+	{
+		VolumeFile file = CreateVolume(8, 8, 8, [](int x, int, int) { return static_cast<std::uint16_t>(x * 100); });
+		file.NormalizeData(1400);
+
+		const MinMaxBrickGrid grid(file);
+		MED_CHECK(grid.GetBrickCount() == 1);
+		MED_CHECK(grid.GetRange(0).x == 0.0f);
+		MED_CHECK(std::abs(grid.GetRange(0).y - 0.5f) < 1e-6f);
+	}
+
+	void TexelRange()
+	{
+		MED_CHECK(MinMaxBrickGrid::GetTexelRange({ 0.0f, 0.0f }, 256) == std::make_pair<size_t, size_t>(0, 0));
+		MED_CHECK(MinMaxBrickGrid::GetTexelRange({ 1.0f, 1.0f }, 256) == std::make_pair<size_t, size_t>(255, 255));
+		// Sample between two texel centers blends both
+		MED_CHECK(MinMaxBrickGrid::GetTexelRange({ 0.5f, 0.5f }, 256) == std::make_pair<size_t, size_t>(127, 128));
+		// Exactly at the texel center
+		MED_CHECK(MinMaxBrickGrid::GetTexelRange({ 10.5f / 256.0f, 10.5f / 256.0f }, 256) == std::make_pair<size_t, size_t>(10, 10));
+		// Out of range densities are clamped like the sampler does
+		MED_CHECK(MinMaxBrickGrid::GetTexelRange({ -1.0f, 2.0f }, 16) == std::make_pair<size_t, size_t>(0, 15));
+	}
+
+	/*
+	* Densities 0 (background) and 1 in a sphere, normalized.
+	*/
+	VolumeFile CreateSphere()
+	{
+		VolumeFile file = CreateVolume(37, 29, 21, [](int x, int y, int z)
+		{
+			const int dx = x - 18, dy = y - 14, dz = z - 10;
+			return static_cast<std::uint16_t>(dx * dx + dy * dy + dz * dz < 64 ? 1000 : 0);
+		});
+		file.NormalizeData();
+		return file;
+	}
+
+	void TransparentTf()
+	{
+		OccupancyMap map{ MinMaxBrickGrid(CreateSphere()) };
+		map.Classify(std::vector<float>(256, 0.0f));
+		MED_CHECK(std::ranges::all_of(map.GetOccupancy(), [](std::uint8_t v) { return v == 0; }));
+
+		// Making everything opaque and transparent again through incremental updates
+		std::vector<float> opacity(256, 1.0f);
+		MED_CHECK(map.Update(opacity, { 0, 255 }));
+		std::ranges::fill(opacity, 0.0f);
+		MED_CHECK(map.Update(opacity, { 0, 255 }));
+		MED_CHECK(std::ranges::all_of(map.GetOccupancy(), [](std::uint8_t v) { return v == 0; }));
+	}
+
+	void OpaqueTf()
+	{
+		OccupancyMap map{ MinMaxBrickGrid(CreateSphere()) };
+		MED_CHECK(map.GetOccupancy().size() == 5 * 4 * 3);
+
+		map.Classify(std::vector<float>(256, 1.0f));
+		// Background bricks included, density 0 is opaque too
+		MED_CHECK(std::ranges::all_of(map.GetOccupancy(), [](std::uint8_t v) { return v == 255; }));
+	}
+
+	void PartialTf()
+	{
+		const MinMaxBrickGrid grid(CreateSphere());
+		OccupancyMap map{ grid };
+
+		// Only the sphere (density 1) is visible
+		std::vector<float> opacity(256, 0.0f);
+		opacity[255] = 0.5f;
+		map.Classify(opacity);
+
+		const auto& occupancy = map.GetOccupancy();
+		size_t visible = 0;
+		for (size_t brick = 0; brick < grid.GetBrickCount(); ++brick)
+		{
+			const bool hasSphere = grid.GetRange(brick).y > 0.99f;
+			MED_CHECK((occupancy[brick] == 255) == hasSphere);
+			visible += hasSphere ? 1 : 0;
+		}
+		MED_CHECK(visible > 0 && visible < grid.GetBrickCount());
+
+		// Incremental update agrees with the full classification
+		opacity[255] = 0.0f;
+		opacity[0] = 0.2f;
+		MED_CHECK(map.Update(opacity, { 0, 255 }));
+
+		OccupancyMap reference{ grid };
+		reference.Classify(opacity);
+		MED_CHECK(map.GetOccupancy() == reference.GetOccupancy());
+
+		// Sphere bricks stay visible and background bricks do not reach the edited texel
+		opacity[128] = 1.0f;
+		MED_CHECK(!map.Update(opacity, { 128, 128 }));
+	}
+}
+
+int main()
+{
+	return med::test::RunTests({
+		{ "MinMaxBrickGrid.EdgeBricks", EdgeBricks },
+		{ "MinMaxBrickGrid.Apron", Apron },
+		{ "MinMaxBrickGrid.NormalizedRanges", NormalizedRanges },
+		{ "MinMaxBrickGrid.TexelRange", TexelRange },
+		{ "OccupancyMap.TransparentTf", TransparentTf },
+		{ "OccupancyMap.OpaqueTf", OpaqueTf },
+		{ "OccupancyMap.PartialTf", PartialTf },
+	});
+}
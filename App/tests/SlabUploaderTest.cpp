@@ -0,0 +1,191 @@
+#include "TestUtils.h"
+#include "renderer/SlabUploader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using namespace med;
+
+	// Every byte of a slice holds its z (mod 256), so the written data show which slices they came from
+	void FillSlices(std::size_t sliceBytes, std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst)
+	{
+		for (std::uint32_t z = 0; z < depth; ++z)
+		{
+			std::fill_n(dst.begin() + z * sliceBytes, sliceBytes, static_cast<std::byte>((zBegin + z) & 0xff));
+		}
+	}
+
+	void SlabSplitting()
+	{
+		// 507 bytes hold 5 slices of 100 bytes, 53 slices are 10 full slabs and one of 3 slices
+		const SlabUploader uploader(100, 53, 507, 3);
+		MED_CHECK(uploader.GetSlabDepth() == 5);
+		MED_CHECK(uploader.GetSlabCount() == 11);
+
+		// Slab has at least one slice even if the slice does not fit into the slab size
+		MED_CHECK(SlabUploader(100, 7, 10).GetSlabDepth() == 1);
+		MED_CHECK(SlabUploader(100, 7, 10).GetSlabCount() == 7);
+		// ... and at most the whole volume
+		MED_CHECK(SlabUploader(100, 7, 1 << 20).GetSlabDepth() == 7);
+		MED_CHECK(SlabUploader(100, 7, 1 << 20).GetSlabCount() == 1);
+		MED_CHECK(SlabUploader(100, 0, 1 << 20).GetSlabCount() == 0);
+
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> slabs;
+		std::vector<std::byte> volume(100 * 53);
+		const auto caller = std::this_thread::get_id();
+		bool sameThread = true;
+
+		uploader.Run([](std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst)
+		{
+			FillSlices(100, zBegin, depth, dst);
+		},
+		[&](std::uint32_t zBegin, std::uint32_t depth, std::span<const std::byte> src)
+		{
+			sameThread &= std::this_thread::get_id() == caller;
+			slabs.emplace_back(zBegin, depth);
+			MED_CHECK(src.size() == depth * 100);
+			std::copy(src.begin(), src.end(), volume.begin() + zBegin * 100);
+		});
+
+		// Written in z order, one after another, last slab is the remainder
+		MED_CHECK(sameThread);
+		MED_CHECK(slabs.size() == 11);
+		for (std::size_t i = 0; i < slabs.size(); ++i)
+		{
+			MED_CHECK(slabs[i].first == i * 5);
+			MED_CHECK(slabs[i].second == (i + 1 < slabs.size() ? 5u : 3u));
+		}
+
+		bool matches = true;
+		for (std::size_t i = 0; i < volume.size(); ++i)
+		{
+			matches &= volume[i] == static_cast<std::byte>(i / 100);
+		}
+		MED_CHECK(matches);
+
+		// Empty volume writes nothing
+		int writes = 0;
+		SlabUploader(100, 0).Run([](auto, auto, auto) {}, [&](auto, auto, auto) { ++writes; });
+		MED_CHECK(writes == 0);
+	}
+
+	void RingWrapAround()
+	{
+		constexpr std::uint32_t ringSize = 2;
+		const SlabUploader uploader(64, 20, 3 * 64, ringSize);
+		MED_CHECK(uploader.GetSlabCount() == 7);
+
+		std::mutex mutex;
+		std::uint32_t filled = 0;
+		std::uint32_t written = 0;
+		std::uint32_t maxInFlight = 0;
+		std::vector<const std::byte*> fillBuffers(uploader.GetSlabCount(), nullptr);
+		std::vector<const std::byte*> writeBuffers(uploader.GetSlabCount(), nullptr);
+
+		uploader.Run([&](std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst)
+		{
+			// Give the writes a chance to fall behind
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			FillSlices(64, zBegin, depth, dst);
+
+			const std::scoped_lock lock(mutex);
+			fillBuffers[zBegin / 3] = dst.data();
+			maxInFlight = std::max(maxInFlight, ++filled - written);
+		},
+		[&](std::uint32_t zBegin, std::uint32_t depth, std::span<const std::byte> src)
+		{
+			const std::scoped_lock lock(mutex);
+			writeBuffers[zBegin / 3] = src.data();
+			++written;
+
+			bool matches = true;
+			for (std::uint32_t z = 0; z < depth; ++z)
+			{
+				matches &= src[z * 64] == static_cast<std::byte>(zBegin + z) && src[z * 64 + 63] == static_cast<std::byte>(zBegin + z);
+			}
+			MED_CHECK(matches);
+		});
+
+		// Never more slabs are filled than there are staging buffers, buffers are reused round robin
+		MED_CHECK(maxInFlight <= ringSize);
+		MED_CHECK(fillBuffers == writeBuffers);
+		MED_CHECK(std::set<const std::byte*>(fillBuffers.begin(), fillBuffers.end()).size() == ringSize);
+		for (std::size_t slab = ringSize; slab < fillBuffers.size(); ++slab)
+		{
+			MED_CHECK(fillBuffers[slab] == fillBuffers[slab - ringSize]);
+		}
+
+		// Ring larger than the number of slabs
+		int writes = 0;
+		SlabUploader(64, 2, 64, 8).Run([](auto, auto, auto) {}, [&](auto, auto, auto) { ++writes; });
+		MED_CHECK(writes == 2);
+	}
+
+	void Progress()
+	{
+		const SlabUploader uploader(10, 9, 20);
+		MED_CHECK(uploader.GetSlabCount() == 5);
+
+		std::vector<float> progress;
+		int writes = 0;
+		uploader.Run([](auto, auto, auto) {}, [&](auto, auto, auto) { ++writes; },
+			[&](float value)
+		{
+			// Reported after the slab has been written
+			MED_CHECK(static_cast<int>(progress.size()) + 1 == writes);
+			progress.push_back(value);
+		});
+
+		MED_CHECK(progress.size() == 5);
+		for (std::size_t i = 0; i < progress.size(); ++i)
+		{
+			MED_CHECK(progress[i] == static_cast<float>(i + 1) / 5.0f);
+		}
+		MED_CHECK(!progress.empty() && progress.back() == 1.0f);
+	}
+
+	void FillError()
+	{
+		const SlabUploader uploader(16, 10, 16, 3);
+		int writes = 0;
+		bool thrown = false;
+		try
+		{
+			uploader.Run([](std::uint32_t zBegin, auto, auto)
+			{
+				if (zBegin == 4)
+				{
+					throw std::runtime_error("Fill failed");
+				}
+			},
+			[&](auto, auto, auto) { ++writes; });
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+
+		// Slabs before the failed one are written, none after it
+		MED_CHECK(thrown);
+		MED_CHECK(writes == 4);
+	}
+}
+
+int main()
+{
+	return med::test::RunTests({
+		{ "SlabUploader.SlabSplitting", SlabSplitting },
+		{ "SlabUploader.RingWrapAround", RingWrapAround },
+		{ "SlabUploader.Progress", Progress },
+		{ "SlabUploader.FillError", FillError },
+	});
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Base/Log.h"
+
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+
+/*
+* Minimal test harness, no framework dependency. MED_CHECK records a failure and the test continues,
+* RunTests runs the named tests and returns the exit code ctest expects.
+*/
+
+namespace med::test
+{
+	inline int& FailureCount()
+	{
+		static int count = 0;
+		return count;
+	}
+
+	inline void Check(bool condition, const char* expression, const char* file, int line)
+	{
+		if (!condition)
+		{
+			++FailureCount();
+			std::cerr << file << "(" << line << "): check failed: " << expression << "\n";
+		}
+	}
+
+	struct TestCase
+	{
+		const char* Name = nullptr;
+		void (*Function)() = nullptr;
+	};
+
+	inline int RunTests(std::initializer_list<TestCase> tests)
+	{
+		// Library code logs through base::Log
+		base::Log::Init();
+
+		for (const auto& test : tests)
+		{
+			const int failures = FailureCount();
+			test.Function();
+			std::cout << (FailureCount() == failures ? "[  OK  ] " : "[ FAIL ] ") << test.Name << "\n";
+		}
+		return FailureCount() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
+
+// Variadic, conditions may contain commas (template arguments)
+#define MED_CHECK(...) ::med::test::Check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
@@ -0,0 +1,197 @@
+#include "TestUtils.h"
+#include "file/TexelPacking.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+	using namespace med;
+
+	void HalfRoundTrip()
+	{
+		// Every half value survives the conversion to float and back, NaNs stay NaNs
+		int mismatches = 0;
+		for (std::uint32_t bits = 0; bits <= 0xffffu; ++bits)
+		{
+			const auto half = static_cast<std::uint16_t>(bits);
+			const float value = TexelPacking::HalfToFloat(half);
+			if (std::isnan(value))
+			{
+				mismatches += std::isnan(TexelPacking::HalfToFloat(TexelPacking::FloatToHalf(value))) ? 0 : 1;
+				continue;
+			}
+			mismatches += TexelPacking::FloatToHalf(value) == half ? 0 : 1;
+		}
+		MED_CHECK(mismatches == 0);
+	}
+
+	void HalfRounding()
+	{
+		MED_CHECK(TexelPacking::FloatToHalf(1.0f) == 0x3c00);
+		// Half way between 1 and the next half rounds to even (1), 1.5 ulp rounds up to the even 2 ulp
+		MED_CHECK(TexelPacking::FloatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3c00);
+		MED_CHECK(TexelPacking::FloatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 0x3c02);
+		MED_CHECK(TexelPacking::FloatToHalf(65504.0f) == 0x7bff);
+		MED_CHECK(TexelPacking::FloatToHalf(65520.0f) == 0x7c00);
+		MED_CHECK(TexelPacking::FloatToHalf(-65520.0f) == 0xfc00);
+		// Smallest subnormal and half of it (ties to even, 0)
+		MED_CHECK(TexelPacking::FloatToHalf(std::ldexp(1.0f, -24)) == 0x0001);
+		MED_CHECK(TexelPacking::FloatToHalf(std::ldexp(1.0f, -25)) == 0x0000);
+		MED_CHECK(TexelPacking::FloatToHalf(-0.0f) == 0x8000);
+	}
+
+	/*
+	* Packs every level k / (2^bits - 1) and checks that the unpacked value is still closest to its own level.
+	*/
+	bool KeepsLevels(DensityTexelFormat format, int bits)
+	{
+		const int levels = (1 << bits) - 1;
+		std::array<std::byte, 4> texel{};
+		for (int k = 0; k <= levels; ++k)
+		{
+			const float level = static_cast<float>(k) / static_cast<float>(levels);
+			TexelPacking::PackDensity(format, level, texel.data());
+			const float unpacked = TexelPacking::UnpackDensity(format, texel.data());
+			if (std::lround(unpacked * static_cast<float>(levels)) != k)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void DensityFormats()
+	{
+		MED_CHECK(TexelPacking::ChooseDensityFormat(false, 8, true) == DensityTexelFormat::R32Float);
+		MED_CHECK(TexelPacking::ChooseDensityFormat(true, 8, true) == DensityTexelFormat::R8Unorm);
+		MED_CHECK(TexelPacking::ChooseDensityFormat(true, 11, true) == DensityTexelFormat::R16Float);
+		MED_CHECK(TexelPacking::ChooseDensityFormat(true, 12, true) == DensityTexelFormat::R32Float);
+		MED_CHECK(TexelPacking::ChooseDensityFormat(true, 32, false) == DensityTexelFormat::R16Float);
+
+		MED_CHECK(TexelPacking::GetBytesPerTexel(DensityTexelFormat::R8Unorm) == 1);
+		MED_CHECK(TexelPacking::GetBytesPerTexel(DensityTexelFormat::R16Float) == 2);
+		MED_CHECK(TexelPacking::GetBytesPerTexel(DensityTexelFormat::R32Float) == 4);
+	}
+
+	void DensityRoundTrip()
+	{
+		// Every bit depth is stored without merging levels in the format ChooseDensityFormat picks for it
+		for (int bits = 1; bits <= 12; ++bits)
+		{
+			MED_CHECK(KeepsLevels(TexelPacking::ChooseDensityFormat(true, bits, true), bits));
+		}
+		MED_CHECK(KeepsLevels(DensityTexelFormat::R16Float, 11));
+		// Half float is not enough for 12 bits, this is why it falls back to 32 bit float
+		MED_CHECK(!KeepsLevels(DensityTexelFormat::R16Float, 12));
+
+		std::array<std::byte, 4> texel{};
+		TexelPacking::PackDensity(DensityTexelFormat::R8Unorm, 2.0f, texel.data());
+		MED_CHECK(TexelPacking::UnpackDensity(DensityTexelFormat::R8Unorm, texel.data()) == 1.0f);
+		TexelPacking::PackDensity(DensityTexelFormat::R32Float, 1234.5f, texel.data());
+		MED_CHECK(TexelPacking::UnpackDensity(DensityTexelFormat::R32Float, texel.data()) == 1234.5f);
+	}
+
+	/*
+	* Directions evenly spread over the sphere (Fibonacci lattice) and the axes and diagonals, where the octahedral folding has its seams.
+	*/
+	std::vector<glm::vec3> Directions()
+	{
+		std::vector<glm::vec3> directions;
+		constexpr int count = 4096;
+		const float golden = 3.14159265f * (3.0f - std::sqrt(5.0f));
+		for (int i = 0; i < count; ++i)
+		{
+			const float z = 1.0f - 2.0f * (static_cast<float>(i) + 0.5f) / count;
+			const float r = std::sqrt(1.0f - z * z);
+			directions.emplace_back(r * std::cos(golden * i), r * std::sin(golden * i), z);
+		}
+		for (int x = -1; x <= 1; ++x)
+		{
+			for (int y = -1; y <= 1; ++y)
+			{
+				for (int z = -1; z <= 1; ++z)
+				{
+					if (x != 0 || y != 0 || z != 0)
+					{
+						directions.push_back(glm::normalize(glm::vec3(x, y, z)));
+					}
+				}
+			}
+		}
+		return directions;
+	}
+
+	void OctahedralRoundTrip()
+	{
+		float maxError = 0.0f;
+		for (const glm::vec3& direction : Directions())
+		{
+			const glm::vec2 encoded = TexelPacking::EncodeOctahedral(direction);
+			MED_CHECK(std::abs(encoded.x) <= 1.0f && std::abs(encoded.y) <= 1.0f);
+			maxError = std::max(maxError, glm::length(TexelPacking::DecodeOctahedral(encoded) - direction));
+		}
+		MED_CHECK(maxError < 1e-5f);
+		MED_CHECK(TexelPacking::EncodeOctahedral(glm::vec3(0.0f)) == glm::vec2(0.0f));
+	}
+
+	void GradientRoundTrip()
+	{
+		constexpr float maxMagnitude = 4.0f;
+		std::array<std::byte, TexelPacking::kGradientTexelBytes> texel{};
+
+		// Snorm8 direction (two components) and magnitude
+		float maxAngle = 0.0f;
+		float maxMagnitudeError = 0.0f;
+		int i = 0;
+		for (const glm::vec3& direction : Directions())
+		{
+			const float magnitude = maxMagnitude * static_cast<float>(1 + i++ % 100) / 100.0f;
+			TexelPacking::PackGradient(direction * magnitude, 1.0f / maxMagnitude, texel.data());
+			MED_CHECK(static_cast<std::int8_t>(texel[3]) == 0);
+
+			const glm::vec3 unpacked = TexelPacking::UnpackGradient(texel.data(), maxMagnitude);
+			const float cosine = glm::dot(glm::normalize(unpacked), direction);
+			maxAngle = std::max(maxAngle, std::acos(std::min(cosine, 1.0f)));
+			maxMagnitudeError = std::max(maxMagnitudeError, std::abs(glm::length(unpacked) - magnitude));
+		}
+		// Octahedral cell of 2 / 254 is below one degree over the whole sphere
+		MED_CHECK(maxAngle < 3.14159265f / 180.0f);
+		MED_CHECK(maxMagnitudeError <= maxMagnitude * 0.5f / 127.0f + 1e-5f);
+
+		// Zero gradient (homogeneous region) is an all zero texel
+		TexelPacking::PackGradient(glm::vec3(0.0f), 1.0f / maxMagnitude, texel.data());
+		MED_CHECK(texel == std::array<std::byte, TexelPacking::kGradientTexelBytes>{});
+		MED_CHECK(glm::length(TexelPacking::UnpackGradient(texel.data(), maxMagnitude)) == 0.0f);
+	}
+
+	void Snorm8()
+	{
+		MED_CHECK(TexelPacking::FloatToSnorm8(1.0f) == 127);
+		MED_CHECK(TexelPacking::FloatToSnorm8(-1.0f) == -127);
+		MED_CHECK(TexelPacking::FloatToSnorm8(5.0f) == 127);
+		// -128 decodes to -1 as on the GPU
+		MED_CHECK(TexelPacking::Snorm8ToFloat(-128) == -1.0f);
+		for (int v = -127; v <= 127; ++v)
+		{
+			MED_CHECK(TexelPacking::FloatToSnorm8(TexelPacking::Snorm8ToFloat(static_cast<std::int8_t>(v))) == v);
+		}
+	}
+}
+
+int main()
+{
+	return med::test::RunTests({
+		{ "TexelPacking.HalfRoundTrip", HalfRoundTrip },
+		{ "TexelPacking.HalfRounding", HalfRounding },
+		{ "TexelPacking.DensityFormats", DensityFormats },
+		{ "TexelPacking.DensityRoundTrip", DensityRoundTrip },
+		{ "TexelPacking.OctahedralRoundTrip", OctahedralRoundTrip },
+		{ "TexelPacking.GradientRoundTrip", GradientRoundTrip },
+		{ "TexelPacking.Snorm8", Snorm8 },
+	});
+}
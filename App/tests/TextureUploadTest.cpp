@@ -0,0 +1,260 @@
+#include "TestUtils.h"
+#include "renderer/Texture.h"
+#include "renderer/VolumeTexture.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	using namespace med;
+
+	/*
+	* One call of the queue writer, data are copied as the queue does.
+	*/
+	struct Write
+	{
+		WGPUOrigin3D Origin{};
+		WGPUExtent3D Extent{};
+		std::uint32_t BytesPerRow = 0;
+		std::uint32_t RowsPerImage = 0;
+		std::vector<std::byte> Data{};
+	};
+
+	std::vector<Write>& Writes()
+	{
+		static std::vector<Write> writes;
+		return writes;
+	}
+
+	void MockQueueWriter(WGPUQueue, const WGPUImageCopyTexture* destination, const void* data, size_t dataSize,
+		const WGPUTextureDataLayout* layout, const WGPUExtent3D* extent)
+	{
+		const auto* bytes = static_cast<const std::byte*>(data);
+		Writes().push_back({ destination->origin, *extent, layout->bytesPerRow, layout->rowsPerImage, { bytes, bytes + dataSize } });
+	}
+
+	std::size_t WrittenBytes()
+	{
+		std::size_t bytes = 0;
+		for (const Write& write : Writes())
+		{
+			bytes += write.Data.size();
+		}
+		return bytes;
+	}
+
+	/*
+	* Texture with fake handles, nothing but the queue writer is called. The destructor would release the handles,
+	* so the texture is never destroyed (kept reachable from a static list).
+	*/
+	Texture& CreateTexture(WGPUTextureDimension dimension, std::uint32_t x, std::uint32_t y, std::uint32_t z, std::uint32_t bytesPerTexel)
+	{
+		static auto& textures = *new std::vector<Texture*>();
+		WGPUTextureDescriptor texDesc{};
+		texDesc.dimension = dimension;
+		texDesc.size = { x, y, z };
+
+		WGPUTextureDataLayout layout{};
+		layout.bytesPerRow = bytesPerTexel * x;
+		layout.rowsPerImage = y;
+
+		return *textures.emplace_back(new Texture(reinterpret_cast<WGPUTexture>(1), reinterpret_cast<WGPUTextureView>(1), texDesc, {}, layout, {}, "Mock"));
+	}
+
+	/*
+	* Replays the recorded writes into a tightly packed copy of the texture.
+	*/
+	void Apply(std::span<std::byte> texture, std::uint32_t x, std::uint32_t y, std::uint32_t bytesPerTexel)
+	{
+		for (const Write& write : Writes())
+		{
+			for (std::uint32_t dz = 0; dz < write.Extent.depthOrArrayLayers; ++dz)
+			{
+				for (std::uint32_t dy = 0; dy < write.Extent.height; ++dy)
+				{
+					const std::size_t src = (static_cast<std::size_t>(dz) * write.RowsPerImage + dy) * write.BytesPerRow;
+					const std::size_t dst = ((static_cast<std::size_t>(write.Origin.z + dz) * y + write.Origin.y + dy) * x + write.Origin.x) * bytesPerTexel;
+					std::memcpy(texture.data() + dst, write.Data.data() + src, write.BytesPerRow);
+				}
+			}
+		}
+	}
+
+	void UpdateRegion()
+	{
+		Texture& texture = CreateTexture(WGPUTextureDimension_3D, 16, 8, 4, 2);
+		std::vector<std::byte> data(2 * 5 * 2 * 2);
+		for (std::size_t i = 0; i < data.size(); ++i)
+		{
+			data[i] = static_cast<std::byte>(i);
+		}
+
+		Writes().clear();
+		texture.UpdateRegion(nullptr, { 2, 3, 1 }, { 5, 2, 2 }, data);
+
+		// Rows of the region are tightly packed, only the bytes of the box are sent
+		MED_CHECK(Writes().size() == 1);
+		const Write& write = Writes().front();
+		MED_CHECK(write.Origin.x == 2 && write.Origin.y == 3 && write.Origin.z == 1);
+		MED_CHECK(write.Extent.width == 5 && write.Extent.height == 2 && write.Extent.depthOrArrayLayers == 2);
+		MED_CHECK(write.BytesPerRow == 10 && write.RowsPerImage == 2);
+		MED_CHECK(write.Data == data);
+
+		// Whole texture
+		std::vector<std::byte> whole(16 * 8 * 4 * 2);
+		Writes().clear();
+		texture.UpdateTexture(nullptr, whole.data());
+		MED_CHECK(Writes().size() == 1 && WrittenBytes() == whole.size());
+		MED_CHECK(Writes().front().BytesPerRow == 32 && Writes().front().RowsPerImage == 8);
+	}
+
+	void UpdateTexels()
+	{
+		Texture& texture = CreateTexture(WGPUTextureDimension_1D, 256, 1, 1, sizeof(float));
+		std::vector<float> texels(256, 0.5f);
+
+		Writes().clear();
+		texture.UpdateTexels(nullptr, 10, 20, texels.data() + 10);
+
+		// Only the edited part of the TF
+		MED_CHECK(Writes().size() == 1);
+		MED_CHECK(Writes().front().Origin.x == 10 && Writes().front().Extent.width == 20);
+		MED_CHECK(WrittenBytes() == 20 * sizeof(float));
+	}
+
+	void UploadSlices()
+	{
+		constexpr std::uint32_t x = 8, y = 4, z = 20;
+		Texture& texture = CreateTexture(WGPUTextureDimension_3D, x, y, z, 1);
+
+		Writes().clear();
+		// Three slices per slab
+		texture.UploadSlices(nullptr, 5, 9, [](std::uint32_t zBegin, std::uint32_t depth, std::span<std::byte> dst)
+		{
+			for (std::uint32_t slice = 0; slice < depth; ++slice)
+			{
+				std::fill_n(dst.begin() + slice * x * y, x * y, static_cast<std::byte>(zBegin + slice));
+			}
+		}, 3 * x * y);
+
+		MED_CHECK(Writes().size() == 3);
+		MED_CHECK(WrittenBytes() == 9 * x * y);
+		for (std::size_t i = 0; i < Writes().size(); ++i)
+		{
+			MED_CHECK(Writes()[i].Origin.z == 5 + 3 * i && Writes()[i].Extent.depthOrArrayLayers == 3);
+		}
+
+		// Written slices hold their own index, the others are untouched
+		std::vector<std::byte> shadow(x * y * z, std::byte{ 0xff });
+		Apply(shadow, x, y, 1);
+		bool matches = true;
+		for (std::uint32_t slice = 0; slice < z; ++slice)
+		{
+			const auto expected = slice >= 5 && slice < 14 ? static_cast<std::byte>(slice) : std::byte{ 0xff };
+			matches &= std::all_of(shadow.begin() + slice * x * y, shadow.begin() + (slice + 1) * x * y, [&](std::byte b) { return b == expected; });
+		}
+		MED_CHECK(matches);
+	}
+
+	void UpdateDensityAndMask()
+	{
+		std::vector<std::uint16_t> voxels(8 * 8 * 6, 100);
+		const VolumeFile file("test", { 8, 8, 6 }, VoxelBuffer(std::move(voxels)));
+		const std::uint32_t densityBytes = TexelPacking::GetBytesPerTexel(file.GetDensityTexelFormat());
+		Texture& density = CreateTexture(WGPUTextureDimension_3D, 8, 8, 6, densityBytes);
+
+		Writes().clear();
+		VolumeTexture::UpdateDensity(nullptr, density, file, 2, 3);
+		MED_CHECK(WrittenBytes() == 8 * 8 * 3 * densityBytes);
+		MED_CHECK(!Writes().empty() && Writes().front().Origin.z == 2);
+
+		const MaskVolume mask({ 8, 8, 6 }, 3);
+		Texture& labels = CreateTexture(WGPUTextureDimension_3D, 8, 8, 6, 1);
+
+		Writes().clear();
+		VolumeTexture::UpdateMask(nullptr, labels, mask, 0, 5, 1);
+		MED_CHECK(WrittenBytes() == 8 * 8);
+		MED_CHECK(!Writes().empty() && Writes().front().Origin.z == 5);
+	}
+
+	/*
+	* 4^3 bricks, only brick (1, 2, 3) holds density 1 (away from its borders, so no apron of the neighbours reaches it).
+	*/
+	OccupancyMap CreateOccupancy()
+	{
+		std::vector<std::uint16_t> voxels(32 * 32 * 32, 0);
+		for (int z = 26; z < 30; ++z)
+		{
+			for (int y = 18; y < 22; ++y)
+			{
+				for (int x = 10; x < 14; ++x)
+				{
+					voxels[(z * 32 + y) * 32 + x] = 1000;
+				}
+			}
+		}
+		VolumeFile file("test", { 32, 32, 32 }, VoxelBuffer(std::move(voxels)));
+		file.NormalizeData();
+		return OccupancyMap(MinMaxBrickGrid(file));
+	}
+
+	void UpdateOccupancy()
+	{
+		OccupancyMap map = CreateOccupancy();
+		Texture& texture = CreateTexture(WGPUTextureDimension_3D, 4, 4, 4, 1);
+		std::vector<std::byte> shadow(64);
+
+		// Classification rewrites everything
+		std::vector<float> opacity(256, 0.0f);
+		map.Classify(opacity);
+		MED_CHECK(map.GetDirtyBricks() == std::make_pair<std::size_t, std::size_t>(0, 63));
+		Writes().clear();
+		VolumeTexture::UpdateOccupancy(nullptr, texture, map);
+		MED_CHECK(WrittenBytes() == 64);
+
+		// Single brick becomes visible, one row of one grid slice is sent
+		opacity[255] = 1.0f;
+		MED_CHECK(map.Update(opacity, { 255, 255 }));
+		MED_CHECK(map.GetDirtyBricks() == std::make_pair<std::size_t, std::size_t>(57, 57));
+		Writes().clear();
+		VolumeTexture::UpdateOccupancy(nullptr, texture, map);
+		MED_CHECK(Writes().size() == 1);
+		MED_CHECK(Writes().front().Origin.y == 2 && Writes().front().Origin.z == 3);
+		MED_CHECK(Writes().front().Extent.width == 4 && Writes().front().Extent.height == 1 && Writes().front().Extent.depthOrArrayLayers == 1);
+		Apply(shadow, 4, 4, 1);
+		MED_CHECK(std::memcmp(shadow.data(), map.GetOccupancy().data(), shadow.size()) == 0);
+
+		// Edit that changes nothing uploads nothing
+		opacity[255] = 0.5f;
+		MED_CHECK(!map.Update(opacity, { 255, 255 }));
+		Writes().clear();
+		VolumeTexture::UpdateOccupancy(nullptr, texture, map);
+		MED_CHECK(Writes().empty());
+
+		// Background bricks of every slice, the whole grid slices are sent
+		opacity[0] = 1.0f;
+		MED_CHECK(map.Update(opacity, { 0, 0 }));
+		MED_CHECK(map.GetDirtyBricks() == std::make_pair<std::size_t, std::size_t>(0, 63));
+		Writes().clear();
+		VolumeTexture::UpdateOccupancy(nullptr, texture, map);
+		MED_CHECK(Writes().size() == 1 && WrittenBytes() == 64);
+		Apply(shadow, 4, 4, 1);
+		MED_CHECK(std::memcmp(shadow.data(), map.GetOccupancy().data(), shadow.size()) == 0);
+	}
+}
+
+int main()
+{
+	Texture::SetQueueWriter(MockQueueWriter);
+	return med::test::RunTests({
+		{ "TextureUpload.UpdateRegion", UpdateRegion },
+		{ "TextureUpload.UpdateTexels", UpdateTexels },
+		{ "TextureUpload.UploadSlices", UploadSlices },
+		{ "TextureUpload.UpdateDensityAndMask", UpdateDensityAndMask },
+		{ "TextureUpload.UpdateOccupancy", UpdateOccupancy },
+	});
+}
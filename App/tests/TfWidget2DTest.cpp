@@ -0,0 +1,284 @@
+#include "TestUtils.h"
+#include "tf/TfWidget2D.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace
+{
+	using namespace med;
+
+	constexpr int kDensityRes = 64;
+	constexpr int kGradientRes = 32;
+
+	std::vector<glm::vec4> Rasterize(const std::vector<TFWidget2D>& widgets)
+	{
+		std::vector<glm::vec4> lut(kDensityRes * kGradientRes, glm::vec4(-1.0f));
+		TFWidget2DRasterizer::Rasterize(widgets, kDensityRes, kGradientRes, lut);
+		return lut;
+	}
+
+	glm::vec4 Texel(const std::vector<glm::vec4>& lut, int density, int magnitude)
+	{
+		return lut[static_cast<size_t>(magnitude) * kDensityRes + density];
+	}
+
+	float Center(int texel, int resolution)
+	{
+		return (static_cast<float>(texel) + 0.5f) / resolution;
+	}
+
+	bool Near(glm::vec4 a, glm::vec4 b)
+	{
+		const glm::vec4 d = glm::abs(a - b);
+		return std::max(std::max(d.x, d.y), std::max(d.z, d.w)) <= 1e-5f;
+	}
+
+	void Empty()
+	{
+		// No widgets and invisible widgets give fully transparent black LUT
+		const auto lut = Rasterize({});
+		MED_CHECK(std::ranges::all_of(lut, [](const glm::vec4& t) { return t == glm::vec4(0.0f); }));
+
+		TFWidget2D invisible{};
+		invisible.Opacity = 0.0f;
+		const auto invisibleLut = Rasterize({ invisible });
+		MED_CHECK(std::ranges::all_of(invisibleLut, [](const glm::vec4& t) { return t == glm::vec4(0.0f); }));
+	}
+
+	void Box()
+	{
+		// Texels [16, 31] x [8, 15] have their centers inside
+		TFWidget2D box{};
+		box.Center = { 0.375f, 0.375f };
+		box.Extent = { 0.125f, 0.125f };
+		box.Color = { 1.0f, 0.5f, 0.25f };
+		box.Opacity = 0.6f;
+		const auto lut = Rasterize({ box });
+
+		int mismatches = 0;
+		for (int y = 0; y < kGradientRes; ++y)
+		{
+			for (int x = 0; x < kDensityRes; ++x)
+			{
+				const bool inside = x >= 16 && x <= 31 && y >= 8 && y <= 15;
+				const glm::vec4 expected = inside ? glm::vec4(box.Color, box.Opacity) : glm::vec4(0.0f);
+				mismatches += Near(Texel(lut, x, y), expected) ? 0 : 1;
+			}
+		}
+		MED_CHECK(mismatches == 0);
+	}
+
+	void Triangle()
+	{
+		// Apex at magnitude 0.25, base of half width 0.25 at magnitude 0.75
+		TFWidget2D triangle{};
+		triangle.Shape = TFWidget2DShape::Triangle;
+		triangle.Center = { 0.5f, 0.5f };
+		triangle.Extent = { 0.25f, 0.25f };
+		triangle.Color = { 0.0f, 1.0f, 0.0f };
+		triangle.Opacity = 1.0f;
+
+		MED_CHECK(TFWidget2DRasterizer::Evaluate(triangle, 0.5f, 0.5f) == 1.0f);
+		// Half way from the middle line to the edge
+		MED_CHECK(std::abs(TFWidget2DRasterizer::Evaluate(triangle, 0.5f + 0.0625f, 0.5f) - 0.5f) < 1e-6f);
+		MED_CHECK(TFWidget2DRasterizer::Evaluate(triangle, 0.5f + 0.13f, 0.5f) == 0.0f);
+		MED_CHECK(std::abs(TFWidget2DRasterizer::Evaluate(triangle, 0.7f, 0.75f) - 0.2f) < 1e-6f);
+		MED_CHECK(TFWidget2DRasterizer::Evaluate(triangle, 0.5f, 0.2f) == 0.0f);
+		MED_CHECK(TFWidget2DRasterizer::Evaluate(triangle, 0.5f, 0.8f) == 0.0f);
+
+		// LUT holds the widget evaluated at the texel centers
+		const auto lut = Rasterize({ triangle });
+		int mismatches = 0;
+		for (int y = 0; y < kGradientRes; ++y)
+		{
+			for (int x = 0; x < kDensityRes; ++x)
+			{
+				const float alpha = TFWidget2DRasterizer::Evaluate(triangle, Center(x, kDensityRes), Center(y, kGradientRes));
+				const glm::vec4 expected = alpha > 0.0f ? glm::vec4(triangle.Color, alpha) : glm::vec4(0.0f);
+				mismatches += Near(Texel(lut, x, y), expected) ? 0 : 1;
+			}
+		}
+		MED_CHECK(mismatches == 0);
+		// Widest row is fully opaque in the middle
+		MED_CHECK(Texel(lut, 32, 23).a > 0.9f);
+	}
+
+	void Compositing()
+	{
+		TFWidget2D red{};
+		red.Center = { 0.25f, 0.5f };
+		red.Extent = { 0.2f, 0.2f };
+		red.Color = { 1.0f, 0.0f, 0.0f };
+		red.Opacity = 0.5f;
+
+		TFWidget2D blue = red;
+		blue.Center.x = 0.5f;
+		blue.Color = { 0.0f, 0.0f, 1.0f };
+		blue.Opacity = 0.25f;
+
+		const auto lut = Rasterize({ red, blue });
+		// Only red, overlap and only blue along the middle row
+		MED_CHECK(Near(Texel(lut, 8, 16), glm::vec4(1.0f, 0.0f, 0.0f, 0.5f)));
+		MED_CHECK(Near(Texel(lut, 24, 16), glm::vec4(2.0f / 3.0f, 0.0f, 1.0f / 3.0f, 1.0f - 0.5f * 0.75f)));
+		MED_CHECK(Near(Texel(lut, 40, 16), glm::vec4(0.0f, 0.0f, 1.0f, 0.25f)));
+
+		// Result does not depend on the order of the widgets
+		const auto swapped = Rasterize({ blue, red });
+		bool same = true;
+		for (size_t i = 0; i < lut.size(); ++i)
+		{
+			same &= Near(lut[i], swapped[i]);
+		}
+		MED_CHECK(same);
+	}
+
+	void OutOfRange()
+	{
+		// Widget sticking out of [0, 1] is clipped, touching only the texels of the LUT
+		TFWidget2D corner{};
+		corner.Center = { 1.0f, 0.0f };
+		corner.Extent = { 0.3f, 0.3f };
+		corner.Opacity = 1.0f;
+		const auto lut = Rasterize({ corner });
+		MED_CHECK(Texel(lut, kDensityRes - 1, 0) == glm::vec4(1.0f));
+		MED_CHECK(Texel(lut, 0, kGradientRes - 1) == glm::vec4(0.0f));
+
+		TFWidget2D outside{};
+		outside.Center = { 2.0f, -1.0f };
+		outside.Opacity = 1.0f;
+		const auto outsideLut = Rasterize({ outside });
+		MED_CHECK(std::ranges::all_of(outsideLut, [](const glm::vec4& t) { return t == glm::vec4(0.0f); }));
+
+		MED_CHECK(TFWidget2DRasterizer::GetTexelRange(-0.5f, 0.1f, 10) == std::make_pair(0, 0));
+		MED_CHECK(TFWidget2DRasterizer::GetTexelRange(0.9f, 1.5f, 10) == std::make_pair(9, 9));
+		const auto none = TFWidget2DRasterizer::GetTexelRange(0.11f, 0.14f, 10);
+		MED_CHECK(none.first > none.second);
+	}
+
+	void PartialRows()
+	{
+		TFWidget2D widget{};
+		widget.Center = { 0.5f, 0.5f };
+		widget.Extent = { 0.4f, 0.4f };
+		widget.Opacity = 0.8f;
+
+		std::vector<glm::vec4> lut(kDensityRes * kGradientRes, glm::vec4(-1.0f));
+		TFWidget2DRasterizer::Rasterize(std::span<const TFWidget2D>(&widget, 1), kDensityRes, kGradientRes, lut, { 10, 12 });
+
+		const auto full = Rasterize({ widget });
+		bool rowsMatch = true;
+		bool othersUntouched = true;
+		for (int y = 0; y < kGradientRes; ++y)
+		{
+			for (int x = 0; x < kDensityRes; ++x)
+			{
+				if (y >= 10 && y <= 12)
+				{
+					rowsMatch &= Texel(lut, x, y) == Texel(full, x, y);
+				}
+				else
+				{
+					othersUntouched &= Texel(lut, x, y) == glm::vec4(-1.0f);
+				}
+			}
+		}
+		MED_CHECK(rowsMatch);
+		MED_CHECK(othersUntouched);
+
+		// Empty range writes nothing
+		TFWidget2DRasterizer::Rasterize(std::span<const TFWidget2D>(&widget, 1), kDensityRes, kGradientRes, lut, { 5, 4 });
+		MED_CHECK(Texel(lut, 32, 4) == glm::vec4(-1.0f) && Texel(lut, 32, 5) == glm::vec4(-1.0f));
+	}
+
+	/*
+	* Bounding box culling must not change the result, compared with the widgets evaluated at every texel.
+	*/
+	void MatchesReference()
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<TFWidget2D> widgets;
+		for (int i = 0; i < 12; ++i)
+		{
+			TFWidget2D widget{};
+			widget.Shape = i % 2 == 0 ? TFWidget2DShape::Box : TFWidget2DShape::Triangle;
+			widget.Center = { unit(random), unit(random) };
+			widget.Extent = { 0.02f + 0.3f * unit(random), 0.02f + 0.3f * unit(random) };
+			widget.Color = { unit(random), unit(random), unit(random) };
+			widget.Opacity = unit(random);
+			widgets.push_back(widget);
+		}
+		const auto lut = Rasterize(widgets);
+
+		int mismatches = 0;
+		for (int y = 0; y < kGradientRes; ++y)
+		{
+			for (int x = 0; x < kDensityRes; ++x)
+			{
+				float transparency = 1.0f;
+				float weight = 0.0f;
+				glm::vec3 color(0.0f);
+				for (const TFWidget2D& widget : widgets)
+				{
+					const float alpha = TFWidget2DRasterizer::Evaluate(widget, Center(x, kDensityRes), Center(y, kGradientRes));
+					transparency *= 1.0f - alpha;
+					weight += alpha;
+					color += alpha * widget.Color;
+				}
+				const glm::vec4 expected(weight > 0.0f ? color / weight : glm::vec3(0.0f), 1.0f - transparency);
+				mismatches += Near(Texel(lut, x, y), expected) ? 0 : 1;
+			}
+		}
+		MED_CHECK(mismatches == 0);
+	}
+
+	void ProjectOpacity()
+	{
+		TFWidget2D low{};
+		low.Center = { 0.25f, 0.1f };
+		low.Extent = { 0.1f, 0.05f };
+		low.Opacity = 0.3f;
+
+		TFWidget2D high = low;
+		high.Center = { 0.3f, 0.9f };
+		high.Opacity = 0.7f;
+
+		const auto lut = Rasterize({ low, high });
+		std::vector<float> opacity(kDensityRes, -1.0f);
+		TFWidget2DRasterizer::ProjectOpacity(lut, kDensityRes, opacity);
+
+		int mismatches = 0;
+		for (int x = 0; x < kDensityRes; ++x)
+		{
+			float expected = 0.0f;
+			for (int y = 0; y < kGradientRes; ++y)
+			{
+				expected = std::max(expected, Texel(lut, x, y).a);
+			}
+			mismatches += opacity[x] == expected ? 0 : 1;
+		}
+		MED_CHECK(mismatches == 0);
+		// Only low covers the density 0.17, both the density 0.3
+		MED_CHECK(std::abs(opacity[11] - 0.3f) < 1e-6f);
+		MED_CHECK(std::abs(opacity[19] - 0.7f) < 1e-6f);
+		MED_CHECK(opacity[kDensityRes - 1] == 0.0f);
+	}
+}
+
+int main()
+{
+	return med::test::RunTests({
+		{ "TFWidget2DRasterizer.Empty", Empty },
+		{ "TFWidget2DRasterizer.Box", Box },
+		{ "TFWidget2DRasterizer.Triangle", Triangle },
+		{ "TFWidget2DRasterizer.Compositing", Compositing },
+		{ "TFWidget2DRasterizer.OutOfRange", OutOfRange },
+		{ "TFWidget2DRasterizer.PartialRows", PartialRows },
+		{ "TFWidget2DRasterizer.MatchesReference", MatchesReference },
+		{ "TFWidget2DRasterizer.ProjectOpacity", ProjectOpacity },
+	});
+}
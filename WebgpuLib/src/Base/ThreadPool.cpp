@@ -0,0 +1,83 @@
+#include "ThreadPool.h"
+
+namespace base {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+#if !defined(PLATFORM_WEB)
+		if (threadCount == 0)
+		{
+			const uint32_t hw = std::thread::hardware_concurrency();
+			threadCount = hw > 1 ? hw - 1 : 0;
+		}
+
+		m_Workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; ++i)
+		{
+			m_Workers.emplace_back([this]() { WorkerLoop(); });
+		}
+#endif
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_Condition.notify_all();
+
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	ThreadPool& ThreadPool::Get()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::Submit(std::function<void()> task)
+	{
+		if (m_Workers.empty())
+		{
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Tasks.push(std::move(task));
+		}
+		m_Condition.notify_one();
+	}
+
+	uint32_t ThreadPool::GetConcurrency() const
+	{
+		return static_cast<uint32_t>(m_Workers.size()) + 1;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_Stop || !m_Tasks.empty(); });
+
+				if (m_Stop && m_Tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+			task();
+		}
+	}
+
+}
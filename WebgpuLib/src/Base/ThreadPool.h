@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace base {
+
+	/**
+	 * @brief Fixed size pool of worker threads for CPU heavy work (file loading, pre-processing).
+	 * On the web build there are no workers, everything runs on the calling thread.
+	 */
+	class ThreadPool
+	{
+	public:
+		/**
+		 * @param threadCount number of workers, 0 means std::thread::hardware_concurrency() - 1 (caller thread helps too)
+		 */
+		explicit ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/**
+		 * @brief Shared pool used by the application.
+		 */
+		static ThreadPool& Get();
+
+		/**
+		 * @brief Enqueues fire-and-forget task.
+		 */
+		void Submit(std::function<void()> task);
+
+		/**
+		 * @brief Calls f(i) for every i in [begin, end), blocks until all calls have finished.
+		 * Work is handed out in chunks of grainSize indices, the calling thread takes part in the work,
+		 * so nested calls from a worker cannot deadlock. First exception thrown by f is rethrown here.
+		 */
+		template<typename F>
+		void ParallelFor(std::size_t begin, std::size_t end, F&& f, std::size_t grainSize = 1);
+
+		/**
+		 * @brief Number of threads that can work at once (workers + caller).
+		 */
+		[[nodiscard]] uint32_t GetConcurrency() const;
+
+	private:
+		void WorkerLoop();
+
+	private:
+		std::vector<std::thread> m_Workers;
+		std::queue<std::function<void()>> m_Tasks;
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Stop = false;
+	};
+
+	template<typename F>
+	void ThreadPool::ParallelFor(std::size_t begin, std::size_t end, F&& f, std::size_t grainSize)
+	{
+		if (begin >= end)
+		{
+			return;
+		}
+
+		grainSize = grainSize == 0 ? 1 : grainSize;
+		const std::size_t chunkCount = (end - begin + grainSize - 1) / grainSize;
+
+		if (m_Workers.empty() || chunkCount == 1)
+		{
+			for (std::size_t i = begin; i < end; ++i)
+			{
+				f(i);
+			}
+			return;
+		}
+
+		// Shared state outlives the call, late workers only find out there is nothing left to do
+		struct State
+		{
+			std::atomic<std::size_t> NextChunk = 0;
+			std::atomic<std::size_t> DoneChunks = 0;
+			std::mutex Mutex;
+			std::condition_variable Done;
+			std::exception_ptr Error = nullptr;
+		};
+		auto state = std::make_shared<State>();
+
+		auto work = [state, begin, end, grainSize, chunkCount, &f]()
+		{
+			std::size_t chunk;
+			while ((chunk = state->NextChunk.fetch_add(1)) < chunkCount)
+			{
+				const std::size_t from = begin + chunk * grainSize;
+				const std::size_t to = std::min(from + grainSize, end);
+				try
+				{
+					for (std::size_t i = from; i < to; ++i)
+					{
+						f(i);
+					}
+				}
+				catch (...)
+				{
+					std::lock_guard lock(state->Mutex);
+					if (!state->Error)
+					{
+						state->Error = std::current_exception();
+					}
+				}
+
+				if (state->DoneChunks.fetch_add(1) + 1 == chunkCount)
+				{
+					std::lock_guard lock(state->Mutex);
+					state->Done.notify_all();
+				}
+			}
+		};
+
+		const std::size_t helpers = std::min<std::size_t>(m_Workers.size(), chunkCount - 1);
+		for (std::size_t i = 0; i < helpers; ++i)
+		{
+			// f is captured by reference, helper that starts after the caller returned won't touch it (no chunk left)
+			Submit(work);
+		}
+
+		work();
+
+		std::unique_lock lock(state->Mutex);
+		state->Done.wait(lock, [&state, chunkCount]() { return state->DoneChunks.load() == chunkCount; });
+
+		if (state->Error)
+		{
+			std::rethrow_exception(state->Error);
+		}
+	}
+
+}